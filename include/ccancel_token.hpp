@@ -0,0 +1,69 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * ccancel_token.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file ccancel_token.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _CCANCEL_TOKEN_HPP_
+#define _CCANCEL_TOKEN_HPP_
+
+#include <atomic>
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CCancelToken
+ * @brief Cooperative cancellation of a search. Any thread can cancel it, the
+ * search checks it in its loops (see CSearchContext::is_stopped). Thread safe.
+ */
+class CCancelToken
+{
+	public:
+
+		CCancelToken(): m_cancelled(false), m_parent(nullptr)
+		{
+		}
+
+		CCancelToken(const CCancelToken &original) = delete;
+		CCancelToken &operator=(const CCancelToken &original) = delete;
+
+		inline void cancel(void) { m_cancelled.store(true, std::memory_order_relaxed); }
+
+		inline void reset(void) { m_cancelled.store(false, std::memory_order_relaxed); }
+
+		/**
+		 * @param parent token which cancels this one too, nullptr for none.
+		 * It can't be changed while a search checks this token
+		 */
+		inline void set_parent(const CCancelToken *parent) { m_parent = parent; }
+
+		inline bool is_cancelled(void) const
+		{
+			return m_cancelled.load(std::memory_order_relaxed) ||
+					(m_parent && m_parent->is_cancelled());
+		}
+
+	private:
+
+		std::atomic<bool> m_cancelled;
+
+		const CCancelToken *m_parent;
+};
+
+#endif // _CCANCEL_TOKEN_HPP_
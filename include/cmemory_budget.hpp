@@ -0,0 +1,92 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * cmemory_budget.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cmemory_budget.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _CMEMORY_BUDGET_HPP_
+#define _CMEMORY_BUDGET_HPP_
+
+#include <atomic>
+#include <cstddef>
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CMemoryBudget
+ * @brief Memory used by several searches at the same time, and its limit.
+ * It's only accounting, memory is not allocated here. Thread safe.
+ */
+class CMemoryBudget
+{
+	public:
+
+		/**
+		 * @brief CMemoryBudget constructor
+		 * @param limit max bytes, 0 is unlimited
+		 */
+		explicit CMemoryBudget(size_t limit = 0): m_limit(limit), m_used(0)
+		{
+		}
+
+		CMemoryBudget(const CMemoryBudget &original) = delete;
+		CMemoryBudget &operator=(const CMemoryBudget &original) = delete;
+
+		/**
+		 * @brief Budget for all searches in this process
+		 */
+		static CMemoryBudget &process(void)
+		{
+			static CMemoryBudget process_budget;
+			return process_budget;
+		}
+
+		inline void set_limit(size_t limit) { m_limit = limit; }
+
+		inline size_t get_limit(void) const { return m_limit; }
+
+		inline size_t get_used(void) const { return m_used; }
+
+		/**
+		 * @brief Add (bytes > 0) or remove (bytes < 0) used memory
+		 * @param bytes
+		 */
+		inline void add(long bytes)
+		{
+			m_used.fetch_add(bytes, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @return true used memory is over the limit
+		 */
+		inline bool is_exceeded(void) const
+		{
+			size_t limit = m_limit.load(std::memory_order_relaxed);
+			return limit > 0 && m_used.load(std::memory_order_relaxed) > limit;
+		}
+
+	private:
+
+		std::atomic<size_t> m_limit;
+
+		std::atomic<size_t> m_used;
+};
+
+#endif // _CMEMORY_BUDGET_HPP_
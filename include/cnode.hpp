@@ -31,9 +31,15 @@
 
 #include <memory>
 
+#include "csearch_context.hpp"
+
 ////////////////////////////////////////////////////////////////////////////////
 /**
  * @class CNode
+ * @brief Search tree node. Children are generated one at a time, when the
+ * search needs them: InfoType has a children_cursor type, and beginChildrens()
+ * and static nextChildren() methods. Only two children of a node are alive
+ * at the same time, so memory grows with depth, not with fan-out
  */
 template <class InfoType> class CNode
 {
@@ -50,6 +56,14 @@ template <class InfoType> class CNode
 		 * @param index_of_children
 		 */
 		CNode( CNode<InfoType> *parent, const InfoType& info , int index_of_children);
+
+		/**
+		 * @brief CNode constructor, info is moved into node
+		 * @param parent
+		 * @param info
+		 * @param index_of_children
+		 */
+		CNode( CNode<InfoType> *parent, InfoType&& info , int index_of_children);
 		
 		/**
 		 * Copy constructor
@@ -130,6 +144,11 @@ template <class InfoType> class CNode
 			_information = x;
 		}
 
+		inline void set_information(InfoType&& x )
+		{
+			_information = std::move(x);
+		}
+
 		/**
 		 * @brief Get information data in CNode object
 		 * @return
@@ -141,19 +160,49 @@ template <class InfoType> class CNode
 		  return _information;
 		}
 
+		/**
+		 * @brief Reset node to be the root of a new search, children are
+		 * removed and information is replaced
+		 * @param info
+		 */
+		void reset(const InfoType& info)
+		{
+			m_childrens.clear();
+			set_information(info);
+			_parent = nullptr;
+			m_is_expansible = true;
+			m_is_solved = false;
+			m_out_children_index = 0;
+		}
+
 		/**
 		 * Start solution search
-		 * @param visitados
+		 * @param context visited nodes and search log
 		 * @return
 		 */
-		bool search(std::vector<InfoType>** visitados);
+		bool search(CSearchContext<InfoType> *context);
 
 		/**
-		 *
-		 * @param visitados
-		 * @return
+		 * @brief Start solution search with a search policy, chosen at compile
+		 * time (see csearch_policy.hpp). If a solution is found, it becomes
+		 * the node information
+		 * @param context visited nodes and search log
+		 * @return true solution found
 		 */
-		int generateChildrenInNode(std::vector<InfoType> **visitados);
+		template <class SearchPolicy>
+		bool search(CSearchContext<InfoType> *context)
+		{
+			m_is_solved = SearchPolicy::search(this, context);
+			return m_is_solved;
+		}
+
+		/**
+		 * @brief Start children generation, only the first two children are
+		 * built (see _next_children)
+		 * @param context
+		 * @return children count, 2 if there are two or more children
+		 */
+		int generateChildrenInNode(CSearchContext<InfoType> *context);
 
 	private:
 
@@ -171,6 +220,51 @@ template <class InfoType> class CNode
 			this->m_childrens.push(h);
 		}
 
+		/**
+		 * @brief Build next child of node
+		 * @param context
+		 * @return false there aren't more children
+		 */
+		bool _next_children(CSearchContext<InfoType> *context)
+		{
+			InfoType child;
+
+			if (!InfoType::nextChildren(&m_cursor, &child, context)) return false;
+
+			m_childrens.push_back(std::make_shared< CNode<InfoType> >(this,
+										std::move(child), m_generated_count++));
+			context->account_nodes(1, sizeof(CNode<InfoType>));
+			context->children_generated(m_childrens.size() * sizeof(CNode<InfoType>), true);
+			return true;
+		}
+
+		/**
+		 * @brief Remove all children, they mustn't have children
+		 * @param context where children memory is accounted
+		 */
+		void _clear_childrens(CSearchContext<InfoType> *context)
+		{
+			context->account_nodes(-(long)m_childrens.size(), sizeof(CNode<InfoType>));
+			m_childrens.clear();
+		}
+
+		/**
+		 * @brief Insert nogood of a failed node in visited store, nodes of its
+		 * subtree subsumed by it are removed first (see end_subtree)
+		 * @param context
+		 * @param generation returned by begin_subtree when subtree started
+		 * @param failed node information
+		 */
+		void _add_nogood(CSearchContext<InfoType> *context, unsigned long generation,
+						const InfoType &failed)
+		{
+			InfoType nogood = failed.get_nogood();
+
+			context->end_subtree(generation,
+				[&nogood](const InfoType &visited) { return visited.includes(nogood); });
+			context->add_visited(nogood.get_occupiedBoxCount(), nogood);
+		}
+
 		// TODO:
 		bool _nodosIguales( bool (*compara)(InfoType,InfoType), const CNode<InfoType>, const CNode<InfoType>) const;
 
@@ -188,12 +282,18 @@ template <class InfoType> class CNode
 
 		int m_out_children_index;
 
+		// Lazy generation of children
+		typename InfoType::children_cursor m_cursor;
+
+		int m_generated_count;
+
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 template <class InfoType>
 CNode<InfoType>::CNode():_information(), m_is_expansible(true),
-	m_is_solved(false), _parent(nullptr), m_out_children_index(0)
+	m_is_solved(false), _parent(nullptr), m_out_children_index(0),
+	m_generated_count(0)
 {
 	m_childrens.clear();
 }
@@ -211,6 +311,16 @@ CNode<InfoType>::CNode( CNode<InfoType> *parent, const InfoType& info,
 	m_is_expansible = true;
 	m_is_solved = false;
 	m_out_children_index = index_of_children;
+	m_generated_count = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <class InfoType>
+CNode<InfoType>::CNode( CNode<InfoType> *parent, InfoType&& info,
+						int index_of_children):
+	_information(std::move(info)), m_is_expansible(true), m_is_solved(false),
+	_parent(parent), m_out_children_index(index_of_children), m_generated_count(0)
+{
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -228,28 +338,37 @@ CNode<InfoType> &CNode<InfoType>::operator=(const CNode<InfoType> &original)
 	m_childrens=original.m_childrens;
 	m_is_expansible = original.m_is_expansible;
 	m_is_solved = original.m_is_solved;
+	m_cursor = original.m_cursor;
+	m_generated_count = original.m_generated_count;
 
 	return *this;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <class InfoType>
-bool CNode<InfoType>::search(std::vector<InfoType> **visitados)
+bool CNode<InfoType>::search(CSearchContext<InfoType> *context)
 {
-	int i = 0;
+	unsigned int i = 0;
 	int children_count = 0;
+	std::ostream *log = context->log();
 
 	if(this->get_informacion().isFinalCondition())
 	{
 		this->m_is_solved = true;
-		std::cout << this->get_informacion() << std::endl;
+		if (log) *log << this->get_informacion() << std::endl;
 		return true;
 	}
 
+	// Deadline reached or search cancelled, nothing is inserted in visited
+	if (context->is_stopped()) return false;
+
 	//--------------------------------------------------------------------------
 	// save initial node information
 	InfoType InformacionOriginal(this->get_informacion());
 
+	// visited nodes inserted from here belong to this subtree
+	unsigned long generation = context->begin_subtree();
+
 	//--------------------------------------------------------------------------
 	// Node treatment
 
@@ -259,7 +378,7 @@ bool CNode<InfoType>::search(std::vector<InfoType> **visitados)
 	// and continues generation children process
 	while(children_count < 2)
 	{
-		children_count = this->generateChildrenInNode(visitados);
+		children_count = this->generateChildrenInNode(context);
 		if( children_count == 0)
 		{
 			// Maybe it's the solution
@@ -270,10 +389,16 @@ bool CNode<InfoType>::search(std::vector<InfoType> **visitados)
 			}
 			else
 			{
-				// This fail node must be inserted in visited nodes with its correspond size
+				// A stopped search hasn't failed
+				if (context->is_stopped())
+				{
+					_clear_childrens(context);
+					return false;
+				}
+
+				// The nogood of this fail node must be inserted in visited nodes
+				_add_nogood(context, generation, this->get_informacion());
 				this->set_information(InformacionOriginal);
-	   			(*visitados)[this->get_informacion().get_occupiedBoxCount()].
-	   											push_back(this->get_informacion());
 				return false;
 			}
 		}
@@ -282,52 +407,73 @@ bool CNode<InfoType>::search(std::vector<InfoType> **visitados)
 		{
 			if(m_childrens[0]->get_informacion().isFinalCondition())
 			{
-				this->set_information( this->m_childrens[0]->get_informacion());
-				std::cout << this->get_informacion() << std::endl;
-				m_childrens.clear();
+				this->set_information(std::move(this->m_childrens[0]->_information));
+				if (log) *log << this->get_informacion() << std::endl;
+				_clear_childrens(context);
 				m_is_solved = true;
 				return true;
 			}
 
-			this->set_information( this->m_childrens[0]->get_informacion());
-			std::cout << this->get_informacion() << std::endl;
-			m_childrens.clear();			
+			this->set_information(std::move(this->m_childrens[0]->_information));
+			if (log) *log << this->get_informacion() << std::endl;
+			_clear_childrens(context);
 		}
 	}
 
 	// -------------------------------------------------------------------------
 	// Node has generated several children [2, x]. It starts recursive search in
 	// childrens
-	if(children_count > 1)
+	if(children_count > 1 && log)
 	{
-		std::cout <<  std::endl << std::endl << " CHILDREN COUNT: "
-				<< this->m_childrens.size() << std::endl;
-		std::cout << this->get_informacion() << std::endl << std::endl;
+		*log <<  std::endl << std::endl << " CHILDREN GENERATED ON DEMAND" << std::endl;
+		*log << this->get_informacion() << std::endl << std::endl;
 	}
 
-	auto itChildren = m_childrens.begin();
-	while (itChildren != m_childrens.end())
+	// Next child is generated when the first one has failed
+	while (!m_childrens.empty() || _next_children(context))
 	{
+		auto itChildren = m_childrens.begin();
+
 		// When a children return false in its search, this children will be deleted
-		if (!((*itChildren)->search(visitados)))
+		if (!((*itChildren)->search(context)))
 		{
-			itChildren = m_childrens.erase(itChildren);
+			m_childrens.erase(itChildren);
+			context->account_nodes(-1, sizeof(CNode<InfoType>));
+
+			// Child generated ahead is freed too, its subtree isn't in tree
+			if (context->is_stopped())
+			{
+				_clear_childrens(context);
+				return false;
+			}
+
+			// Backjump: child nogood doesn't depend on its own decision, so
+			// this node fails too, and remaining children aren't searched
+			if (this->get_informacion().includes(context->get_last_visited()))
+			{
+				context->backjump();
+				context->trace(E_SEARCH_TRACE_BACKJUMP,
+								this->get_informacion().get_occupiedBoxCount());
+				_clear_childrens(context);
+				this->set_information(InformacionOriginal);
+				return false;
+			}
 		}
 		else
 		{
 			//itChildren++;
-			this->set_information((*itChildren)->get_informacion());
-			m_childrens.clear();
+			this->set_information(std::move((*itChildren)->_information));
+			_clear_childrens(context);
 			m_is_solved = true;
 			return true;
 		}
 	}
 
 	// At this point, probably I have a unsolvable sudoku
-	for(i = 0; i < 80; i++)
+	for(i = 0; log && i < context->get_visited_levels(); i++)
 	{
-		std::cout << " Visited nodes (" << i << ") without success: "
-					<< (*visitados)[i].size() << std::endl;
+		*log << " Visited nodes (" << i << ") without success: "
+					<< context->get_visited_count(i) << std::endl;
 	}
 
 	//--------------------------------------------------------------------------
@@ -335,14 +481,19 @@ bool CNode<InfoType>::search(std::vector<InfoType> **visitados)
 	// return false;
 	if(m_childrens.empty())
 	{
+		// Every child is already freed, a stopped search hasn't failed
+		if (context->is_stopped()) return false;
+
 	    this->set_information(InformacionOriginal);
 	    
-		std::cout << " DELETED "<<  std::endl;
-		std::cout << this->get_informacion() << std::endl;
+		if (log)
+		{
+			*log << " DELETED "<<  std::endl;
+			*log << this->get_informacion() << std::endl;
+		}
 	    
-		(*visitados)[this->get_informacion().get_occupiedBoxCount()].
-											push_back(this->get_informacion());
-		return false;			 
+		_add_nogood(context, generation, this->get_informacion());
+		return false;
 	}
 	else
 	{
@@ -352,27 +503,21 @@ bool CNode<InfoType>::search(std::vector<InfoType> **visitados)
 
 ////////////////////////////////////////////////////////////////////////////////
 template <class InfoType>
-int CNode<InfoType>::generateChildrenInNode(std::vector<InfoType> **visitados)
+int CNode<InfoType>::generateChildrenInNode(CSearchContext<InfoType> *context)
 {
-	std::vector<InfoType> solutions;
-	solutions.clear();
-
-	if (!this->get_informacion().generateChildrens(&solutions, visitados))
+	context->node_expanded();
+	context->update_best(this->get_informacion());
+	if (!this->get_informacion().beginChildrens(&m_cursor, context))
 	{
 		// std::cout << "Solution" << std::endl;
 		return 0;
 	}
 
-	this->m_childrens.clear();
+	_clear_childrens(context);
+	m_generated_count = 0;
 
-	unsigned int i = 0;
-	for (const auto& itBoardolutions : solutions)
-	{
-		std::shared_ptr<CNode<InfoType> >
-					shr_ptr(new CNode<InfoType>(this, itBoardolutions, i));
-		this->m_childrens.push_back(shr_ptr);
-		i++;
-	}
+	// Two children are enough to know if node branches
+	while (m_childrens.size() < 2 && _next_children(context));
 
 	return m_childrens.size();
 }
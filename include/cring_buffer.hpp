@@ -0,0 +1,215 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * cring_buffer.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cring_buffer.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _CRING_BUFFER_HPP_
+#define _CRING_BUFFER_HPP_
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CRingBuffer
+ * @brief Bounded lock-free queue for several producers and several consumers
+ * (D. Vyukov algorithm). Every cell has a sequence number that says if it is
+ * ready to be written or to be read, so producers and consumers only compete
+ * for their position counter. Capacity is rounded up to a power of 2.
+ * push() and pop() wait while queue is full or empty, so a full queue stops
+ * its producers (backpressure).
+ */
+template <class T> class CRingBuffer
+{
+	public:
+
+		/**
+		 * @brief CRingBuffer constructor
+		 * @param capacity max number of elements in queue
+		 */
+		explicit CRingBuffer(size_t capacity);
+
+		CRingBuffer(const CRingBuffer<T> &original) = delete;
+		CRingBuffer<T> &operator=(const CRingBuffer<T> &original) = delete;
+
+		virtual ~CRingBuffer(){};
+
+		/**
+		 * @brief Insert value in queue without waiting
+		 * @param value
+		 * @return false queue is full
+		 */
+		bool try_push(const T &value);
+
+		/**
+		 * @brief Extract value from queue without waiting
+		 * @param value
+		 * @return false queue is empty
+		 */
+		bool try_pop(T &value);
+
+		/**
+		 * @brief Insert value in queue, waiting while queue is full
+		 * @param value
+		 */
+		void push(const T &value)
+		{
+			for (unsigned int tries = 0; !try_push(value); tries++) _backoff(tries);
+		}
+
+		/**
+		 * @brief Extract value from queue, waiting while queue is empty
+		 * @param value
+		 */
+		void pop(T &value)
+		{
+			for (unsigned int tries = 0; !try_pop(value); tries++) _backoff(tries);
+		}
+
+		inline size_t get_capacity(void) const { return m_mask + 1; }
+
+	private:
+
+		struct SCell
+		{
+			std::atomic<size_t> sequence;
+			T data;
+		};
+
+		/**
+		 * @brief Wait a little before trying again: first spinning, then
+		 * yielding processor and at last sleeping
+		 * @param tries
+		 */
+		static void _backoff(unsigned int tries)
+		{
+			if (tries < 64) return;
+			if (tries < 128) { std::this_thread::yield(); return; }
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+
+		std::unique_ptr<SCell[]> m_cells;
+
+		size_t m_mask;
+
+		// Each counter in its own cache line
+		alignas(64) std::atomic<size_t> m_enqueue_pos;
+
+		alignas(64) std::atomic<size_t> m_dequeue_pos;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+template <class T>
+CRingBuffer<T>::CRingBuffer(size_t capacity): m_mask(0), m_enqueue_pos(0),
+	m_dequeue_pos(0)
+{
+	size_t size = 2;
+	while (size < capacity) size <<= 1;
+
+	m_cells.reset(new SCell[size]);
+	m_mask = size - 1;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <class T>
+bool CRingBuffer<T>::try_push(const T &value)
+{
+	SCell *cell = nullptr;
+	size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+
+	while (true)
+	{
+		cell = &m_cells[pos & m_mask];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+		if (diff == 0)
+		{
+			if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1,
+											std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			// Queue is full
+			return false;
+		}
+		else
+		{
+			pos = m_enqueue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	cell->data = value;
+	cell->sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <class T>
+bool CRingBuffer<T>::try_pop(T &value)
+{
+	SCell *cell = nullptr;
+	size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+
+	while (true)
+	{
+		cell = &m_cells[pos & m_mask];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+		if (diff == 0)
+		{
+			if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1,
+											std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			// Queue is empty
+			return false;
+		}
+		else
+		{
+			pos = m_dequeue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	value = cell->data;
+	cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+	return true;
+}
+
+#endif // _CRING_BUFFER_HPP_
@@ -0,0 +1,837 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * csearch_context.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file csearch_context.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _CSEARCH_CONTEXT_HPP_
+#define _CSEARCH_CONTEXT_HPP_
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "cmemory_budget.hpp"
+#include "ccancel_token.hpp"
+#include "csearch_trace.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Search statistics, they are reset by CSearchContext::clear()
+ */
+struct SSearchStatistics
+{
+	long expanded_nodes;		/**< Nodes whose children were generated */
+	long live_nodes;			/**< Nodes in tree now */
+	long visited_count;			/**< Nodes in visited store now */
+	long visited_dropped;		/**< Visited nodes removed by memory budget */
+	long bounded_expansions;	/**< Expansions limited by memory budget */
+	long visited_lookups;		/**< Boards checked against visited store */
+	long visited_hits;			/**< Boards pruned by visited store */
+	long visited_evicted;		/**< Visited nodes removed by eviction policy */
+	long backjumps;				/**< Nodes abandoned because they include a nogood */
+	bool stopped;				/**< Search stopped by deadline or cancel token */
+	bool gave_up;				/**< Incomplete search (beam) dropped nodes, its
+									 failure doesn't prove there isn't solution */
+
+	// Memory by component, in bytes accounted by CSearchContext
+	long peak_live_nodes;		/**< Max nodes in tree at the same time (tree width) */
+	long tree_bytes;			/**< Nodes in tree now */
+	long peak_tree_bytes;
+	long visited_bytes;			/**< Nodes in visited store now */
+	long peak_visited_bytes;
+	long peak_children_bytes;	/**< Most generated children of one node waiting
+									 to be searched */
+	long peak_bytes;			/**< Max of tree, visited store and children together */
+
+	SSearchStatistics(): expanded_nodes(0), live_nodes(0), visited_count(0), visited_dropped(0),
+		bounded_expansions(0), visited_lookups(0), visited_hits(0), visited_evicted(0),
+		backjumps(0), stopped(false), gave_up(false), peak_live_nodes(0), tree_bytes(0),
+		peak_tree_bytes(0), visited_bytes(0), peak_visited_bytes(0),
+		peak_children_bytes(0), peak_bytes(0)
+	{
+	}
+
+	/**
+	 * @return bytes of tree and visited store now
+	 */
+	inline long live_bytes(void) const { return tree_bytes + visited_bytes; }
+
+	/**
+	 * @return fraction of lookups pruned by visited store, 0 without lookups
+	 */
+	inline double visited_hit_rate(void) const
+	{
+		return visited_lookups > 0 ? (double)visited_hits / visited_lookups : 0.0;
+	}
+
+	/**
+	 * @return true search failed without exploring every node (stopped or
+	 * gave up), its best board is only a partial result
+	 */
+	inline bool is_partial(void) const { return stopped || gave_up; }
+
+	/**
+	 * @return true memory budget was reached in this search
+	 */
+	inline bool is_degraded(void) const
+	{
+		return visited_dropped > 0 || bounded_expansions > 0;
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Branching fan-out of expansions without safe children: children are
+ * generated for the boxes with [min_values, max_values) possible values
+ * (boxes with more values only if there isn't any of them), less possible
+ * values first, and at most max_boxes of them. Adaptive branching narrows
+ * it during the search, see CSearchContext::get_fan_out
+ */
+struct SSearchBranching
+{
+	unsigned int min_values;	/**< Min possible values of a branching box */
+	unsigned int max_values;	/**< Branching boxes have less possible values */
+	unsigned int max_boxes;		/**< Max branching boxes of an expansion, 0 all */
+	double failure_rate;		/**< Adaptive if > 0: recent failed nodes by
+									 expansion where fan-out is one box. Fixed
+									 (0) by default */
+
+	SSearchBranching(): min_values(2), max_values(8), max_boxes(0), failure_rate(0)
+	{
+	}
+
+	inline bool is_adaptive(void) const { return failure_rate > 0; }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Which visited nodes are removed when visited store is full
+ */
+enum E_VISITED_EVICTION
+{
+	/** When a failed subtree is inserted in visited store, the nodes failed
+	 * inside it which include its nogood are removed: they can't prune
+	 * anything that it doesn't prune. When full, like DEPTH */
+	E_VISITED_EVICTION_SUBTREE = 0,
+	/** When full, a node not inserted or hit for long time is removed
+	 * (approximate LRU, with a clock hand) */
+	E_VISITED_EVICTION_LRU,
+	/** When full, the newest node of the deepest level is removed */
+	E_VISITED_EVICTION_DEPTH
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CChildrenOrder
+ * @brief Order in which children of an expansion are explored. Children are
+ * generated one at a time (see CNode), so values tried in a box are sorted
+ * before any child is built. InfoType children generation calls it, if there
+ * is one in context. It's kept between searches, so it can learn from earlier
+ * searches
+ */
+template <class InfoType> class CChildrenOrder
+{
+	public:
+
+		virtual ~CChildrenOrder(){};
+
+		/**
+		 * @brief Sort values tried in a box of parent, the child with the
+		 * first value is explored first
+		 * @param parent
+		 * @param box
+		 * @param values possible values of box
+		 * @param count
+		 */
+		virtual void order(const InfoType &parent, int box, short int *values, int count) = 0;
+
+		/**
+		 * @brief A failed node was inserted in visited store
+		 * @param nogood
+		 */
+		virtual void failed(const InfoType &nogood) {};
+
+		/**
+		 * @brief A search found a solution
+		 * @param solution
+		 */
+		virtual void solved(const InfoType &solution) {};
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSearchContext
+ * @brief State shared by every node of one search tree: the visited (failed)
+ * nodes store and the stream where the search progress is written.
+ * A context can be reused between searches, clear() keeps the allocated
+ * memory of the visited store.
+ *
+ * Memory of live nodes and visited nodes is accounted in this search and in
+ * the process budget (see CMemoryBudget::process). When any limit is
+ * reached, deepest visited levels are removed first, they are the less useful
+ * ones to prune the tree, and then new expansions must be bounded (see
+ * is_memory_exceeded).
+ *
+ * Visited store can also be bounded by a number of nodes, see
+ * set_visited_capacity and E_VISITED_EVICTION. Every visited node is stamped
+ * with its insertion generation, so nodes inserted inside a subtree can be
+ * found (see begin_subtree and end_subtree).
+ *
+ * A search can be stopped by a deadline or by a cancel token from another
+ * thread, search loops must check is_stopped. Children order (see
+ * CChildrenOrder) and branching fan-out (see SSearchBranching) are kept by
+ * clear(), like them. The deepest node seen (see update_best) is kept as the
+ * best partial result of a stopped search.
+ *
+ * Search events can be recorded in a trace (see set_trace and CSearchTrace),
+ * without a trace every event costs one test.
+ */
+template <class InfoType> class CSearchContext
+{
+	public:
+		/**
+		 * @brief CSearchContext constructor
+		 * @param visited_levels number of visited vectors, one for each
+		 * occupied box count
+		 * @param log stream for search progress, nullptr for a silent search
+		 */
+		CSearchContext(unsigned int visited_levels, std::ostream *log = &std::cout):
+			m_visitados(visited_levels), m_log(log), m_memory_limit(0),
+			m_memory_used(0), m_memory_unreported(0),
+			m_process_budget(&CMemoryBudget::process()), m_bounded_branching(false),
+			m_visited_capacity(0), m_eviction(E_VISITED_EVICTION_SUBTREE),
+			m_generation(0), m_hand_level(0), m_hand_index(0), m_cancel(nullptr), m_has_deadline(false),
+			m_stop_checks(0), m_best_count(-1), m_children_order(nullptr),
+			m_trace(nullptr), m_failure_rate(0)
+		{
+		}
+
+		virtual ~CSearchContext()
+		{
+			_report_memory(-(long)m_memory_used);
+		}
+
+		/**
+		 * @brief Remove all visited nodes, vectors capacity is kept.
+		 * Statistics, memory accounting and best node are reset. Deadline and
+		 * cancel token are kept
+		 */
+		void clear(void)
+		{
+			for (auto &level : m_visitados) level.clear();
+
+			_report_memory(-(long)m_memory_used);
+			m_memory_used = 0;
+			m_statistics = SSearchStatistics();
+			m_generation = 0;
+			m_hand_level = 0;
+			m_hand_index = 0;
+			m_stop_checks = 0;
+			m_best_count = -1;
+			m_last_visited = InfoType();
+			m_failure_rate = 0;
+		}
+
+		/**
+		 * @brief Start a new search keeping visited store, only valid if
+		 * every visited node is still a failed node in the new search (as
+		 * nogoods of a board with more values). Statistics and best node are
+		 * reset, like in clear()
+		 */
+		void restart(void)
+		{
+			long visited_count = m_statistics.visited_count;
+			long visited_bytes = m_statistics.visited_bytes;
+
+			m_statistics = SSearchStatistics();
+			m_statistics.visited_count = visited_count;
+			m_statistics.visited_bytes = visited_bytes;
+			m_statistics.peak_visited_bytes = visited_bytes;
+			m_statistics.peak_bytes = visited_bytes;
+			m_stop_checks = 0;
+			m_best_count = -1;
+			m_failure_rate = 0;
+		}
+
+		/**
+		 * @return number of visited nodes with occupied box count equal to level
+		 */
+		inline size_t get_visited_count(unsigned int level) const
+		{
+			return m_visitados[level].size();
+		}
+
+		/**
+		 * @brief Look for a visited node in levels [0, max_level) which
+		 * matches. Hit statistics are updated and the matched node becomes the
+		 * most recently used
+		 * @param max_level first level not checked
+		 * @param matches predicate bool(const InfoType &visited)
+		 * @return true any visited node matches
+		 */
+		template <class Predicate>
+		bool find_visited(unsigned int max_level, Predicate matches)
+		{
+			m_statistics.visited_lookups++;
+			if (m_statistics.visited_count == 0) return false;
+
+			if (max_level > m_visitados.size()) max_level = m_visitados.size();
+			for (unsigned int level = 0; level < max_level; level++)
+			{
+				for (auto &visited : m_visitados[level])
+				{
+					if (matches(visited.info))
+					{
+						visited.referenced = true;
+						m_statistics.visited_hits++;
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		/**
+		 * @brief Insert failed node in visited store
+		 * @param level occupied box count of info
+		 * @param info
+		 */
+		void add_visited(unsigned int level, const InfoType &info)
+		{
+			m_visitados[level].push_back(SVisited(info, m_generation++));
+			m_last_visited = info;
+			m_failure_rate += 1.0 / FAILURE_WINDOW;
+			if (m_children_order) m_children_order->failed(info);
+			trace(E_SEARCH_TRACE_NOGOOD, level);
+			m_statistics.visited_count++;
+			_account_component(&m_statistics.visited_bytes,
+								&m_statistics.peak_visited_bytes, sizeof(SVisited));
+
+			if (m_visited_capacity > 0 &&
+				(size_t)m_statistics.visited_count > m_visited_capacity)
+			{
+				_evict_visited();
+			}
+			if (is_memory_exceeded()) _drop_visited();
+		}
+
+		/**
+		 * @return last node inserted in visited store, it's kept even if it
+		 * was removed from store later
+		 */
+		inline const InfoType &get_last_visited(void) const { return m_last_visited; }
+
+		/**
+		 * @brief Mark the start of a subtree search
+		 * @return generation to pass to end_subtree
+		 */
+		inline unsigned long begin_subtree(void) const { return m_generation; }
+
+		/**
+		 * @brief Subtree started in generation has failed. With SUBTREE
+		 * eviction, nodes inserted since then which are subsumed by subtree
+		 * nogood are removed. It must be called before inserting subtree
+		 * nogood in visited store
+		 * @param generation returned by begin_subtree
+		 * @param subsumed predicate bool(const InfoType &visited)
+		 */
+		template <class Predicate>
+		void end_subtree(unsigned long generation, Predicate subsumed)
+		{
+			if (m_eviction != E_VISITED_EVICTION_SUBTREE ||
+				generation == m_generation) return;
+
+			// Generations grow inside every level, newest nodes are at the end
+			for (auto &level : m_visitados)
+			{
+				auto first = level.end();
+				while (first != level.begin() && (first - 1)->generation >= generation)
+				{
+					first--;
+				}
+
+				size_t size = level.size();
+				level.erase(std::remove_if(first, level.end(),
+					[&subsumed](const SVisited &visited) { return subsumed(visited.info); }),
+					level.end());
+				_remove_visited(size - level.size(), &m_statistics.visited_evicted);
+			}
+		}
+
+		/**
+		 * @param capacity max visited nodes, 0 is unlimited
+		 */
+		inline void set_visited_capacity(size_t capacity) { m_visited_capacity = capacity; }
+
+		inline size_t get_visited_capacity(void) const { return m_visited_capacity; }
+
+		inline void set_visited_eviction(E_VISITED_EVICTION eviction) { m_eviction = eviction; }
+
+		inline E_VISITED_EVICTION get_visited_eviction(void) const { return m_eviction; }
+
+		/**
+		 * @brief Search must stop when deadline is reached
+		 * @param deadline
+		 */
+		inline void set_deadline(const std::chrono::steady_clock::time_point &deadline)
+		{
+			m_deadline = deadline;
+			m_deadline_set = std::chrono::steady_clock::now();
+			m_has_deadline = true;
+		}
+
+		inline void clear_deadline(void) { m_has_deadline = false; }
+
+		/**
+		 * @param cancel token checked by is_stopped, nullptr for none
+		 */
+		inline void set_cancel_token(const CCancelToken *cancel) { m_cancel = cancel; }
+
+		/**
+		 * @brief Check if search must stop. It's called in every search loop,
+		 * so the clock is only read once every STOP_CLOCK_PERIOD calls. When
+		 * it returns true, it keeps returning true until clear()
+		 * @return true deadline was reached or search was cancelled
+		 */
+		inline bool is_stopped(void)
+		{
+			if (!m_statistics.stopped &&
+				((m_cancel && m_cancel->is_cancelled()) ||
+				(m_has_deadline && ++m_stop_checks % STOP_CLOCK_PERIOD == 0 &&
+				std::chrono::steady_clock::now() >= m_deadline)))
+			{
+				m_statistics.stopped = true;
+			}
+			return m_statistics.stopped;
+		}
+
+		/**
+		 * @param order children order, nullptr for generation order
+		 */
+		inline void set_children_order(CChildrenOrder<InfoType> *order)
+		{
+			m_children_order = order;
+		}
+
+		inline CChildrenOrder<InfoType> *get_children_order(void) const
+		{
+			return m_children_order;
+		}
+
+		/**
+		 * @param trace where search events are recorded, nullptr for none.
+		 * It isn't started here (see CSearchTrace::start)
+		 */
+		inline void set_trace(CSearchTrace *trace) { m_trace = trace; }
+
+		inline CSearchTrace *get_trace(void) const { return m_trace; }
+
+		/**
+		 * @brief Record a search event, if there is a trace
+		 * @param type
+		 * @param depth
+		 * @param box
+		 * @param value
+		 */
+		inline void trace(E_SEARCH_TRACE_EVENT type, int depth, int box = -1,
+						int value = 0)
+		{
+			if (m_trace) m_trace->record(type, depth, box, value);
+		}
+
+		/**
+		 * @brief Keep info if it's the deepest node seen in this search
+		 * @param info
+		 */
+		inline void update_best(const InfoType &info)
+		{
+			if (info.get_occupiedBoxCount() > m_best_count)
+			{
+				m_best = info;
+				m_best_count = info.get_occupiedBoxCount();
+			}
+		}
+
+		/**
+		 * @return true any node was passed to update_best since clear()
+		 */
+		inline bool has_best(void) const { return m_best_count >= 0; }
+
+		/**
+		 * @return deepest node seen, only valid if has_best()
+		 */
+		inline const InfoType &get_best(void) const { return m_best; }
+
+		/**
+		 * @brief Account nodes created (count > 0) or destroyed (count < 0)
+		 * @param count
+		 * @param node_size
+		 */
+		inline void account_nodes(long count, size_t node_size)
+		{
+			m_statistics.live_nodes += count;
+			if (m_statistics.live_nodes > m_statistics.peak_live_nodes)
+			{
+				m_statistics.peak_live_nodes = m_statistics.live_nodes;
+			}
+			_account_component(&m_statistics.tree_bytes, &m_statistics.peak_tree_bytes,
+								count * (long)node_size);
+		}
+
+		/**
+		 * @brief Notify generated children of a node waiting to be searched:
+		 * a temporary vector, alive at the same time as the tree, or nodes
+		 * already in tree (lazy generation of CNode). It isn't accounted in
+		 * memory budget, only its peak is kept
+		 * @param bytes
+		 * @param in_tree children are tree nodes, their bytes are already in
+		 * tree bytes
+		 */
+		inline void children_generated(size_t bytes, bool in_tree = false)
+		{
+			if ((long)bytes > m_statistics.peak_children_bytes)
+			{
+				m_statistics.peak_children_bytes = bytes;
+			}
+			if (!in_tree && m_statistics.live_bytes() + (long)bytes > m_statistics.peak_bytes)
+			{
+				m_statistics.peak_bytes = m_statistics.live_bytes() + bytes;
+			}
+		}
+
+		/**
+		 * @brief New expansions should be bounded while it returns true
+		 * @return true search or process memory limit is reached
+		 */
+		inline bool is_memory_exceeded(void) const
+		{
+			return (m_memory_limit > 0 && m_memory_used > m_memory_limit) ||
+					m_process_budget->is_exceeded();
+		}
+
+		/**
+		 * @brief Notify a node expansion
+		 */
+		inline void node_expanded(void)
+		{
+			m_statistics.expanded_nodes++;
+			m_failure_rate -= m_failure_rate / FAILURE_WINDOW;
+		}
+
+		/**
+		 * @brief Notify an expansion limited by memory budget
+		 */
+		inline void bounded_expansion(void) { m_statistics.bounded_expansions++; }
+
+		/**
+		 * @brief Notify nodes dropped by an incomplete search policy
+		 */
+		inline void search_gave_up(void) { m_statistics.gave_up = true; }
+
+		/**
+		 * @brief Notify a node abandoned because it includes a nogood
+		 */
+		inline void backjump(void) { m_statistics.backjumps++; }
+
+		/**
+		 * @brief Bounded branching: every expansion is bounded as if memory
+		 * budget were reached. Search policies that need a small branching
+		 * factor use it
+		 * @param bounded
+		 */
+		inline void set_bounded_branching(bool bounded) { m_bounded_branching = bounded; }
+
+		inline bool get_bounded_branching(void) const { return m_bounded_branching; }
+
+		/**
+		 * @param branching fan-out of expansions
+		 */
+		inline void set_branching(const SSearchBranching &branching) { m_branching = branching; }
+
+		inline const SSearchBranching &get_branching(void) const { return m_branching; }
+
+		/**
+		 * @brief Branching boxes of an expansion. Adaptive branching narrows
+		 * fan-out when recent expansions fail (near to failure_rate of
+		 * branching, a wide fan-out only adds siblings which fail too), when
+		 * more than half of memory or time budget is used, and in shallow
+		 * nodes, whose children are roots of bigger subtrees
+		 * @param boxes candidate branching boxes
+		 * @param depth occupied box count of expanded node
+		 * @return branching boxes, [1, boxes]
+		 */
+		unsigned int get_fan_out(unsigned int boxes, unsigned int depth)
+		{
+			if (m_branching.max_boxes > 0 && boxes > m_branching.max_boxes)
+			{
+				boxes = m_branching.max_boxes;
+			}
+			if (!m_branching.is_adaptive() || boxes <= 1) return boxes;
+
+			double scale = 1.0 - m_failure_rate / m_branching.failure_rate;
+
+			double used = 0.0;
+			if (m_memory_limit > 0) used = (double)m_memory_used / m_memory_limit;
+			if (m_has_deadline && m_deadline > m_deadline_set)
+			{
+				auto now = std::chrono::steady_clock::now();
+				used = std::max(used, std::chrono::duration<double>(now - m_deadline_set) /
+										(m_deadline - m_deadline_set));
+			}
+			if (used > 0.5) scale *= 2.0 * (1.0 - used);
+
+			scale *= (double)depth / m_visitados.size();
+
+			if (scale <= 0.0) return 1;
+			return std::max(1u, (unsigned int)std::ceil(boxes * scale));
+		}
+
+		/**
+		 * @param limit max bytes for this search, 0 is unlimited
+		 */
+		inline void set_memory_limit(size_t limit) { m_memory_limit = limit; }
+
+		inline size_t get_memory_limit(void) const { return m_memory_limit; }
+
+		/**
+		 * @return bytes used by live nodes and visited nodes
+		 */
+		inline size_t get_memory_used(void) const { return m_memory_used; }
+
+		inline const SSearchStatistics &get_statistics(void) const
+		{
+			return m_statistics;
+		}
+
+		/**
+		 * @return number of visited levels
+		 */
+		inline unsigned int get_visited_levels(void) const
+		{
+			return m_visitados.size();
+		}
+
+		/**
+		 * @return stream for search progress or nullptr if search is silent
+		 */
+		inline std::ostream *log(void) const { return m_log; }
+
+		inline void set_log(std::ostream *log) { m_log = log; }
+
+	private:
+
+		struct SVisited
+		{
+			InfoType info;
+			unsigned long generation;	// insertion order
+			bool referenced;			// inserted or hit since clock hand passed
+
+			SVisited(const InfoType &visited, unsigned long gen):
+				info(visited), generation(gen), referenced(true)
+			{
+			}
+		};
+
+		// Process budget is updated in blocks, not for every node
+		static const long PROCESS_REPORT_BLOCK = 64 * 1024;
+
+		// Deadline is checked once every STOP_CLOCK_PERIOD calls to is_stopped
+		static const unsigned int STOP_CLOCK_PERIOD = 64;
+
+		// Failure rate is a moving average of about the last FAILURE_WINDOW
+		// expansions
+		static const unsigned int FAILURE_WINDOW = 64;
+
+		/**
+		 * @brief Account bytes of one component (tree or visited store)
+		 * @param component bytes of component now
+		 * @param peak max bytes of component
+		 * @param bytes
+		 */
+		inline void _account_component(long *component, long *peak, long bytes)
+		{
+			*component += bytes;
+			if (*component > *peak) *peak = *component;
+			if (m_statistics.live_bytes() > m_statistics.peak_bytes)
+			{
+				m_statistics.peak_bytes = m_statistics.live_bytes();
+			}
+			_account(bytes);
+		}
+
+		inline void _account(long bytes)
+		{
+			m_memory_used += bytes;
+			m_memory_unreported += bytes;
+			if (m_memory_unreported > PROCESS_REPORT_BLOCK ||
+				m_memory_unreported < -PROCESS_REPORT_BLOCK)
+			{
+				_report_memory(0);
+			}
+		}
+
+		void _report_memory(long bytes)
+		{
+			m_process_budget->add(m_memory_unreported + bytes);
+			m_memory_unreported = 0;
+		}
+
+		/**
+		 * @brief Remove visited levels, from the deepest one, until memory
+		 * used is under 3/4 of search limit. If it's process limit which is
+		 * exceeded, memory of this search is reduced to half.
+		 */
+		void _drop_visited(void)
+		{
+			size_t target = m_memory_used / 2;
+			if (m_memory_limit > 0 && m_memory_used > m_memory_limit)
+			{
+				target = m_memory_limit / 4 * 3;
+			}
+
+			for (unsigned int level = m_visitados.size();
+				level > 0 && m_memory_used > target; level--)
+			{
+				std::vector<SVisited> &dropped = m_visitados[level - 1];
+				if (dropped.empty()) continue;
+
+				_remove_visited(dropped.size(), &m_statistics.visited_dropped);
+				std::vector<SVisited>().swap(dropped);
+			}
+		}
+
+		/**
+		 * @brief Remove one visited node, chosen by eviction policy.
+		 * LRU is approximated with a clock hand which goes round the store:
+		 * nodes inserted or hit since it passed get a second chance, the first
+		 * other node is removed. Every referenced mark is cleared once, so it's
+		 * O(1) amortized. Removed node is replaced by the last one of its level,
+		 * generation order inside levels is only needed by SUBTREE eviction
+		 */
+		void _evict_visited(void)
+		{
+			if (m_eviction == E_VISITED_EVICTION_LRU)
+			{
+				while (m_statistics.visited_count > 0)
+				{
+					std::vector<SVisited> &level = m_visitados[m_hand_level];
+					if (m_hand_index >= level.size())
+					{
+						m_hand_level = (m_hand_level + 1) % m_visitados.size();
+						m_hand_index = 0;
+						continue;
+					}
+
+					SVisited &visited = level[m_hand_index];
+					if (visited.referenced)
+					{
+						visited.referenced = false;
+						m_hand_index++;
+						continue;
+					}
+
+					if (&visited != &level.back()) visited = std::move(level.back());
+					level.pop_back();
+					_remove_visited(1, &m_statistics.visited_evicted);
+					return;
+				}
+				return;
+			}
+
+			for (unsigned int level = m_visitados.size(); level > 0; level--)
+			{
+				if (m_visitados[level - 1].empty()) continue;
+
+				m_visitados[level - 1].pop_back();
+				_remove_visited(1, &m_statistics.visited_evicted);
+				return;
+			}
+		}
+
+		/**
+		 * @brief Account visited nodes removed from store
+		 * @param count
+		 * @param counter statistic where they are added
+		 */
+		inline void _remove_visited(size_t count, long *counter)
+		{
+			m_statistics.visited_count -= count;
+			*counter += count;
+			_account_component(&m_statistics.visited_bytes,
+								&m_statistics.peak_visited_bytes,
+								-(long)(count * sizeof(SVisited)));
+		}
+
+		std::vector< std::vector<SVisited> > m_visitados;
+
+		std::ostream *m_log;
+
+		size_t m_memory_limit;
+
+		size_t m_memory_used;
+
+		long m_memory_unreported;
+
+		CMemoryBudget *m_process_budget;
+
+		SSearchStatistics m_statistics;
+
+		bool m_bounded_branching;
+
+		SSearchBranching m_branching;
+
+		size_t m_visited_capacity;
+
+		E_VISITED_EVICTION m_eviction;
+
+		unsigned long m_generation;
+
+		unsigned int m_hand_level;	// Clock hand of LRU eviction
+
+		size_t m_hand_index;
+
+		const CCancelToken *m_cancel;
+
+		bool m_has_deadline;
+
+		std::chrono::steady_clock::time_point m_deadline;
+
+		std::chrono::steady_clock::time_point m_deadline_set;	// When deadline was set
+
+		unsigned int m_stop_checks;
+
+		InfoType m_best;
+
+		int m_best_count;
+
+		InfoType m_last_visited;
+
+		CChildrenOrder<InfoType> *m_children_order;
+
+		CSearchTrace *m_trace;
+
+		double m_failure_rate;	// Failed nodes by expansion, moving average
+};
+
+#endif // _CSEARCH_CONTEXT_HPP_
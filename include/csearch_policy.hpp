@@ -0,0 +1,364 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * csearch_policy.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file csearch_policy.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * Search policies for CNode::search<SearchPolicy>(). A policy is a class with
+ * a static method:
+ *
+ *   template <class InfoType>
+ *   static bool search(CNode<InfoType> *root, CSearchContext<InfoType> *context);
+ *
+ * that sets root information to the solution if it's found. InfoType must
+ * have isFinalCondition(), get_occupiedBoxCount(), generateChildrens(),
+ * get_heuristic() (lower is better), get_nogood() and includes(). Policies
+ * keep their frontier as InfoType values, not as CNode trees, and nogoods of
+ * dead ends are inserted in visited store.
+ * Policies return false as soon as CSearchContext::is_stopped() is true.
+ * Incomplete policies call CSearchContext::search_gave_up() when they drop
+ * nodes, so their failure isn't taken as a board without solution.
+ */
+
+#ifndef _CSEARCH_POLICY_HPP_
+#define _CSEARCH_POLICY_HPP_
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#include "cnode.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSearchPolicyBase
+ * @brief Common steps of all search policies
+ */
+class CSearchPolicyBase
+{
+	protected:
+
+		/**
+		 * @brief Set solution in root and write it in search log
+		 */
+		template <class InfoType>
+		static bool _solution(CNode<InfoType> *root,
+							CSearchContext<InfoType> *context, const InfoType &info)
+		{
+			root->set_information(info);
+			if (context->log()) *context->log() << info << std::endl;
+			return true;
+		}
+
+		/**
+		 * @brief Generate children of info, if it hasn't got any child it's a
+		 * dead end and its nogood is inserted in visited store (unless search
+		 * was stopped)
+		 * @param add_dead_end false if dead end is already in visited store
+		 * @return number of children
+		 */
+		template <class InfoType>
+		static size_t _expand(const InfoType &info, CSearchContext<InfoType> *context,
+							std::vector<InfoType> *children, bool add_dead_end = true)
+		{
+			children->clear();
+			context->node_expanded();
+			context->update_best(info);
+			info.generateChildrens(children, context);
+			context->children_generated(children->capacity() * sizeof(InfoType));
+
+			if (children->empty() && add_dead_end && !context->is_stopped())
+			{
+				InfoType nogood = info.get_nogood();
+				context->add_visited(nogood.get_occupiedBoxCount(), nogood);
+			}
+
+			return children->size();
+		}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CDepthFirstPolicy
+ * @brief Depth-first search, children are explored in generation order
+ */
+class CDepthFirstPolicy: public CSearchPolicyBase
+{
+	public:
+
+		template <class InfoType>
+		static bool search(CNode<InfoType> *root, CSearchContext<InfoType> *context)
+		{
+			std::vector<InfoType> stack(1, root->get_informacion());
+			std::vector<InfoType> children;
+			InfoType current;
+
+			context->account_nodes(1, sizeof(InfoType));
+			while (!stack.empty() && !context->is_stopped())
+			{
+				current = std::move(stack.back());
+				stack.pop_back();
+				context->account_nodes(-1, sizeof(InfoType));
+
+				if (current.isFinalCondition())
+				{
+					context->account_nodes(-(long)stack.size(), sizeof(InfoType));
+					return _solution(root, context, current);
+				}
+
+				_expand(current, context, &children);
+
+				// First child must be on top of stack
+				stack.insert(stack.end(), std::make_move_iterator(children.rbegin()),
+							std::make_move_iterator(children.rend()));
+				context->account_nodes(children.size(), sizeof(InfoType));
+			}
+
+			context->account_nodes(-(long)stack.size(), sizeof(InfoType));
+			return false;
+		}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CBestFirstPolicy
+ * @brief Best-first search, the frontier node with lower heuristic is
+ * expanded first. In a tie, the deepest and newest node goes first
+ */
+class CBestFirstPolicy: public CSearchPolicyBase
+{
+	public:
+
+		template <class InfoType>
+		static bool search(CNode<InfoType> *root, CSearchContext<InfoType> *context)
+		{
+			std::vector< SEntry<InfoType> > frontier;
+			std::vector<InfoType> children;
+			long order = 0;
+
+			_push(&frontier, root->get_informacion(), order++, context);
+			while (!frontier.empty() && !context->is_stopped())
+			{
+				std::pop_heap(frontier.begin(), frontier.end());
+				std::unique_ptr<InfoType> current = std::move(frontier.back().info);
+				frontier.pop_back();
+				context->account_nodes(-1, sizeof(InfoType));
+
+				if (current->isFinalCondition())
+				{
+					context->account_nodes(-(long)frontier.size(), sizeof(InfoType));
+					return _solution(root, context, *current);
+				}
+
+				_expand(*current, context, &children);
+				for (auto &child : children)
+				{
+					_push(&frontier, std::move(child), order++, context);
+				}
+			}
+
+			context->account_nodes(-(long)frontier.size(), sizeof(InfoType));
+			return false;
+		}
+
+	private:
+
+		template <class InfoType> struct SEntry
+		{
+			int heuristic;
+			int depth;
+			long order;
+			std::unique_ptr<InfoType> info;
+
+			// Max heap: "less" is the worst entry
+			bool operator<(const SEntry<InfoType> &other) const
+			{
+				if (heuristic != other.heuristic) return heuristic > other.heuristic;
+				if (depth != other.depth) return depth < other.depth;
+				return order < other.order;
+			}
+		};
+
+		template <class InfoType>
+		static void _push(std::vector< SEntry<InfoType> > *frontier,
+						InfoType info, long order,
+						CSearchContext<InfoType> *context)
+		{
+			SEntry<InfoType> entry;
+			entry.heuristic = info.get_heuristic();
+			entry.depth = info.get_occupiedBoxCount();
+			entry.order = order;
+			entry.info.reset(new InfoType(std::move(info)));
+
+			frontier->push_back(std::move(entry));
+			std::push_heap(frontier->begin(), frontier->end());
+			context->account_nodes(1, sizeof(InfoType));
+		}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CBeamPolicy
+ * @brief Beam search, tree is explored level by level and only the Width
+ * children with lower heuristic are kept in every level. It's not complete:
+ * it can fail with solvable boards if the right child is out of the beam, so
+ * it gives up (see CSearchContext::search_gave_up) when any child is dropped.
+ */
+template <unsigned int Width = 16>
+class CBeamPolicy: public CSearchPolicyBase
+{
+	public:
+
+		template <class InfoType>
+		static bool search(CNode<InfoType> *root, CSearchContext<InfoType> *context)
+		{
+			std::vector< std::pair<int, InfoType> > beam;
+			std::vector< std::pair<int, InfoType> > next;
+			std::vector<InfoType> children;
+
+			beam.push_back(std::make_pair(0, root->get_informacion()));
+			while (!beam.empty() && !context->is_stopped())
+			{
+				context->account_nodes(beam.size(), sizeof(InfoType));
+				next.clear();
+
+				for (const auto &current : beam)
+				{
+					if (current.second.isFinalCondition())
+					{
+						context->account_nodes(-(long)beam.size(), sizeof(InfoType));
+						return _solution(root, context, current.second);
+					}
+
+					_expand(current.second, context, &children);
+					for (auto &child : children)
+					{
+						int heuristic = child.get_heuristic();
+						next.emplace_back(heuristic, std::move(child));
+					}
+				}
+
+				if (next.size() > Width)
+				{
+					context->search_gave_up();
+					std::partial_sort(next.begin(), next.begin() + Width, next.end(),
+						[](const std::pair<int, InfoType> &a,
+							const std::pair<int, InfoType> &b)
+						{ return a.first < b.first; });
+					next.resize(Width);
+				}
+
+				context->account_nodes(-(long)beam.size(), sizeof(InfoType));
+				beam.swap(next);
+			}
+
+			return false;
+		}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CIterativeDeepeningPolicy
+ * @brief Depth-first search limited to a number of decisions (expansions with
+ * several children) in the path from root, the limit grows by one until a
+ * solution is found or no node was cut by the limit. Memory is proportional
+ * to depth. Branching is bounded (see CSearchContext::set_bounded_branching),
+ * in other case the number of nodes would grow too fast with the limit.
+ *
+ * Every iteration explores again the whole tree up to its limit (only dead
+ * ends are kept in visited store), so it's exponential with boards which need
+ * many decisions (sparse boards). When an iteration expands more than
+ * MAX_ITERATION_EXPANSIONS nodes, deepening stops and the search goes on with
+ * CDepthFirstPolicy, with the same bounded branching and visited store.
+ */
+class CIterativeDeepeningPolicy: public CSearchPolicyBase
+{
+	public:
+
+		template <class InfoType>
+		static bool search(CNode<InfoType> *root, CSearchContext<InfoType> *context)
+		{
+			bool cut = true;
+			bool found = false;
+			bool bounded_branching = context->get_bounded_branching();
+
+			context->set_bounded_branching(true);
+			for (unsigned int limit = 1; cut && !found && !context->is_stopped(); limit++)
+			{
+				long expanded = context->get_statistics().expanded_nodes;
+
+				cut = false;
+				found = _search(root, context, root->get_informacion(), limit, &cut);
+
+				expanded = context->get_statistics().expanded_nodes - expanded;
+				if (cut && !found && expanded > MAX_ITERATION_EXPANSIONS)
+				{
+					found = CDepthFirstPolicy::search(root, context);
+					break;
+				}
+			}
+			context->set_bounded_branching(bounded_branching);
+
+			return found;
+		}
+
+	private:
+
+		// Next iterations would be too expensive, depth-first search goes on
+		static const long MAX_ITERATION_EXPANSIONS = 1024;
+
+		template <class InfoType>
+		static bool _search(CNode<InfoType> *root, CSearchContext<InfoType> *context,
+							const InfoType &info, unsigned int limit, bool *cut)
+		{
+			if (info.isFinalCondition()) return _solution(root, context, info);
+
+			if (context->is_stopped()) return false;
+
+			if (limit == 0)
+			{
+				*cut = true;
+				return false;
+			}
+
+			// Nodes at the last level are expanded for the first time, dead ends
+			// of upper levels were inserted in visited store by previous limits
+			std::vector<InfoType> children;
+			_expand(info, context, &children, limit == 1);
+			context->account_nodes(children.size(), sizeof(InfoType));
+
+			// Only one child isn't a decision, it doesn't consume limit
+			unsigned int children_limit = (children.size() > 1) ? limit - 1 : limit;
+
+			for (size_t i = 0; i < children.size(); i++)
+			{
+				if (_search(root, context, children[i], children_limit, cut))
+				{
+					context->account_nodes(-(long)children.size(), sizeof(InfoType));
+					return true;
+				}
+			}
+
+			context->account_nodes(-(long)children.size(), sizeof(InfoType));
+			return false;
+		}
+};
+
+#endif // _CSEARCH_POLICY_HPP_
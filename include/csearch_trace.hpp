@@ -0,0 +1,290 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * csearch_trace.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file csearch_trace.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _CSEARCH_TRACE_HPP_
+#define _CSEARCH_TRACE_HPP_
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Events of a search trace. Depth is the occupied box count of the
+ * node, box and value are the decision of the node or child (-1 and 0 if
+ * there isn't any)
+ */
+enum E_SEARCH_TRACE_EVENT
+{
+	E_SEARCH_TRACE_EXPAND = 0,		/**< Children of a node are generated, box
+										 and value are its last decision */
+	E_SEARCH_TRACE_SAFE_CHILD,		/**< Child found by safe rules (100%) */
+	E_SEARCH_TRACE_PROBABLE_CHILD,	/**< Child with a decision box = value */
+	E_SEARCH_TRACE_VISITED_HIT,		/**< Child pruned by visited store */
+	E_SEARCH_TRACE_DEAD_END,		/**< Expanded node without children */
+	E_SEARCH_TRACE_NOGOOD,			/**< Failed node inserted in visited store,
+										 search backtracks. Depth is the nogood
+										 size */
+	E_SEARCH_TRACE_BACKJUMP,		/**< Node abandoned, it includes a nogood */
+	E_SEARCH_TRACE_SOLUTION,
+	E_SEARCH_TRACE_EVENT_COUNT
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief One event, 16 bytes
+ */
+struct SSearchTraceEvent
+{
+	uint64_t time;		/**< Nanoseconds since CSearchTrace::start */
+	uint16_t depth;
+	uint8_t type;		/**< E_SEARCH_TRACE_EVENT */
+	int8_t box;
+	uint8_t value;
+	uint8_t reserved[3];
+};
+
+static_assert(sizeof(SSearchTraceEvent) == 16, "Trace events must be packed");
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSearchTrace
+ * @brief Timestamped events of a search, to study pathological boards
+ * offline. Events are written in a ring buffer of fixed capacity, when it's
+ * full the oldest ones are overwritten, so a long search keeps its last
+ * events and memory doesn't grow. Recording is one clock read and one
+ * 16 bytes write, without locks: every thread (every search context, see
+ * CSearchContext::set_trace) must have its own trace.
+ *
+ * Binary format, in host byte order: SHeader and then the kept events from
+ * the oldest one. Chrome trace format (chrome://tracing, Perfetto) has one
+ * instant event by event and a "depth" counter.
+ */
+class CSearchTrace
+{
+	public:
+
+		/**
+		 * @brief CSearchTrace constructor
+		 * @param capacity max events kept, it's rounded up to a power of 2
+		 */
+		explicit CSearchTrace(size_t capacity = 1 << 18): m_mask(0), m_count(0)
+		{
+			size_t size = 2;
+			while (size < capacity) size <<= 1;
+
+			m_events.resize(size);
+			m_mask = size - 1;
+			start();
+		}
+
+		/**
+		 * @brief Remove every event, times are counted from now
+		 */
+		inline void start(void)
+		{
+			m_count = 0;
+			m_start = std::chrono::steady_clock::now();
+		}
+
+		/**
+		 * @brief Record an event
+		 * @param type E_SEARCH_TRACE_EVENT
+		 * @param depth
+		 * @param box -1 if there isn't any
+		 * @param value
+		 */
+		inline void record(E_SEARCH_TRACE_EVENT type, int depth, int box = -1,
+							int value = 0)
+		{
+			SSearchTraceEvent &event = m_events[m_count++ & m_mask];
+
+			event.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+							std::chrono::steady_clock::now() - m_start).count();
+			event.depth = depth;
+			event.type = type;
+			event.box = box;
+			event.value = value;
+		}
+
+		/**
+		 * @return events recorded since start, kept or overwritten
+		 */
+		inline uint64_t get_recorded(void) const { return m_count; }
+
+		/**
+		 * @return events kept
+		 */
+		inline size_t get_count(void) const
+		{
+			return m_count < m_events.size() ? m_count : m_events.size();
+		}
+
+		/**
+		 * @param i [0, get_count()), 0 is the oldest event kept
+		 * @return event
+		 */
+		inline const SSearchTraceEvent &get_event(size_t i) const
+		{
+			return m_events[(m_count - get_count() + i) & m_mask];
+		}
+
+		/**
+		 * @brief Write kept events in binary format
+		 * @param output
+		 * @return false write error
+		 */
+		bool write(std::ostream &output) const
+		{
+			SHeader header;
+
+			memcpy(header.magic, _get_magic(), sizeof(header.magic));
+			header.event_size = sizeof(SSearchTraceEvent);
+			header.recorded = m_count;
+			header.count = get_count();
+
+			output.write((const char *)&header, sizeof(header));
+			for (size_t i = 0; i < header.count; i++)
+			{
+				output.write((const char *)&get_event(i), sizeof(SSearchTraceEvent));
+			}
+			return !output.fail();
+		}
+
+		/**
+		 * @brief Read events in binary format
+		 * @param input
+		 * @param events kept events, from the oldest one
+		 * @param recorded if it isn't nullptr, events recorded by the search
+		 * (some of them may have been overwritten)
+		 * @return false it isn't a trace, or it's truncated
+		 */
+		static bool read(std::istream &input, std::vector<SSearchTraceEvent> *events,
+						uint64_t *recorded = nullptr)
+		{
+			SHeader header;
+
+			input.read((char *)&header, sizeof(header));
+			if (input.fail() || memcmp(header.magic, _get_magic(), sizeof(header.magic)) ||
+				header.event_size != sizeof(SSearchTraceEvent))
+			{
+				return false;
+			}
+
+			events->resize(header.count);
+			input.read((char *)events->data(), header.count * sizeof(SSearchTraceEvent));
+			if (recorded) *recorded = header.recorded;
+			return !input.fail();
+		}
+
+		/**
+		 * @brief Write kept events in Chrome trace format
+		 * @param output
+		 */
+		void write_chrome(std::ostream &output) const
+		{
+			std::vector<SSearchTraceEvent> events;
+
+			events.reserve(get_count());
+			for (size_t i = 0; i < get_count(); i++) events.push_back(get_event(i));
+			write_chrome(output, events);
+		}
+
+		/**
+		 * @brief Write events in Chrome trace format
+		 * @param output
+		 * @param events
+		 */
+		static void write_chrome(std::ostream &output,
+								const std::vector<SSearchTraceEvent> &events)
+		{
+			char buffer[192];
+			const char *separator = "";
+
+			output << "{\"traceEvents\":[";
+			for (const auto &event : events)
+			{
+				double microseconds = event.time / 1000.0;
+
+				snprintf(buffer, sizeof(buffer), "%s\n{\"name\":\"%s\",\"ph\":\"i\","
+						"\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":1,\"args\":"
+						"{\"depth\":%d,\"box\":%d,\"value\":%d}}", separator,
+						get_event_name(event.type), microseconds, event.depth,
+						event.box, event.value);
+				output << buffer;
+				separator = ",";
+
+				if (event.type != E_SEARCH_TRACE_EXPAND) continue;
+				snprintf(buffer, sizeof(buffer), ",\n{\"name\":\"depth\",\"ph\":\"C\","
+						"\"ts\":%.3f,\"pid\":1,\"args\":{\"depth\":%d}}",
+						microseconds, event.depth);
+				output << buffer;
+			}
+			output << "\n]}" << std::endl;
+		}
+
+		/**
+		 * @param type E_SEARCH_TRACE_EVENT
+		 * @return event name
+		 */
+		static const char *get_event_name(unsigned int type)
+		{
+			static const char *names[E_SEARCH_TRACE_EVENT_COUNT] = {"expand",
+				"safe_child", "probable_child", "visited_hit", "dead_end", "nogood",
+				"backjump", "solution"};
+
+			return type < E_SEARCH_TRACE_EVENT_COUNT ? names[type] : "unknown";
+		}
+
+	private:
+
+		/**
+		 * @return first 8 bytes of binary format
+		 */
+		static const char *_get_magic(void) { return "SDKTRACE"; }
+
+		struct SHeader
+		{
+			char magic[8];
+			uint32_t event_size;
+			uint32_t reserved;
+			uint64_t recorded;
+			uint64_t count;
+
+			SHeader(): event_size(0), reserved(0), recorded(0), count(0) {}
+		};
+
+		std::vector<SSearchTraceEvent> m_events;
+
+		size_t m_mask;
+
+		uint64_t m_count;
+
+		std::chrono::steady_clock::time_point m_start;
+};
+
+#endif // _CSEARCH_TRACE_HPP_
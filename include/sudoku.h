@@ -0,0 +1,201 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku.h
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sudoku.h
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * C API of libsudoku.
+ *
+ * Boards are buffers of 81 characters, row by row: '1' to '9' are values,
+ * '0' and '.' are empty boxes. Every solver context is independent, so
+ * several threads can solve at the same time with their own context. A context
+ * can also be shared by several threads, then their calls are serialized.
+ * Context keeps its allocated memory between calls.
+ */
+
+#ifndef _SUDOKU_H_
+#define _SUDOKU_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define SUDOKU_API __attribute__((visibility("default")))
+#else
+#define SUDOKU_API
+#endif
+
+#define SUDOKU_API_VERSION 4
+
+#define SUDOKU_BOARD_SIZE 81
+
+/**
+ * sudoku_solve results
+ */
+enum sudoku_result
+{
+	SUDOKU_ERROR = -1,		/**< Internal error, out of memory... */
+	SUDOKU_SOLVED = 0,		/**< Solution was written */
+	SUDOKU_UNSOLVABLE = 1,	/**< Board hasn't got solution */
+	SUDOKU_INVALID = 2,		/**< Invalid character or board breaks rules */
+	SUDOKU_TIMED_OUT = 3	/**< Timeout, cancelled or incomplete search (beam)
+								 gave up, partial board was written */
+};
+
+typedef struct sudoku_context sudoku_context;
+
+typedef struct sudoku_session sudoku_session;
+
+/**
+ * @return SUDOKU_API_VERSION of library
+ */
+SUDOKU_API int sudoku_api_version(void);
+
+/**
+ * @brief Create a solver context
+ * @return context or NULL if there isn't memory
+ */
+SUDOKU_API sudoku_context *sudoku_context_new(void);
+
+/**
+ * @brief Free a solver context, NULL is allowed
+ * @param context
+ */
+SUDOKU_API void sudoku_context_free(sudoku_context *context);
+
+/**
+ * @brief Set memory limit of every search in this context. When it's reached,
+ * solver drops part of its visited nodes and bounds new expansions instead of
+ * growing
+ * @param context
+ * @param limit bytes, 0 is unlimited (default)
+ */
+SUDOKU_API void sudoku_context_set_memory_limit(sudoku_context *context,
+												size_t limit);
+
+/**
+ * @brief Set memory limit of all searches in this process at the same time
+ * @param limit bytes, 0 is unlimited (default)
+ */
+SUDOKU_API void sudoku_set_process_memory_limit(size_t limit);
+
+/**
+ * @param context
+ * @return 1 if last sudoku_solve in context reached its memory limit or
+ * process memory limit, 0 in other case
+ */
+SUDOKU_API int sudoku_context_memory_degraded(sudoku_context *context);
+
+/**
+ * @brief Set max time of every search in this context
+ * @param context
+ * @param timeout milliseconds, 0 is unlimited (default)
+ */
+SUDOKU_API void sudoku_context_set_timeout(sudoku_context *context,
+											unsigned long timeout);
+
+/**
+ * @brief Stop the sudoku_solve running now with this context, it returns
+ * SUDOKU_TIMED_OUT. It can be called from any thread, it doesn't wait for
+ * sudoku_solve. It hasn't got any effect on next calls
+ * @param context
+ */
+SUDOKU_API void sudoku_context_cancel(sudoku_context *context);
+
+/**
+ * @brief Solve sudoku board
+ * @param context solver context
+ * @param puzzle board of SUDOKU_BOARD_SIZE characters
+ * @param solution buffer of SUDOKU_BOARD_SIZE characters for solved board,
+ * or the deepest partial board if it timed out. It's filled with '0' if board
+ * hasn't got solution
+ * @return sudoku_result
+ */
+SUDOKU_API int sudoku_solve(sudoku_context *context, const char *puzzle,
+							char *solution);
+
+/**
+ * @brief Create an incremental solver session for a board edited one box at
+ * a time. Last solution is kept and it isn't searched again while edits are
+ * consistent with it. A session must be used by only one thread at a time
+ * @return session or NULL if there isn't memory
+ */
+SUDOKU_API sudoku_session *sudoku_session_new(void);
+
+/**
+ * @brief Free a session, NULL is allowed
+ * @param session
+ */
+SUDOKU_API void sudoku_session_free(sudoku_session *session);
+
+/**
+ * @brief Set max time of every search in this session
+ * @param session
+ * @param timeout milliseconds, 0 is unlimited (default)
+ */
+SUDOKU_API void sudoku_session_set_timeout(sudoku_session *session,
+											unsigned long timeout);
+
+/**
+ * @brief Start the session with a new board and solve it
+ * @param session
+ * @param puzzle board of SUDOKU_BOARD_SIZE characters
+ * @param solution like in sudoku_solve
+ * @return sudoku_result, if it's SUDOKU_INVALID session isn't changed
+ */
+SUDOKU_API int sudoku_session_load(sudoku_session *session, const char *puzzle,
+									char *solution);
+
+/**
+ * @brief Edit one box of session board and solve it again if it's needed
+ * @param session
+ * @param row [0, 8]
+ * @param column [0, 8]
+ * @param value [1, 9], 0 removes box value
+ * @param solution like in sudoku_solve
+ * @return sudoku_result, if it's SUDOKU_INVALID (value or position out of
+ * range, or value breaks rules) board isn't changed and solution isn't written
+ */
+SUDOKU_API int sudoku_session_set(sudoku_session *session, int row, int column,
+									int value, char *solution);
+
+/**
+ * @brief Check claimed solutions without search: every box has a value, rows,
+ * columns and squares have the nine values and every given value of the
+ * puzzle is in the same box. Big arrays are checked by several threads
+ * @param solutions count boards of SUDOKU_BOARD_SIZE characters, one after
+ * another
+ * @param puzzles count puzzles of solutions in the same way, or NULL to check
+ * only solutions
+ * @param count
+ * @param valid if it isn't NULL, count results: 1 valid, 0 invalid
+ * @return number of valid solutions, or SUDOKU_ERROR
+ */
+SUDOKU_API long sudoku_validate(const char *solutions, const char *puzzles,
+								size_t count, unsigned char *valid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SUDOKU_H_ */
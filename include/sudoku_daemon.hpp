@@ -0,0 +1,208 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_daemon.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sudoku_daemon.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * Sudoku solver daemon over a Unix domain socket.
+ *
+ * Protocol, all lengths are 32 bits unsigned integers in network byte order:
+ *
+ *   Request:  length | length bytes with N sudoku boards of 81 characters
+ *             (see CSudokuBoard::load_from_buffer)
+ *   Response: length | length bytes with N results of 82 characters, a status
+ *             character ('0' solved, '1' unsolvable, '2' invalid board, '3'
+ *             timed out or gave up) and the solved board in 81 characters,
+ *             or the partial board if it timed out or gave up
+ *
+ * A client can send several requests without waiting for responses, they are
+ * answered in the same order. Request length must be multiple of 81, in other
+ * case connection is closed. When a client closes its connection, its boards
+ * waiting for a worker aren't solved and its running searches are cancelled.
+ * Boards waiting for a worker in all connections are limited, readers of
+ * requests wait for free room.
+ */
+
+#ifndef _SUDOKU_DAEMON_HPP_
+#define _SUDOKU_DAEMON_HPP_
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <list>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+#include "sudoku_worker.hpp"
+#include "sudoku_metrics.hpp"
+#include "sudoku_portfolio.hpp"
+
+namespace sudoku{
+
+enum E_SUDOKU_DAEMON
+{
+	E_SUDOKU_DAEMON_RESULT_SIZE = E_SUDOKU_BOX_COUNT + 1,
+	E_SUDOKU_DAEMON_MAX_BOARDS_BY_REQUEST = 4096,
+	E_SUDOKU_DAEMON_MAX_REQUESTS_IN_FLIGHT = 256,
+	E_SUDOKU_DAEMON_MAX_QUEUED_BOARDS = 65536	/**< In all connections */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSudokuDaemon
+ * @brief Listen in a Unix domain socket and solve requested boards in a
+ * persistent pool of workers (see CSudokuWorker)
+ */
+class CSudokuDaemon
+{
+	public:
+
+		/**
+		 * @brief CSudokuDaemon constructor
+		 * @param socket_path Unix domain socket path, it's removed if it exists
+		 * @param worker_count number of solver threads, 0 means one by CPU
+		 * @param options search options of every worker
+		 */
+		CSudokuDaemon(const std::string &socket_path, unsigned int worker_count,
+			const SSudokuWorkerOptions &options = SSudokuWorkerOptions());
+
+		/**
+		 * @brief Stop workers and connections. Boards waiting for a worker
+		 * are answered as timed out with their puzzle, running searches are
+		 * cancelled
+		 */
+		virtual ~CSudokuDaemon();
+
+		/**
+		 * @brief Start workers and accept connections until stop() is
+		 * called. Socket is removed when it returns
+		 * @return 0 stopped, -1 error
+		 */
+		int run(void);
+
+		/**
+		 * @brief Make run() return, connections and workers are stopped by
+		 * destructor. It's async signal safe
+		 */
+		void stop(void);
+
+		/**
+		 * @param metrics where boards are recorded, nullptr for none. It must
+		 * live longer than daemon
+		 */
+		inline void set_metrics(CSudokuMetrics *metrics) { m_metrics = metrics; }
+
+	private:
+
+		/**
+		 * Pending sudoku board of a request
+		 */
+		struct SJob
+		{
+			std::string puzzle;
+			std::promise<std::string> result;
+			std::shared_ptr<CCancelToken> cancel;	/**< Cancelled when client
+														 closes connection */
+		};
+
+		/**
+		 * Connection thread, it's joined by accept loop when it finishes, or
+		 * by destructor
+		 */
+		struct SConnection
+		{
+			int fd;
+			std::shared_ptr<CCancelToken> cancel;
+			std::atomic<bool> done;
+			std::thread thread;
+
+			SConnection(int connection_fd): fd(connection_fd),
+				cancel(std::make_shared<CCancelToken>()), done(false)
+			{
+			}
+		};
+
+		void _worker_loop(void);
+
+		/**
+		 * @brief Wake up accept loop of run(), it's async signal safe
+		 */
+		void _wake(void);
+
+		void _connection_loop(SConnection *connection);
+
+		/**
+		 * @brief Queue a board for workers, it waits if queue is full. If
+		 * daemon is stopping, result is timed out with puzzle
+		 */
+		std::future<std::string> _submit(const char *puzzle,
+										const std::shared_ptr<CCancelToken> &cancel);
+
+		/**
+		 * @brief Answer a job without solving it, as timed out with its puzzle
+		 */
+		static void _fail_job(SJob *job);
+
+		/**
+		 * @brief Join finished connection threads
+		 * @param all wait for every connection
+		 */
+		void _join_connections(bool all);
+
+		static bool _read_full(int fd, void *buffer, size_t size);
+
+		static bool _write_full(int fd, const void *buffer, size_t size);
+
+		std::string m_socket_path;
+
+		unsigned int m_worker_count;
+
+		SSudokuWorkerOptions m_options;
+
+		int m_listen_fd;
+
+		int m_wake_fd[2];			// Self-pipe of accept loop
+
+		std::atomic<bool> m_stop_requested;	// By stop(), accept loop ends
+
+		bool m_stop;
+
+		std::deque<SJob> m_jobs;
+
+		std::mutex m_jobs_mutex;
+
+		std::condition_variable m_jobs_cond;
+
+		std::condition_variable m_room_cond;	// Queue isn't full
+
+		std::list<SConnection> m_connections;	// Only used by run and destructor
+
+		std::vector<std::thread> m_workers;
+
+		CSudokuMetrics *m_metrics;
+};
+
+} // namespace sudoku
+#endif // _SUDOKU_DAEMON_HPP_
@@ -0,0 +1,167 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_journal.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sudoku_journal.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _SUDOKU_JOURNAL_HPP_
+#define _SUDOKU_JOURNAL_HPP_
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <cstdint>
+
+#include "sudoku_solver.hpp"
+
+namespace sudoku{
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSudokuJournal
+ * @brief Progress journal of a batch run, so it can be resumed after a crash
+ * without solving again the boards already written (see CSudokuPipeline).
+ *
+ * File is a header (magic, batch file size and hash of its contents) and
+ * blocks appended in output order, every block is durable when it's written:
+ *
+ *   count | count results | input offset after last board | checksum
+ *
+ * A result is its status and its board packed in 4 bits by box. Results
+ * are kept in memory and written in one block, with fsync, once every sync
+ * interval. A block not completely written (crash) is removed on open, its
+ * count isn't trusted before its checksum.
+ * Integers are in host byte order.
+ */
+class CSudokuJournal
+{
+	public:
+
+		CSudokuJournal();
+
+		CSudokuJournal(const CSudokuJournal &original) = delete;
+		CSudokuJournal &operator=(const CSudokuJournal &original) = delete;
+
+		virtual ~CSudokuJournal();
+
+		/**
+		 * @brief Open journal, or create it if it doesn't exist. Results of
+		 * an existing journal are loaded to be replayed
+		 * @param path
+		 * @param input batch file, a journal of other file (size or
+		 * contents) fails. It's read once, and left at its beginning
+		 * @param sync_interval time between durable writes, 0 for every
+		 * result
+		 * @return false journal can't be opened or it isn't of this batch file
+		 */
+		bool open(const std::string &path, std::istream &input,
+				std::chrono::milliseconds sync_interval);
+
+		/**
+		 * @return number of results in journal when it was opened
+		 */
+		inline long get_resume_count(void) const { return m_resume_count; }
+
+		/**
+		 * @return input offset after last board in journal when it was
+		 * opened, 0 for a new journal
+		 */
+		inline std::streamoff get_resume_offset(void) const { return m_resume_offset; }
+
+		/**
+		 * @brief Get a result loaded by open, they are freed by release()
+		 * @param index [0, get_resume_count())
+		 * @param status CSudokuWorker::E_SUDOKU_WORKER_RESULT
+		 * @param board
+		 */
+		void get_result(long index, int *status, CSudokuBoard *board) const;
+
+		/**
+		 * @brief Free results loaded by open
+		 */
+		void release(void);
+
+		/**
+		 * @brief Add a result written in output, it's durable after next sync
+		 * @param status CSudokuWorker::E_SUDOKU_WORKER_RESULT
+		 * @param board
+		 * @param input_offset input offset after board
+		 * @return false write error
+		 */
+		bool append(int status, const CSudokuBoard &board, std::streamoff input_offset);
+
+		/**
+		 * @brief Write pending results and fsync
+		 * @return false write error
+		 */
+		bool sync(void);
+
+		/**
+		 * @brief sync() if there are pending results and sync interval has
+		 * elapsed since last one
+		 * @return false write error
+		 */
+		bool sync_if_due(void);
+
+	private:
+
+		enum E_SUDOKU_JOURNAL
+		{
+			E_SUDOKU_JOURNAL_RESULT_SIZE = 1 + (E_SUDOKU_BOX_COUNT + 1) / 2
+		};
+
+		/**
+		 * @brief Load every complete block after header, the rest is removed
+		 * @return false read error
+		 */
+		bool _load(void);
+
+		/**
+		 * @brief Identity of batch file: its size and FNV-1a hash of its
+		 * contents
+		 * @param input
+		 * @param id size and hash
+		 */
+		static void _identify(std::istream &input, uint64_t *id);
+
+		static uint32_t _checksum(const unsigned char *data, size_t size);
+
+		int m_fd;
+
+		std::chrono::milliseconds m_sync_interval;
+
+		std::chrono::steady_clock::time_point m_last_sync;
+
+		// Results loaded by open, and results not written yet
+		std::vector<unsigned char> m_loaded;
+
+		std::vector<unsigned char> m_pending;
+
+		long m_resume_count;
+
+		std::streamoff m_resume_offset;
+
+		std::streamoff m_pending_offset;
+};
+
+} // namespace sudoku
+#endif // _SUDOKU_JOURNAL_HPP_
@@ -0,0 +1,151 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_lanes.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sudoku_lanes.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _SUDOKU_LANES_HPP_
+#define _SUDOKU_LANES_HPP_
+
+#include <cstdint>
+
+#include "sudoku_tables.hpp"
+
+namespace sudoku{
+
+enum E_SUDOKU_LANES
+{
+	E_SUDOKU_LANES_COUNT = 16	/**< Boards propagated at the same time */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSudokuLanes
+ * @brief Propagation of several boards in lockstep. The safe rules of
+ * generateSudokuBoardChildrens (only one possible value in a box, and only one
+ * possible box for a value in a row, column or square) are applied to all
+ * boards at the same time until none of them changes.
+ *
+ * Boards are stored as structure of arrays: for every box there is one bit
+ * mask with its value, and for every unit one bit mask with its used values,
+ * for each lane. Possible values of a box are the values not used in its
+ * three units. Lanes are a GCC vector type (16 lanes of 16 bits), so every
+ * step is done for all boards with SIMD instructions: one AVX2 register, or
+ * two SSE2 ones in the default x86-64 build.
+ *
+ * Only boards solved by these rules are solved here, the rest of them need
+ * a search (see CSudokuWorker). Only classic layout is supported (see
+ * CSudokuLayout).
+ */
+class CSudokuLanes
+{
+	public:
+
+		CSudokuLanes();
+
+		virtual ~CSudokuLanes(){};
+
+		/**
+		 * @brief Remove all boards
+		 */
+		void clear(void);
+
+		/**
+		 * @brief Put a board in the next free lane
+		 * @param board
+		 * @return false all lanes are used
+		 */
+		bool add(const CSudokuBoard &board);
+
+		/**
+		 * @return number of used lanes
+		 */
+		inline unsigned int get_count(void) const { return m_count; }
+
+		/**
+		 * @brief Apply safe rules to every lane until none of them changes
+		 */
+		void propagate(void);
+
+		/**
+		 * @param lane
+		 * @return true board in lane is complete and it doesn't break any rule
+		 */
+		bool is_solved(unsigned int lane) const;
+
+		/**
+		 * @brief Get board in lane
+		 * @param lane
+		 * @param board
+		 * @return false any value breaks rules
+		 */
+		bool get_board(unsigned int lane, CSudokuBoard *board) const;
+
+	private:
+
+		typedef uint16_t lane_vector
+			__attribute__((vector_size(E_SUDOKU_LANES_COUNT * sizeof(uint16_t))));
+
+		/**
+		 * @brief Set value bits in box for every lane, and mark them as used
+		 * in its units. A lane without bits isn't changed
+		 * @param box
+		 * @param values one bit or none for every lane
+		 */
+		void _assign(int box, const lane_vector &values);
+
+		/**
+		 * @brief Possible values of box for every lane, 0 if box is set
+		 * @param box
+		 * @param possible
+		 */
+		void _get_possible(int box, lane_vector &possible) const;
+
+		/**
+		 * @param values
+		 * @return true any lane isn't 0
+		 */
+		static bool _any(const lane_vector &values);
+
+		/**
+		 * @brief Only one possible value in a box. Lanes with an empty box
+		 * without possible values are marked as failed
+		 * @return true any box was set
+		 */
+		bool _naked_singles(void);
+
+		/**
+		 * @brief Only one possible box for a value in a unit
+		 * @return true any box was set
+		 */
+		bool _hidden_singles(void);
+
+		lane_vector m_values[E_SUDOKU_BOX_COUNT];
+
+		lane_vector m_used[E_SUDOKU_UNIT_COUNT];
+
+		lane_vector m_failed;
+
+		unsigned int m_count;
+};
+
+} // namespace sudoku
+#endif // _SUDOKU_LANES_HPP_
@@ -0,0 +1,214 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_layout.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sudoku_layout.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _SUDOKU_LAYOUT_HPP_
+#define _SUDOKU_LAYOUT_HPP_
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace sudoku{
+
+enum E_SUDOKU_LAYOUT
+{
+	E_SUDOKU_LAYOUT_MAX_UNITS = 3 * E_SUDOKU_DIM + 2 + 4,	/**< Classic units,
+															 diagonals and windows */
+	E_SUDOKU_LAYOUT_MAX_PEERS = E_SUDOKU_BOX_COUNT - 1,
+	E_SUDOKU_LAYOUT_MAX_SUM = 45	/**< 1 + 2 + ... + 9 */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Killer cage: its values can't be repeated and they must add up to sum
+ */
+struct SSudokuCage
+{
+	unsigned char boxes[E_SUDOKU_DIM];
+	unsigned char size;
+	unsigned char sum;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSudokuLayout
+ * @brief Constraints of a sudoku variant, as tables: units (9 boxes with
+ * every value once: rows, columns, squares and the extra units of variants),
+ * killer cages and the peers of every box (boxes which share a unit or a
+ * cage with it). Tables are compiled once, when layout is built, into flat
+ * arrays which CSudokuBoard uses in its rules, so a variant is solved by the
+ * same code as a classic board.
+ *
+ * Variants: diagonals (X sudoku), irregular regions instead of 3x3 squares
+ * (jigsaw), windows (windoku, 4 more 3x3 units) and killer cages. They can
+ * be combined.
+ *
+ * Every board has a layout (see CSudokuBoard::set_layout), new boards take
+ * the default one (see set_default), which is the classic layout unless it's
+ * changed. Boards keep a pointer to their layout, it must live longer than
+ * them.
+ */
+class CSudokuLayout
+{
+	public:
+
+		/**
+		 * @brief Classic layout: rows, columns and 3x3 squares
+		 */
+		CSudokuLayout();
+
+		virtual ~CSudokuLayout(){};
+
+		/**
+		 * @brief Irregular regions instead of 3x3 squares (jigsaw)
+		 * @param regions 81 characters, region '1' to '9' of every box, row
+		 * by row. Every region has 9 boxes
+		 * @return false invalid regions
+		 */
+		bool set_regions(const char *regions);
+
+		/**
+		 * @brief Both diagonals are units (X sudoku)
+		 * @return false there isn't room for more units
+		 */
+		bool add_diagonals(void);
+
+		/**
+		 * @brief Four 3x3 windows starting in rows and columns 1 and 5 are
+		 * units (windoku)
+		 * @return false there isn't room for more units
+		 */
+		bool add_windows(void);
+
+		/**
+		 * @param boxes 9 different boxes
+		 * @return false invalid boxes or there isn't room for more units
+		 */
+		bool add_unit(const unsigned char *boxes);
+
+		/**
+		 * @param boxes 1 to 9 boxes which aren't in another cage
+		 * @param sum
+		 * @return false invalid cage
+		 */
+		bool add_cage(const std::vector<int> &boxes, int sum);
+
+		/**
+		 * @brief Read layout in text format. Every line is a variant, empty
+		 * lines and lines starting with '#' are ignored:
+		 *
+		 *   diagonals
+		 *   windows
+		 *   regions <81 characters, see set_regions>
+		 *   cage <sum> <box> [<box> ...]   (box = row * 9 + column)
+		 *
+		 * @param input
+		 * @return false invalid line, error is written in std::cerr
+		 */
+		bool load(std::istream &input);
+
+		/**
+		 * @brief Build layout by name: classic, x (diagonals), windoku, or
+		 * the name of a file in load() format
+		 * @param name
+		 * @return false unknown name or invalid file
+		 */
+		bool load_by_name(const std::string &name);
+
+		/**
+		 * @return true only classic units, without cages
+		 */
+		inline bool is_classic(void) const { return m_classic; }
+
+		inline unsigned int get_unit_count(void) const { return m_unit_count; }
+
+		/**
+		 * @param unit
+		 * @return 9 boxes of unit
+		 */
+		inline const unsigned char *get_unit(unsigned int unit) const { return m_units[unit]; }
+
+		/**
+		 * @param i [0, get_unit_count())
+		 * @return i-th unit in the order its hidden singles are looked for
+		 */
+		inline unsigned int get_propagation_unit(unsigned int i) const { return m_order[i]; }
+
+		inline unsigned int get_peer_count(int box) const { return m_peer_count[box]; }
+
+		inline const unsigned char *get_peers(int box) const { return m_peers[box]; }
+
+		inline unsigned int get_cage_count(void) const { return m_cages.size(); }
+
+		inline const SSudokuCage &get_cage(unsigned int cage) const { return m_cages[cage]; }
+
+		/**
+		 * @param count [1, 9]
+		 * @param sum
+		 * @return sets of count different values which add up to sum, as bit
+		 * masks (bit v is value v)
+		 */
+		static const std::vector<uint16_t> &get_combinations(int count, int sum);
+
+		/**
+		 * @return layout of new boards
+		 */
+		static const CSudokuLayout &get_default(void);
+
+		/**
+		 * @brief Layout of new boards, it must be set before boards are
+		 * built in other threads
+		 * @param layout nullptr for classic layout
+		 */
+		static void set_default(const CSudokuLayout *layout);
+
+	private:
+
+		/**
+		 * @brief Compute peers of every box from units and cages
+		 */
+		void _compile(void);
+
+		unsigned char m_units[E_SUDOKU_LAYOUT_MAX_UNITS][E_SUDOKU_DIM];
+
+		unsigned int m_unit_count;
+
+		unsigned char m_order[E_SUDOKU_LAYOUT_MAX_UNITS];
+
+		unsigned char m_peers[E_SUDOKU_BOX_COUNT][E_SUDOKU_LAYOUT_MAX_PEERS];
+
+		unsigned char m_peer_count[E_SUDOKU_BOX_COUNT];
+
+		std::vector<SSudokuCage> m_cages;
+
+		signed char m_box_cage[E_SUDOKU_BOX_COUNT];	// -1 none
+
+		bool m_classic;
+
+		static const CSudokuLayout *m_default;
+};
+
+} // namespace sudoku
+#endif // _SUDOKU_LAYOUT_HPP_
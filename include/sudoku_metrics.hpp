@@ -0,0 +1,351 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_metrics.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file sudoku_metrics.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _SUDOKU_METRICS_HPP_
+#define _SUDOKU_METRICS_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+#include "sudoku_worker.hpp"
+
+namespace sudoku{
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief How a board was finished
+ */
+enum E_SUDOKU_METRICS_OUTCOME
+{
+	E_SUDOKU_METRICS_LOCKSTEP = 0,	/**< Solved by lockstep propagation, without search */
+	E_SUDOKU_METRICS_SEARCHED,		/**< Solved by a full search */
+	E_SUDOKU_METRICS_UNSOLVABLE,
+	E_SUDOKU_METRICS_TIMED_OUT,
+	E_SUDOKU_METRICS_INVALID,
+	E_SUDOKU_METRICS_OUTCOME_COUNT
+};
+
+/**
+ * @param result CSudokuWorker::E_SUDOKU_WORKER_RESULT of a search
+ * @return outcome of result
+ */
+inline E_SUDOKU_METRICS_OUTCOME get_outcome_by_result(int result)
+{
+	switch (result)
+	{
+		case CSudokuWorker::E_SUDOKU_WORKER_SOLVED: return E_SUDOKU_METRICS_SEARCHED;
+		case CSudokuWorker::E_SUDOKU_WORKER_TIMED_OUT: return E_SUDOKU_METRICS_TIMED_OUT;
+		case CSudokuWorker::E_SUDOKU_WORKER_INVALID: return E_SUDOKU_METRICS_INVALID;
+		default: return E_SUDOKU_METRICS_UNSOLVABLE;
+	}
+}
+
+/**
+ * @brief Memory peaks of a search, see SSearchStatistics
+ */
+enum E_SUDOKU_METRICS_MEMORY
+{
+	E_SUDOKU_METRICS_MEMORY_PEAK = 0,	/**< Bytes of all components together */
+	E_SUDOKU_METRICS_MEMORY_TREE,
+	E_SUDOKU_METRICS_MEMORY_WIDTH,		/**< Nodes, not bytes */
+	E_SUDOKU_METRICS_MEMORY_VISITED,
+	E_SUDOKU_METRICS_MEMORY_CHILDREN,
+	E_SUDOKU_METRICS_MEMORY_COUNT
+};
+
+enum E_SUDOKU_METRICS
+{
+	/** Latency histogram: 16 linear buckets for each power of two of
+	 * nanoseconds (error < 1/16), up to 2^40 ns */
+	E_SUDOKU_METRICS_SUB_BUCKET_BITS = 4,
+	E_SUDOKU_METRICS_SUB_BUCKETS = 1 << E_SUDOKU_METRICS_SUB_BUCKET_BITS,
+	E_SUDOKU_METRICS_MAX_BIT = 40,
+	E_SUDOKU_METRICS_BUCKETS = (E_SUDOKU_METRICS_MAX_BIT - E_SUDOKU_METRICS_SUB_BUCKET_BITS + 2) *
+								E_SUDOKU_METRICS_SUB_BUCKETS,
+	/** Throughput samples, one by second */
+	E_SUDOKU_METRICS_SAMPLES = 61
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSudokuMetrics
+ * @brief Metrics of a long running batch or daemon: latency histogram of
+ * every board, outcome counters, throughput in sliding windows (1, 10 and 60
+ * seconds), queue depth, portfolio winners (see CSudokuPortfolio), expanded
+ * nodes, the max memory peaks of a board search by component and process
+ * peak RSS.
+ *
+ * Every solver thread gets its own slot (see register_thread) and it's the
+ * only writer of that slot, so recording is a few relaxed stores without
+ * locks or shared cache lines. Slots are added up only when metrics are
+ * written.
+ *
+ * A reporter thread (see start) samples throughput every second, writes JSON
+ * metrics to a file periodically and writes text metrics to std::cerr when
+ * request_dump() is called, which is safe inside a signal handler.
+ */
+class CSudokuMetrics
+{
+	public:
+
+		/**
+		 * @brief Counters of one solver thread
+		 */
+		struct SThreadMetrics
+		{
+			std::atomic<uint64_t> latency[E_SUDOKU_METRICS_BUCKETS];
+			std::atomic<uint64_t> outcomes[E_SUDOKU_METRICS_OUTCOME_COUNT];
+			std::atomic<uint64_t> latency_sum;	// ns
+			std::atomic<uint64_t> latency_max;	// ns
+			std::atomic<uint64_t> wins[E_SUDOKU_STRATEGY_COUNT];
+			std::atomic<uint64_t> memory[E_SUDOKU_METRICS_MEMORY_COUNT];	// max
+			std::atomic<uint64_t> expanded_nodes;
+
+			// Last counters and the next slot never share a cache line
+			char padding[64];
+
+			SThreadMetrics();
+		};
+
+		CSudokuMetrics();
+
+		CSudokuMetrics(const CSudokuMetrics &original) = delete;
+		CSudokuMetrics &operator=(const CSudokuMetrics &original) = delete;
+
+		virtual ~CSudokuMetrics();
+
+		/**
+		 * @brief Get a new slot for the calling thread. Slots live as long as
+		 * metrics, their counters are never reset
+		 * @return slot, only the calling thread must record in it
+		 */
+		SThreadMetrics *register_thread(void);
+
+		/**
+		 * @brief Record a finished board
+		 * @param slot slot of calling thread
+		 * @param latency
+		 * @param outcome
+		 */
+		static inline void record(SThreadMetrics *slot, std::chrono::nanoseconds latency,
+								E_SUDOKU_METRICS_OUTCOME outcome)
+		{
+			uint64_t ns = latency.count() > 0 ? latency.count() : 0;
+
+			// Only one writer, load and store are enough
+			_increment(slot->latency[get_bucket(ns)], 1);
+			_increment(slot->outcomes[outcome], 1);
+			_increment(slot->latency_sum, ns);
+			if (ns > slot->latency_max.load(std::memory_order_relaxed))
+			{
+				slot->latency_max.store(ns, std::memory_order_relaxed);
+			}
+		}
+
+		/**
+		 * @brief Record expanded nodes and memory peaks of a board search
+		 * @param slot slot of calling thread
+		 * @param statistics of the search
+		 */
+		static inline void record_search(SThreadMetrics *slot,
+										const SSearchStatistics &statistics)
+		{
+			_increment(slot->expanded_nodes, statistics.expanded_nodes);
+			_maximum(slot->memory[E_SUDOKU_METRICS_MEMORY_PEAK], statistics.peak_bytes);
+			_maximum(slot->memory[E_SUDOKU_METRICS_MEMORY_TREE], statistics.peak_tree_bytes);
+			_maximum(slot->memory[E_SUDOKU_METRICS_MEMORY_WIDTH], statistics.peak_live_nodes);
+			_maximum(slot->memory[E_SUDOKU_METRICS_MEMORY_VISITED],
+					statistics.peak_visited_bytes);
+			_maximum(slot->memory[E_SUDOKU_METRICS_MEMORY_CHILDREN],
+					statistics.peak_children_bytes);
+		}
+
+		/**
+		 * @brief Record the strategy which solved first a board in a portfolio
+		 * @param slot slot of calling thread
+		 * @param strategy
+		 */
+		static inline void record_win(SThreadMetrics *slot, E_SUDOKU_STRATEGY strategy)
+		{
+			_increment(slot->wins[strategy], 1);
+		}
+
+		/**
+		 * @brief Set the function which returns the number of boards waiting
+		 * or being solved, nullptr to remove it
+		 * @param queue_depth
+		 */
+		void set_queue_depth(std::function<long(void)> queue_depth);
+
+		/**
+		 * @brief Start reporter thread
+		 * @param path file where JSON metrics are written, empty for none.
+		 * It's replaced atomically (written in path.tmp and renamed)
+		 * @param period seconds between writes of file
+		 */
+		void start(const std::string &path, unsigned int period);
+
+		/**
+		 * @brief Stop reporter thread, metrics file is written for the last
+		 * time
+		 */
+		void stop(void);
+
+		/**
+		 * @brief Ask reporter thread to write text metrics in std::cerr.
+		 * It's async signal safe
+		 */
+		static void request_dump(void);
+
+		void write_text(std::ostream &output);
+
+		void write_json(std::ostream &output);
+
+		/**
+		 * @brief Write only memory peaks and peak RSS, as text
+		 * @param output
+		 */
+		void write_memory(std::ostream &output);
+
+		/**
+		 * @return peak resident set size of the process, in KB, 0 if it's
+		 * unknown
+		 */
+		static long get_peak_rss(void);
+
+		/**
+		 * @param ns latency
+		 * @return histogram bucket of latency
+		 */
+		static inline unsigned int get_bucket(uint64_t ns)
+		{
+			if (ns < E_SUDOKU_METRICS_SUB_BUCKETS) return ns;
+
+			unsigned int bit = 63 - __builtin_clzll(ns);
+			if (bit > E_SUDOKU_METRICS_MAX_BIT) return E_SUDOKU_METRICS_BUCKETS - 1;
+
+			unsigned int shift = bit - E_SUDOKU_METRICS_SUB_BUCKET_BITS;
+			return (shift + 1) * E_SUDOKU_METRICS_SUB_BUCKETS +
+					((ns >> shift) & (E_SUDOKU_METRICS_SUB_BUCKETS - 1));
+		}
+
+		/**
+		 * @param bucket
+		 * @return highest latency in bucket, ns
+		 */
+		static uint64_t get_bucket_limit(unsigned int bucket);
+
+	private:
+
+		/**
+		 * @brief Sum of every slot
+		 */
+		struct STotals
+		{
+			uint64_t latency[E_SUDOKU_METRICS_BUCKETS];
+			uint64_t outcomes[E_SUDOKU_METRICS_OUTCOME_COUNT];
+			uint64_t latency_sum;
+			uint64_t latency_max;
+			uint64_t boards;
+			uint64_t wins[E_SUDOKU_STRATEGY_COUNT];
+			uint64_t memory[E_SUDOKU_METRICS_MEMORY_COUNT];
+			uint64_t expanded_nodes;
+		};
+
+		struct SSample
+		{
+			std::chrono::steady_clock::time_point time;
+			uint64_t boards;
+		};
+
+		static inline void _increment(std::atomic<uint64_t> &counter, uint64_t value)
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + value,
+						std::memory_order_relaxed);
+		}
+
+		static inline void _maximum(std::atomic<uint64_t> &counter, long value)
+		{
+			if (value > 0 && (uint64_t)value > counter.load(std::memory_order_relaxed))
+			{
+				counter.store(value, std::memory_order_relaxed);
+			}
+		}
+
+		void _get_totals(STotals *totals);
+
+		/**
+		 * @param totals
+		 * @param fraction (0, 1]
+		 * @return latency in microseconds under which there are fraction of
+		 * boards
+		 */
+		static double _get_percentile(const STotals &totals, double fraction);
+
+		/**
+		 * @param seconds window size
+		 * @return boards by second in the last seconds, 0 without samples
+		 */
+		double _get_throughput(unsigned int seconds);
+
+		long _get_queue_depth(void);
+
+		void _sample(void);
+
+		void _write_file(void);
+
+		void _reporter(void);
+
+		std::mutex m_mutex;
+
+		std::vector< std::unique_ptr<SThreadMetrics> > m_slots;
+
+		std::function<long(void)> m_queue_depth;
+
+		std::deque<SSample> m_samples;
+
+		std::string m_path;
+
+		unsigned int m_period;
+
+		bool m_stop;
+
+		std::condition_variable m_stop_cond;
+
+		std::thread m_reporter;
+
+		static std::atomic<bool> m_dump_requested;
+};
+
+} // namespace sudoku
+#endif // _SUDOKU_METRICS_HPP_
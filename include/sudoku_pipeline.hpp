@@ -0,0 +1,218 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_pipeline.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sudoku_pipeline.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _SUDOKU_PIPELINE_HPP_
+#define _SUDOKU_PIPELINE_HPP_
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+
+#include "cring_buffer.hpp"
+#include "sudoku_worker.hpp"
+#include "sudoku_lanes.hpp"
+#include "sudoku_metrics.hpp"
+#include "sudoku_portfolio.hpp"
+#include "sudoku_journal.hpp"
+
+namespace sudoku{
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSudokuPipeline
+ * @brief Batch solver for many boards in one stream. Reading, solving and
+ * writing are done at the same time in different stages:
+ *
+ *   reader ---> input queue ---> N solvers ---> output queue ---> writer
+ *
+ * Queues are bounded (see CRingBuffer), so a slow stage stops the previous
+ * one. Writer keeps the input order, and reader doesn't get more than
+ * "window" boards ahead of writer.
+ *
+ * With lockstep option, every solver takes up to E_SUDOKU_LANES_COUNT boards
+ * from input queue and propagates them together (see CSudokuLanes). Only
+ * boards which aren't solved by propagation are searched one by one. With
+ * portfolio option, every solver searches with a CSudokuPortfolio, so it uses
+ * one thread for each strategy.
+ *
+ * Latency of every board is recorded in metrics, if they are set. Latency of
+ * boards propagated in lockstep includes the whole group propagation.
+ *
+ * With a journal, every written board is added to it. A run with a journal
+ * which already has boards writes them again and goes on from the input
+ * offset after the last one, without solving them.
+ *
+ * With trace_sample option, the search of sampled boards is recorded and
+ * written in a trace file by its solver (see CSearchTrace). Boards solved in
+ * lockstep or by a portfolio aren't traced.
+ */
+class CSudokuPipeline
+{
+	public:
+
+		/**
+		 * @brief CSudokuPipeline constructor
+		 * @param solver_count number of solver threads, 0 means one by CPU
+		 * @param options search options of every solver
+		 * @param queue_capacity capacity of input and output queues
+		 */
+		CSudokuPipeline(unsigned int solver_count,
+			const SSudokuWorkerOptions &options = SSudokuWorkerOptions(),
+			size_t queue_capacity = 256);
+
+		virtual ~CSudokuPipeline(){};
+
+		/**
+		 * @brief Solve every board in input and write them in output
+		 * @param input boards in text format (see operator>>), it must be
+		 * seekable with a journal
+		 * @param output solved boards in the same order
+		 * @return number of boards read (and boards in journal), -1 if there
+		 * was any error in input
+		 */
+		long run(std::istream &input, std::ostream &output);
+
+		/**
+		 * @param metrics where boards are recorded, nullptr for none. It must
+		 * live until run() returns
+		 */
+		inline void set_metrics(CSudokuMetrics *metrics) { m_metrics = metrics; }
+
+		/**
+		 * @brief Boards starting at end position of input or after it
+		 * aren't read (see CSudokuShards)
+		 * @param end stream position, -1 reads until end of input
+		 */
+		inline void set_input_end(std::streamoff end) { m_input_end = end; }
+
+		/**
+		 * @brief Only boards accepted by filter are solved, the others are
+		 * skipped (see CSudokuShards). Boards are numbered after filter
+		 * @param filter bool(const CSudokuBoard &board), nullptr for all boards
+		 */
+		inline void set_input_filter(std::function<bool(const CSudokuBoard &)> filter)
+		{
+			m_input_filter = filter;
+		}
+
+		/**
+		 * @param journal progress journal, nullptr for none. It must live
+		 * until run() returns
+		 */
+		inline void set_journal(CSudokuJournal *journal) { m_journal = journal; }
+
+	private:
+
+		/**
+		 * Board moving through pipeline stages. Sequence -1 means end of input
+		 */
+		struct SBatchItem
+		{
+			long sequence;
+			int status;
+			int winner;		// E_SUDOKU_STRATEGY which solved it first, -1 none
+			std::streamoff input_offset;	// after board
+			SSearchStatistics statistics;
+			CSudokuBoard board;
+		};
+
+		void _reader(std::istream &input);
+
+		void _solver(void);
+
+		/**
+		 * @brief Solve a group of boards, first in lockstep
+		 * @param group
+		 * @param worker
+		 * @param portfolio it's used instead of worker, nullptr for none
+		 * @param lanes
+		 * @param slot metrics of this solver, nullptr for none
+		 */
+		void _solve_group(std::vector<SBatchItem> &group, CSudokuWorker &worker,
+						CSudokuPortfolio *portfolio, CSudokuLanes &lanes,
+						CSudokuMetrics::SThreadMetrics *slot);
+
+		/**
+		 * @brief Solve one board with search
+		 * @param item
+		 * @param worker
+		 * @param portfolio it's used instead of worker, nullptr for none
+		 * @param slot metrics of this solver, nullptr for none
+		 * @param shared_latency time spent in item before search
+		 */
+		void _solve_item(SBatchItem &item, CSudokuWorker &worker,
+						CSudokuPortfolio *portfolio,
+						CSudokuMetrics::SThreadMetrics *slot,
+						std::chrono::nanoseconds shared_latency = std::chrono::nanoseconds(0));
+
+		/**
+		 * @brief Write trace of one board search in its file
+		 * @param number of board in input
+		 * @param trace
+		 */
+		void _write_trace(long number, const CSearchTrace &trace) const;
+
+		void _writer(std::ostream &output);
+
+		/**
+		 * @brief Write the result of one board
+		 * @param output
+		 * @param number of board in input
+		 * @param status CSudokuWorker::E_SUDOKU_WORKER_RESULT
+		 * @param board solution or partial board
+		 */
+		static void _write_result(std::ostream &output, long number, int status,
+								const CSudokuBoard &board);
+
+		unsigned int m_solver_count;
+
+		SSudokuWorkerOptions m_options;
+
+		size_t m_window;
+
+		CRingBuffer<SBatchItem> m_input_queue;
+
+		CRingBuffer<SBatchItem> m_output_queue;
+
+		std::atomic<long> m_read_count;
+
+		std::atomic<long> m_written_count;
+
+		bool m_input_error;
+
+		CSudokuMetrics *m_metrics;
+
+		std::streamoff m_input_end;
+
+		std::function<bool(const CSudokuBoard &)> m_input_filter;
+
+		CSudokuJournal *m_journal;
+
+		// Number of first board read, boards before it are in journal
+		long m_first_number;
+};
+
+} // namespace sudoku
+#endif // _SUDOKU_PIPELINE_HPP_
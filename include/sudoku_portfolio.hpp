@@ -0,0 +1,174 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_portfolio.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file sudoku_portfolio.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _SUDOKU_PORTFOLIO_HPP_
+#define _SUDOKU_PORTFOLIO_HPP_
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "sudoku_worker.hpp"
+
+namespace sudoku{
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSudokuPortfolio
+ * @brief Race of several strategies on the same board, each one in its own
+ * worker and thread. The first solution wins and the rest of searches are
+ * cancelled (they share one CCancelToken). A search which ends without
+ * solution, and without being stopped or giving up (beam), proves the board
+ * is unsolvable and ends the race the same way. Different boards are faster with
+ * different strategies, so latency is close to the best strategy for every
+ * board, using one CPU for each strategy.
+ *
+ * First strategy runs in the calling thread, the others in persistent
+ * threads that wait for the next board. solve() returns when every search
+ * has stopped, so a portfolio must be used by only one thread at a time.
+ */
+class CSudokuPortfolio
+{
+	public:
+
+		/**
+		 * @brief CSudokuPortfolio constructor
+		 * @param options search options, options.portfolio are the raced
+		 * strategies (options.strategy if it's empty)
+		 */
+		explicit CSudokuPortfolio(const SSudokuWorkerOptions &options);
+
+		CSudokuPortfolio(const CSudokuPortfolio &original) = delete;
+		CSudokuPortfolio &operator=(const CSudokuPortfolio &original) = delete;
+
+		virtual ~CSudokuPortfolio();
+
+		/**
+		 * @brief Solve sudoku board with every strategy at the same time
+		 * @param puzzle initial sudoku board
+		 * @param solution solved sudoku board, or the deepest partial board
+		 * if it timed out
+		 * @param cancel external token which stops every search too, nullptr
+		 * for none
+		 * @return CSudokuWorker::E_SUDOKU_WORKER_RESULT of the first search
+		 * which solved the board or proved it's unsolvable, timed out if
+		 * every search stopped or gave up
+		 */
+		int solve(const CSudokuBoard &puzzle, CSudokuBoard &solution,
+				const CCancelToken *cancel = nullptr);
+
+		/**
+		 * @brief Solve sudoku board in 81 characters format
+		 * (see CSudokuWorker::solve)
+		 * @param puzzle 81 characters
+		 * @param solution 81 characters
+		 * @param cancel external token which stops every search too, nullptr
+		 * for none
+		 * @return CSudokuWorker::E_SUDOKU_WORKER_RESULT
+		 */
+		int solve(const char *puzzle, char *solution, const CCancelToken *cancel = nullptr);
+
+		/**
+		 * @return strategy which solved last board (or proved it's
+		 * unsolvable), only valid if it didn't time out
+		 */
+		inline E_SUDOKU_STRATEGY get_winner(void) const
+		{
+			return m_racers[m_winner]->strategy;
+		}
+
+		/**
+		 * @return statistics of the winner search, or of the first strategy
+		 * if last board timed out
+		 */
+		inline const SSearchStatistics &get_statistics(void) const
+		{
+			return m_racers[m_winner >= 0 ? m_winner : 0]->worker.get_statistics();
+		}
+
+		/**
+		 * @param strategy
+		 * @return number of boards solved first by strategy
+		 */
+		inline unsigned long get_wins(E_SUDOKU_STRATEGY strategy) const
+		{
+			return m_wins[strategy];
+		}
+
+	private:
+
+		struct SRacer
+		{
+			E_SUDOKU_STRATEGY strategy;
+			CSudokuWorker worker;
+			CSudokuBoard solution;
+			int result;
+			std::thread thread;
+
+			SRacer(E_SUDOKU_STRATEGY racer_strategy, const SSudokuWorkerOptions &options):
+				strategy(racer_strategy), worker(options),
+				result(CSudokuWorker::E_SUDOKU_WORKER_UNSOLVABLE)
+			{
+			}
+		};
+
+		/**
+		 * @brief Search with one racer and notify its result
+		 * @param racer index in m_racers
+		 */
+		void _race(unsigned int racer);
+
+		/**
+		 * @brief Thread of a racer, it waits for boards until destruction
+		 * @param racer index in m_racers
+		 */
+		void _racer_loop(unsigned int racer);
+
+		std::vector< std::unique_ptr<SRacer> > m_racers;
+
+		CCancelToken m_cancel;
+
+		std::mutex m_mutex;
+
+		std::condition_variable m_start_cond;
+
+		std::condition_variable m_done_cond;
+
+		const CSudokuBoard *m_puzzle;
+
+		unsigned long m_race;		// boards started, threads wait for a new one
+
+		unsigned int m_running;		// racers still searching
+
+		int m_winner;				// index of racer which solved the board or
+									// proved it's unsolvable, -1 none
+
+		bool m_stop;
+
+		unsigned long m_wins[E_SUDOKU_STRATEGY_COUNT];
+};
+
+} // namespace sudoku
+#endif // _SUDOKU_PORTFOLIO_HPP_
@@ -0,0 +1,144 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_session.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sudoku_session.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _SUDOKU_SESSION_HPP_
+#define _SUDOKU_SESSION_HPP_
+
+#include "sudoku_worker.hpp"
+
+namespace sudoku{
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSudokuSession
+ * @brief Incremental solver for a board edited one box at a time, like in
+ * an interactive game. Board restrictions are updated for every edit (see
+ * CSudokuBoard::setValorByXY) and last solution is kept:
+ *
+ *  - A new value equal to the value in last solution, or a removed value
+ *    when board was solved, keeps last solution without any search.
+ *  - Any other new value searches again keeping the failed nodes (nogoods)
+ *    of previous searches, they are still valid with more values. If board
+ *    was unsolvable, its empty nogood fails the new search at once.
+ *  - A changed value, or a removed value when board wasn't solved, searches
+ *    from scratch.
+ *
+ * A new session has an empty board and it hasn't searched yet, its result
+ * is timed out with the empty board as partial solution.
+ * A session must be used by only one thread at a time.
+ */
+class CSudokuSession
+{
+	public:
+
+		CSudokuSession(const SSudokuWorkerOptions &options = SSudokuWorkerOptions());
+
+		inline void set_options(const SSudokuWorkerOptions &options)
+		{
+			m_worker.set_options(options);
+		}
+
+		/**
+		 * @brief Start the session with a new board and solve it
+		 * @param puzzle initial sudoku board
+		 * @return CSudokuWorker::E_SUDOKU_WORKER_RESULT
+		 */
+		int load(const CSudokuBoard &puzzle);
+
+		/**
+		 * @brief Start the session with a board in 81 characters format
+		 * (see CSudokuBoard::load_from_buffer) and solve it
+		 * @param puzzle 81 characters
+		 * @return CSudokuWorker::E_SUDOKU_WORKER_RESULT, if it's invalid the
+		 * session isn't changed
+		 */
+		int load(const char *puzzle);
+
+		/**
+		 * @brief Edit one box and solve board again if it's needed
+		 * @param valor [1-9], 0 removes box value
+		 * @param posX row
+		 * @param posY column
+		 * @return CSudokuWorker::E_SUDOKU_WORKER_RESULT, it's invalid if valor
+		 * or position are out of range or valor breaks rules, then board
+		 * isn't changed
+		 */
+		int set_value(short int valor, short int posX, short int posY);
+
+		/**
+		 * @return board with every edit
+		 */
+		inline const CSudokuBoard &get_puzzle(void) const { return m_puzzle; }
+
+		/**
+		 * @return solution of board, or the deepest partial board if last
+		 * search timed out. Only valid if result isn't unsolvable
+		 */
+		inline const CSudokuBoard &get_solution(void) const { return m_solution; }
+
+		/**
+		 * @return CSudokuWorker::E_SUDOKU_WORKER_RESULT of board now
+		 */
+		inline int get_result(void) const { return m_result; }
+
+		/**
+		 * @return number of searches done in this session, edits solved from
+		 * last solution don't search
+		 */
+		inline unsigned long get_searches(void) const { return m_searches; }
+
+		/**
+		 * @return statistics of last search
+		 */
+		inline const SSearchStatistics &get_statistics(void) const
+		{
+			return m_worker.get_statistics();
+		}
+
+	private:
+
+		/**
+		 * @brief Search solution of m_puzzle, visited store of last search
+		 * is kept if m_keep_visited is true
+		 * @return result
+		 */
+		int _solve(void);
+
+		CSudokuWorker m_worker;
+
+		CSudokuBoard m_puzzle;
+
+		CSudokuBoard m_solution;
+
+		int m_result;
+
+		unsigned long m_searches;
+
+		// Visited store of last search is valid for m_puzzle, it only has
+		// new values since then
+		bool m_keep_visited;
+};
+
+} // namespace sudoku
+#endif // _SUDOKU_SESSION_HPP_
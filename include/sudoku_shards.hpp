@@ -0,0 +1,169 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_shards.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sudoku_shards.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _SUDOKU_SHARDS_HPP_
+#define _SUDOKU_SHARDS_HPP_
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "sudoku_pipeline.hpp"
+
+namespace sudoku{
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief How boards of a batch file are split in shards
+ */
+enum E_SUDOKU_SHARDING
+{
+	/** Shard k has the boards which start in byte range
+	 * [k * size / N, (k + 1) * size / N). Every shard reads only its range */
+	E_SUDOKU_SHARDING_RANGE = 0,
+	/** Shard k has the boards whose hash is k modulo N. Every shard reads
+	 * the whole file, but a sorted or clustered file is spread evenly */
+	E_SUDOKU_SHARDING_HASH
+};
+
+/**
+ * @brief Get sharding by its name: range or hash
+ * @param name
+ * @param sharding
+ * @return false unknown name
+ */
+bool get_sharding_by_name(const std::string &name, E_SUDOKU_SHARDING *sharding);
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSudokuShards
+ * @brief Batch file solved by several processes, one for each shard. The
+ * partition only depends on the file and the number of shards, so every
+ * shard can be solved by a process in other host which reads the file from
+ * shared storage, and outputs are merged later in input order:
+ *
+ *   sudoku_solver -b boards.txt -n 4 -k 0 -g /shared/out     (one by shard)
+ *   sudoku_solver -b boards.txt -n 4 -J -g /shared/out       (merge)
+ *
+ * Output of shard k is in file prefix.k, in batch output format (see
+ * CSudokuPipeline). Boards are numbered in shard order there, merge writes
+ * them with their number in input.
+ *
+ * run() is the local reference: one child process for each shard and then
+ * merge. Time of every shard is written in stderr to find skew.
+ */
+class CSudokuShards
+{
+	public:
+
+		/**
+		 * @brief CSudokuShards constructor
+		 * @param batch_file_name boards in text format (see operator>>)
+		 * @param count number of shards
+		 * @param sharding
+		 */
+		CSudokuShards(const std::string &batch_file_name, unsigned int count,
+					E_SUDOKU_SHARDING sharding);
+
+		/**
+		 * @brief Solve boards of one shard. Boards and time are written in
+		 * stderr
+		 * @param index shard [0, count)
+		 * @param pipeline solver of boards
+		 * @param output solved boards
+		 * @return number of boards read, -1 if there was any error
+		 */
+		long solve(unsigned int index, CSudokuPipeline &pipeline, std::ostream &output);
+
+		/**
+		 * @brief Merge outputs of every shard in input order
+		 * @param prefix output of shard k is in file prefix.k
+		 * @param output merged boards
+		 * @param counts if it isn't nullptr, boards of every shard
+		 * @return false missing output file or any shard hasn't got all its
+		 * boards
+		 */
+		bool merge(const std::string &prefix, std::ostream &output,
+					std::vector<long> *counts = nullptr);
+
+		/**
+		 * @brief Solve every shard in its own child process and merge their
+		 * outputs
+		 * @param prefix output of shard k is written in file prefix.k, if
+		 * it's empty they are temporary files removed after merge
+		 * @param worker_count solver threads of every shard, 0 means CPUs
+		 * divided between shards
+		 * @param options search options of every solver
+		 * @param output merged boards
+		 * @return 0 all is OK, -1 any shard failed
+		 */
+		int run(const std::string &prefix, unsigned int worker_count,
+				const SSudokuWorkerOptions &options, std::ostream &output);
+
+		/**
+		 * @param board
+		 * @param count number of shards
+		 * @return shard of board with hash sharding
+		 */
+		static unsigned int get_board_shard(const CSudokuBoard &board, unsigned int count);
+
+		/**
+		 * @brief Find the first board which starts at offset or after it.
+		 * Boards must be in the format written by operator<< (separator
+		 * lines after rows 3 and 6), the separators show where they start
+		 * @param input batch file
+		 * @param offset
+		 * @param size of input
+		 * @return board start, size if there isn't any
+		 */
+		static std::streamoff find_board_start(std::istream &input,
+											std::streamoff offset, std::streamoff size);
+
+		/**
+		 * @param prefix
+		 * @param index
+		 * @return output file name of shard index
+		 */
+		static std::string get_file_name(const std::string &prefix, unsigned int index);
+
+	private:
+
+		/**
+		 * @brief Read the output of one board (see CSudokuPipeline::_writer)
+		 * @param input shard output
+		 * @param first first line, it has board number if it isn't solved
+		 * @param rest the other lines
+		 * @return false end of input or incomplete output
+		 */
+		static bool _read_output(std::istream &input, std::string *first, std::string *rest);
+
+		std::string m_batch_file_name;
+
+		unsigned int m_count;
+
+		E_SUDOKU_SHARDING m_sharding;
+};
+
+} // namespace sudoku
+#endif // _SUDOKU_SHARDS_HPP_
@@ -0,0 +1,177 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_solutions.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sudoku_solutions.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _SUDOKU_SOLUTIONS_HPP_
+#define _SUDOKU_SOLUTIONS_HPP_
+
+#include <cstdint>
+
+#include "sudoku_tables.hpp"
+
+namespace sudoku{
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSudokuSolutions
+ * @brief Enumeration of every solution of a board, one at a time. It's a
+ * depth-first search which is stopped after every solution and resumed by the
+ * next call, so memory is constant: the search stack has one entry for each
+ * empty box, with the values not tried yet in it.
+ *
+ * CNode search is made to find one solution of a hard board (safe rules,
+ * nogoods), here every step must be cheap: boards are bit masks of used
+ * values by unit (like CSudokuLanes) and the empty box with less possible
+ * values is chosen in every step, without other rules.
+ *
+ * Usage:
+ *
+ *   CSudokuSolutions solutions;
+ *   if (solutions.start(puzzle))
+ *       while (solutions.next()) use(solutions.get_solution());
+ *
+ * or solutions.for_each(consumer, limit).
+ */
+class CSudokuSolutions
+{
+	public:
+
+		CSudokuSolutions();
+
+		virtual ~CSudokuSolutions(){};
+
+		/**
+		 * @param layout
+		 * @return true solutions of boards with layout can be enumerated,
+		 * only classic layout is supported (see CSudokuLayout)
+		 */
+		static inline bool is_supported(const CSudokuLayout &layout)
+		{
+			return layout.is_classic();
+		}
+
+		/**
+		 * @brief Start enumeration of puzzle solutions
+		 * @param puzzle
+		 * @return false any value is repeated in a unit, or puzzle layout
+		 * isn't supported (see is_supported)
+		 */
+		bool start(const CSudokuBoard &puzzle);
+
+		/**
+		 * @brief Find next solution
+		 * @return false there aren't more solutions
+		 */
+		bool next(void);
+
+		/**
+		 * @return last solution found by next(), 81 characters '1' to '9'
+		 * (see CSudokuBoard::load_from_buffer), without end of string
+		 */
+		inline const char *get_solution(void) const { return m_values; }
+
+		/**
+		 * @return solutions found since start()
+		 */
+		inline uint64_t get_count(void) const { return m_count; }
+
+		/**
+		 * @brief Pass next solutions to consumer until it returns false, or
+		 * there aren't more solutions, or limit solutions are passed
+		 * @param consumer bool(const char *solution), see get_solution()
+		 * @param limit max solutions, 0 unlimited
+		 * @return solutions passed to consumer
+		 */
+		template <class Consumer>
+		uint64_t for_each(Consumer consumer, uint64_t limit = 0)
+		{
+			uint64_t count = 0;
+
+			while ((limit == 0 || count < limit) && next())
+			{
+				count++;
+				if (!consumer(get_solution())) break;
+			}
+			return count;
+		}
+
+		/**
+		 * @param limit max solutions, 0 unlimited
+		 * @return number of solutions found, up to limit
+		 */
+		inline uint64_t count(uint64_t limit = 0)
+		{
+			return for_each([](const char *) { return true; }, limit);
+		}
+
+	private:
+
+		/**
+		 * @return values not used in the units of box
+		 */
+		inline uint16_t _get_possible(int box) const
+		{
+			const unsigned char *units = sudoku_tables.box_units[box];
+			return ~(m_used[units[0]] | m_used[units[1]] | m_used[units[2]]) &
+					ALL_VALUES;
+		}
+
+		/**
+		 * @brief Set the next value not tried in the box of stack top, and
+		 * push it
+		 */
+		void _push_value(void);
+
+		/**
+		 * @brief Pop values from stack until a box has values not tried yet,
+		 * its next value is set
+		 * @return false stack is empty, enumeration has finished
+		 */
+		bool _backtrack(void);
+
+		// Bit v is value v
+		static const uint16_t ALL_VALUES = 0x3FE;
+
+		uint16_t m_used[E_SUDOKU_UNIT_COUNT];
+
+		char m_values[E_SUDOKU_BOX_COUNT];
+
+		// Empty boxes of puzzle, [0, m_depth) are set in search order
+		unsigned char m_empty[E_SUDOKU_BOX_COUNT];
+
+		unsigned int m_empty_count;
+
+		// Values not tried yet in every set empty box
+		uint16_t m_untried[E_SUDOKU_BOX_COUNT];
+
+		unsigned int m_depth;
+
+		bool m_found;	// last next() returned a solution
+
+		bool m_finished;
+
+		uint64_t m_count;
+};
+
+} // namespace sudoku
+#endif // _SUDOKU_SOLUTIONS_HPP_
@@ -29,6 +29,8 @@
 #include <vector>
 #include <iostream>
 #include <cstring>
+#include <string>
+#include <bitset>
 
 namespace sudoku{
 
@@ -37,16 +39,19 @@ enum E_SUDOKU
 	E_SUDOKU_DIM = 9,
 	E_SUDOKU_SQUARE_DIM = 3,
 	E_SUDOKU_BOX_COUNT = 81,
-	E_SUDOKU_BOX_STATES_COUNT = 10
+	E_SUDOKU_BOX_STATES_COUNT = 10,
+	E_SUDOKU_HEURISTIC_DEAD_END = E_SUDOKU_BOX_COUNT * E_SUDOKU_DIM + 1
 };
 
 };
 
 #include "cnode.hpp"
+#include "sudoku_layout.hpp"
 
 namespace sudoku{
 
 class CSudokuBoard;
+struct SSudokuChildren;
 
 ////////////////////////////////////////////////////////////////////////////////
 /**
@@ -60,11 +65,8 @@ class CSudokuBox
 
 		CSudokuBox();
 		CSudokuBox(short int valor);
-		CSudokuBox(const CSudokuBox &original);
-		CSudokuBox& operator=(const CSudokuBox &original);
 		bool setValor(short int valor);
 		inline short int getValor() const { return _valor;}
-		virtual ~CSudokuBox(){};
 
 	private:
 
@@ -72,81 +74,15 @@ class CSudokuBox
 		short int _valor;
 };
 
-////////////////////////////////////////////////////////////////////////////////
-CSudokuBox::CSudokuBox()
-{
-	_valor=0;
-	for(int i = 0; i < E_SUDOKU_BOX_STATES_COUNT; i++) _posiblesValores[i] = true;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-CSudokuBox::CSudokuBox(short int valor)
-{
-					 
-	if( (valor < 1) || (valor > 9) ){
-		_valor=0;
-		for(int i = 0; i< E_SUDOKU_BOX_STATES_COUNT; i++)
-			_posiblesValores[i] = true;
-	}
-	else
-	{
-		_valor = valor;
-		for(int i = 0; i < E_SUDOKU_BOX_STATES_COUNT; i++)
-			_posiblesValores[i] = true;
-
-		_posiblesValores[0]=false;
-		_posiblesValores[valor]=false;
-	}
-}
-
-////////////////////////////////////////////////////////////////////////////////
-CSudokuBox::CSudokuBox(const CSudokuBox &original)
-{
-	*this = original;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-CSudokuBox& CSudokuBox::operator=(const CSudokuBox &original)
-{
-	if (this == &original) return *this;
-
-	this->_valor = original._valor;
-	for(int i = 0; i < E_SUDOKU_BOX_STATES_COUNT; i++)
-		this->_posiblesValores[i] = original._posiblesValores[i];
-
-	return *this;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-bool CSudokuBox::setValor(short int valor)
-{
-	if( (valor < 0) || (valor > 9) ) return false;
-
-	if(valor == 0)
-	{
-		_posiblesValores[_valor]=true;
-		_valor = valor;
-		_posiblesValores[0]=true;
-		return true;
-	}
-	else
-	{
-		_posiblesValores[_valor]=true;
-		_valor = valor;
-		_posiblesValores[valor]=false;
-		_posiblesValores[0]=false;
-		return true;
-	}
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 /**
  * @class CSudokuBoard
+ * @brief Sudoku board, its rules come from its layout (see CSudokuLayout)
  */
 class CSudokuBoard
 {
-	friend bool diferentes(CSudokuBoard primero,CSudokuBoard segundo);
-	friend bool diferentes2(CSudokuBoard primero,CSudokuBoard segundo);
+	friend bool diferentes(const CSudokuBoard &primero, const CSudokuBoard &segundo);
+	friend bool diferentes2(const CSudokuBoard &primero, const CSudokuBoard &segundo);
 
 	public:
 
@@ -173,17 +109,12 @@ class CSudokuBoard
 		short int getValorByXY(short int posX, short int posY) const;
 
 		/**
-		 * Copy constructor
-		 * @param original
-		 */
-		CSudokuBoard(const CSudokuBoard &original);
-
-		/**
-		 * Copy operator
-		 * @param original
-		 * @return
+		 * Board is trivially copyable, copies and moves are plain memory copies
 		 */
-		CSudokuBoard &operator=(const CSudokuBoard &original);
+		CSudokuBoard(const CSudokuBoard &original) = default;
+		CSudokuBoard(CSudokuBoard &&original) = default;
+		CSudokuBoard &operator=(const CSudokuBoard &original) = default;
+		CSudokuBoard &operator=(CSudokuBoard &&original) = default;
 
 		/**
 		 * Check if a number in board is complete, or si all
@@ -196,6 +127,12 @@ class CSudokuBoard
 		// y numero de 1 a 9 por su correpondiente
 		bool is_complete(short int value) const;
 
+		/**
+		 * @brief Recompute complete flags, only for microbenchmarks
+		 * (tools/sudoku_bench.cpp), boards keep them updated
+		 */
+		inline void bench_update_complete(void) { _update_complete(); }
+
 		/**
 		 * Check sudoku rules when I want to insert value in position posX, posY
 		 * @param valor
@@ -223,22 +160,124 @@ class CSudokuBoard
 			return m_occupiedBoxCount;
 		}
 
+		/**
+		 * @brief Search heuristic, lower is better: number of possible values
+		 * in all empty boxes. An empty box without possible values can't be
+		 * solved, it returns E_SUDOKU_HEURISTIC_DEAD_END
+		 * @return
+		 */
+		int get_heuristic(void) const;
+
 		/**
 		 *
 		 * @param soluciones
-		 * @param visitados
+		 * @param context
 		 * @return
 		 */
 		bool generateChildrens(std::vector<CSudokuBoard> *soluciones,
-				  	  	  	  	  	std::vector<CSudokuBoard> **visitados) const
+				  	  	  	  	  	CSearchContext<CSudokuBoard> *context) const
+		{
+			return this->generateSudokuBoardChildrens(soluciones, context, *this);
+		}
+
+		/**
+		 * @brief State of a lazy children generation, see beginChildrens
+		 */
+		typedef SSudokuChildren children_cursor;
+
+		/**
+		 * @brief Start a lazy generation of the children of generateChildrens:
+		 * safe rules are applied here, and then every nextChildren call
+		 * builds only one child. Board can change after this call
+		 * @param cursor
+		 * @param context
+		 * @return false there aren't children (complete or dead board, or
+		 * stopped search)
+		 */
+		bool beginChildrens(SSudokuChildren *cursor,
+							CSearchContext<CSudokuBoard> *context) const;
+
+		/**
+		 * @brief Next child of a lazy generation, boards in visited store are
+		 * skipped
+		 * @param cursor started by beginChildrens
+		 * @param child
+		 * @param context
+		 * @return false there aren't more children
+		 */
+		static bool nextChildren(SSudokuChildren *cursor, CSudokuBoard *child,
+								CSearchContext<CSudokuBoard> *context);
+
+		/**
+		 * @brief Nogood of a failed board: the values which make it fail, as
+		 * a board with only those values. Every board which includes them
+		 * fails too. Givens and values set by safe rules aren't included,
+		 * they follow from decisions (values tried in probable children). If
+		 * safe rules find a contradiction, decisions which aren't needed for
+		 * it are removed too, the last one first
+		 * @return nogood board
+		 */
+		CSudokuBoard get_nogood(void) const;
+
+		/**
+		 * @param nogood
+		 * @return true every value of nogood is in this board
+		 */
+		inline bool includes(const CSudokuBoard &nogood) const
 		{
-			return this->generateSudokuBoardChildrens(soluciones, visitados, *this);
+			return !diferentes2(nogood, *this);
 		}
 
+		/**
+		 * @brief Change layout of an empty board
+		 * @param layout it must live longer than board and its copies
+		 */
+		inline void set_layout(const CSudokuLayout *layout) { m_layout = layout; }
+
+		inline const CSudokuLayout &get_layout(void) const { return *m_layout; }
+
+		/**
+		 * @param box number, row * E_SUDOKU_DIM + column (see sudoku_tables.hpp)
+		 * @return value of box, 0 if it's empty
+		 */
+		inline short int get_valor(int box) const { return _box(box).getValor(); }
+
+		/**
+		 * @param box number
+		 * @param valor [1-9]
+		 * @return true valor is possible in box, only valid in empty boxes
+		 */
+		inline bool is_possible(int box, short int valor) const
+		{
+			return _box(box)._posiblesValores[valor];
+		}
+
+		/**
+		 * @return box of the last value tried in a probable child, -1 if
+		 * there isn't any
+		 */
+		inline int get_last_decision(void) const { return m_last_decision; }
+
+		/**
+		 * @brief Load board from a buffer of 81 characters, row by row.
+		 * Characters '1' to '9' are values, '0' and '.' are empty boxes.
+		 * Previous board is replaced
+		 * @param buffer
+		 * @return true all is OK, false invalid character or rules violation
+		 */
+		bool load_from_buffer(const char *buffer);
+
+		/**
+		 * @brief Save board into a buffer of 81 characters, row by row.
+		 * Empty boxes are written as '0'
+		 * @param buffer
+		 */
+		void save_to_buffer(char *buffer) const;
+
 	private:
 
 		bool generateSudokuBoardChildrens(std::vector<CSudokuBoard> *solutions,
-				  	  	  	  	  	std::vector<CSudokuBoard> **visited,
+				  	  	  	  	  	CSearchContext<CSudokuBoard> *context,
 									const CSudokuBoard& primero) const;
 
 		/**
@@ -248,405 +287,142 @@ class CSudokuBoard
 		// significa completo entero
 		void _update_complete();
 
-		int m_occupiedBoxCount;
-
-		CSudokuBox _boardBoxes[E_SUDOKU_DIM][E_SUDOKU_DIM];
-
-		bool _completo[E_SUDOKU_BOX_STATES_COUNT];
-
-};
-
-////////////////////////////////////////////////////////////////////////////////
-std::istream& operator>>(std::istream &input, CSudokuBoard &o)
-{
-	unsigned int current_row = 0;
-	unsigned int file_row = 0;
-
-	short int value[9];
-	memset(value, 0, sizeof(short int) * E_SUDOKU_DIM);
-
-	char separator[2] = {'\0', '\0'};
-	std::string line_separator;
+		/**
+		 * @param box number, row * E_SUDOKU_DIM + column (see sudoku_tables.hpp)
+		 */
+		inline CSudokuBox &_box(int box) { return (&_boardBoxes[0][0])[box]; }
 
-	while (current_row < E_SUDOKU_DIM)
-	{
-		if (file_row > 0 &&
-			file_row < 11 &&
-			(file_row + 1) % 4 == 0)
-		{
-			input >> line_separator;
-		}
-		else
-		{
-			input >> value[0] >> value[1] >> value[2] >> separator[0] >>
-					value[3] >> value[4] >> value[5] >> separator[1] >>
-					value[6] >> value[7] >> value[8];
-
-			for (unsigned int uiI = 0; uiI < E_SUDOKU_DIM; uiI++)
-			{
-				if (!o.setValorByXY(value[uiI], current_row, uiI))
-				{
-					std::cerr << "Error file_row: " << file_row << std::endl;
-					std::cerr << "Error current_row: " << current_row << std::endl;
-					std::cerr << "Error current_column: " << uiI << std::endl;
-
-					input.setstate(std::ios_base::badbit);
-				    return input;
-				}
-			}
-
-			current_row++;
-		}
-		file_row++;
-	}
+		inline const CSudokuBox &_box(int box) const { return (&_boardBoxes[0][0])[box]; }
 
-    return input;
-}
+		/**
+		 * @brief Set value in a box, like setValorByXY
+		 * @param box number
+		 * @param valor [0-9]
+		 * @return false valor isn't possible in box
+		 */
+		bool _set_valor(int box, short int valor);
 
-////////////////////////////////////////////////////////////////////////////////
-std::ostream& operator<<(std::ostream &output, const CSudokuBoard &o)
-{
-	unsigned int current_row = 0;
-	unsigned int file_row = 0;
+		/**
+		 * @brief Set every value which is possible in only one box of a unit
+		 * (row, column or square)
+		 * @param unit number (see sudoku_tables.hpp)
+		 * @param dead set to true if a value hasn't got possible box in unit
+		 * @return true some value was set
+		 */
+		bool _set_single_places(int unit, bool *dead);
 
-	short int value[E_SUDOKU_DIM];
-	memset(value, 0, sizeof(short int) * E_SUDOKU_DIM);
+		/**
+		 * @brief Remove possible values of cage boxes which aren't in any
+		 * set of values with the sum of cage
+		 * @param dead set to true if a cage hasn't got any set of values
+		 * @return true some possible value was removed
+		 */
+		bool _restrict_cages(bool *dead);
 
-	char separator = '|';
-	const std::string line_separator = "---------------------";
+		/**
+		 * @brief Apply safe rules until no value is set: only one possible
+		 * value in a box, and only one possible box for a value in a unit
+		 * (square, row, column or extra unit of layout), and killer cage
+		 * sums. It stops when a contradiction is found
+		 * @param dead set to true if an empty box hasn't got possible values,
+		 * or a value hasn't got possible box in a unit
+		 * @return true some value was set
+		 */
+		bool _propagate(bool *dead);
 
-	output << "SUDOKU BOARD (" << o.get_occupiedBoxCount() << ")" << std::endl;
+		/**
+		 * @brief Possible values of current box of cursor, sorted by children
+		 * order of context
+		 * @param cursor
+		 * @param context
+		 */
+		static void _load_values(SSudokuChildren *cursor,
+								CSearchContext<CSudokuBoard> *context);
 
-	while (current_row < E_SUDOKU_DIM)
-	{
-		if (file_row > 0 &&
-			file_row < 11 &&
-			(file_row + 1) % 4 == 0)
+		/**
+		 * @brief Value of box was tried in a probable child
+		 * @param box number
+		 */
+		inline void _set_decision(int box)
 		{
-			output << line_separator << std::endl;
+			m_decisions.set(box);
+			m_last_decision = box;
 		}
-		else
-		{
-			for (unsigned int uiI = 0; uiI < E_SUDOKU_DIM; uiI++)
-			{
-				value[uiI] = o.getValorByXY(current_row, uiI);
-			}
 
-			output << value[0] << " " << value[1] << " " << value[2] << " " << separator << " " <<
-					value[3] << " " << value[4] << " " << value[5] << " " << separator << " " <<
-					value[6] << " " << value[7] << " " << value[8] << std::endl;
+		/**
+		 * @param boxes
+		 * @return board with only the values of boxes
+		 */
+		CSudokuBoard _get_values(const std::bitset<E_SUDOKU_BOX_COUNT> &boxes) const;
 
-			current_row++;
-		}
-		file_row++;
-	}
+		/**
+		 * @brief valor isn't possible in box and in its peers
+		 * @param box number
+		 * @param valor
+		 */
+		void _restrict(int box, short int valor);
 
-    return output;
-}
+		/**
+		 * @brief Compute again where valor is possible, in every box
+		 * @param valor
+		 */
+		void _update_restrictions(short int valor);
 
-////////////////////////////////////////////////////////////////////////////////
-CSudokuBoard::CSudokuBoard()
-{
-	for(int i = 0;i < E_SUDOKU_BOX_STATES_COUNT; i++)
-	{
-		this->_completo[i] = false;
-	}
-	m_occupiedBoxCount = 0;
-}
+		int m_occupiedBoxCount;
 
-////////////////////////////////////////////////////////////////////////////////
-CSudokuBoard::CSudokuBoard(const CSudokuBoard &original)
-{
-	*this = original;
-}
+		CSudokuBox _boardBoxes[E_SUDOKU_DIM][E_SUDOKU_DIM];
 
-////////////////////////////////////////////////////////////////////////////////
-CSudokuBoard& CSudokuBoard::operator=(const CSudokuBoard &original)
-{
-	if (this == &original) return *this;
-
-	int i,j;
-	this->m_occupiedBoxCount = original.m_occupiedBoxCount;
-	for(i = 0; i < E_SUDOKU_DIM; i++)
-	{
-		for(j = 0; j < E_SUDOKU_DIM; j++)
-			this->_boardBoxes[i][j] = original._boardBoxes[i][j];
-	}
-	for(i = 0; i < E_SUDOKU_BOX_STATES_COUNT; i++)
-	{
-		this->_completo[i] = original._completo[i];
-	}
-
-	return *this;
-}
+		bool _completo[E_SUDOKU_BOX_STATES_COUNT];
 
-////////////////////////////////////////////////////////////////////////////////
-short int CSudokuBoard::getValorByXY(short int posX, short int posY) const
-{
-	
-	if( (posX < 0) || (posX > 8) || (posY < 0) || (posY > 8) )
-	{
-		return -1;
-	}
-	else
-	{
-		return _boardBoxes[posX][posY].getValor();
-	}
-}
+		// Boxes set in probable children, and boxes set by safe rules
+		std::bitset<E_SUDOKU_BOX_COUNT> m_decisions;
 
-////////////////////////////////////////////////////////////////////////////////
-// Funcion para establecer valores en el tablero
-// Se tienen en cuenta 3 posibilidades:
-//		1- Si pasa de un valor [1-9] a un valor 0.
-//		2- Si pasa de valor 0 a un valor [1-9].
-//		3- Si pasa de valor [1-9] a un valor [1-9].
-bool CSudokuBoard::setValorByXY(short int valor, short int posX, short int posY)
-{
-	// -------------------------------------------------------------------------
-	// Check limits and values
-	if( (valor<0) || (valor>9) || (posX<0) || (posX>8) || (posY<0) || (posY>8) )
-		return false;
-
-	// -------------------------------------------------------------------------
-	// 0- Pure initialization, nothing to do
-		if( valor == 0 && _boardBoxes[posX][posY].getValor() == 0 ) return true;
-
-	// -------------------------------------------------------------------------
-	// 1- If value is in [1-9] and it will be set to undetermined (0),
-	// I have to remove restrictions
-	if( valor == 0 && _boardBoxes[posX][posY].getValor() !=0 )
-	{
-		int i,j,k,l;
-		int valor_antiguo = _boardBoxes[posX][posY].getValor();
-		
-		if( !_boardBoxes[posX][posY].setValor(valor)) return false;
-
-		m_occupiedBoxCount--;
-
-		//Quita las restricciones en los valores posibles para valor antiguo
-    	
-    	// Pongo todo el tablero a true para ese valor
-    	for(i = 0; i < E_SUDOKU_DIM; i++)
-    	{
-    		for(j = 0; j< E_SUDOKU_DIM ;j++)
-    		{
-				_boardBoxes[i][j]._posiblesValores[valor_antiguo] = true;
-			}
-		}
-		// Establezco la restricciones en todo el tablero de nuevo para ese valor_antiguo
-    	for(i = 0; i < E_SUDOKU_DIM; i++)
-    	{
-    		for(j = 0; j < E_SUDOKU_DIM; j++)
-    		{
-				if( _boardBoxes[i][j].getValor() == valor_antiguo )
-				{
-					for(k = 0; k < (E_SUDOKU_BOX_STATES_COUNT - 1); k++)
-					{
-						_boardBoxes[i][k]._posiblesValores[valor_antiguo] = false;
-						_boardBoxes[k][j]._posiblesValores[valor_antiguo] = false;
-					}
-
-					int cuadvert = j / E_SUDOKU_SQUARE_DIM;
-					int cuadhori = i / E_SUDOKU_SQUARE_DIM;
-
-					for(k = 0; k < E_SUDOKU_SQUARE_DIM; k++)
-					{
-						for(l = 0; l < E_SUDOKU_SQUARE_DIM; l++)
-						{
-							_boardBoxes[cuadhori * E_SUDOKU_SQUARE_DIM + k]
-										[cuadvert * E_SUDOKU_SQUARE_DIM + l].
-											_posiblesValores[valor_antiguo] = false;
-						
-						}
-					}
-				}
-			}
-		}
-
-		// Actualiza los numeros completos
-    	this->_update_complete();
-    	return true;
-	}
+		std::bitset<E_SUDOKU_BOX_COUNT> m_derived;
 
-	// -------------------------------------------------------------------------
-	// 2- If value move from undetermined to [1-9]. I have to put restrictions
-	if( valor != 0 && _boardBoxes[posX][posY].getValor() == 0)
-	{
-		if(!rulesCheck(valor,posX,posY) )
-		{
-			return false;
-		}
-		else
-		{
-			int i,j;
-			// Set value in board box
-			if( !_boardBoxes[posX][posY].setValor(valor)) return false;
-
-			m_occupiedBoxCount++;
-			
-			//Pone las restricciones en los valores posibles
-    		
-			// Ver el cuadrante que ocupa:
-			// Horizontal
-			int cuadhori = posX / E_SUDOKU_SQUARE_DIM;
-			// Vertical
-			int cuadvert = posY / E_SUDOKU_SQUARE_DIM;
-
-    		// Set restrictions in square
-    		for(i = 0; i < E_SUDOKU_SQUARE_DIM; i++)
-    		{
-    			for(j = 0; j < E_SUDOKU_SQUARE_DIM; j++)
-    			{
-    				_boardBoxes[cuadhori * E_SUDOKU_SQUARE_DIM + i]
-								[cuadvert * E_SUDOKU_SQUARE_DIM + j].
-									_posiblesValores[valor] = false;
-    			}
-    		}
-
-    		// Set restrictions of column and row
-    		for(i = 0; i < E_SUDOKU_DIM; i++)
-    		{
-    			_boardBoxes[posX][i]._posiblesValores[valor] = false;
-    			_boardBoxes[i][posY]._posiblesValores[valor] = false;
-    		}
-
-			// Actualiza los numeros completos
-    		this->_update_complete();
-
-    		return true;
-		}
-	}
+		short int m_last_decision;	// -1 none
 
-	// -------------------------------------------------------------------------
-	// 3- If value move from [1-9] to [1-9], I have to change restrictions
-	if( valor != 0 && _boardBoxes[posX][posY].getValor() != 0)
-	{
-		if(!rulesCheck(valor,posX,posY) )
-		{
-			return false;
-		}
-		else
-		{
-			int i,j,k,l,cuadvert,cuadhori;
-			// recoge el valor antiguo
-			int valor_antiguo = _boardBoxes[posX][posY].getValor();
-
-			// Pone el valor en el tablero
-			if( !_boardBoxes[posX][posY].setValor(valor)) return false;
-
-    	// Pongo todo el tablero a true para ese valor_antiguo
-    	for(i = 0; i < E_SUDOKU_DIM; i++)
-    	{
-    		for(j = 0; j < E_SUDOKU_DIM; j++)
-    		{
-				_boardBoxes[i][j]._posiblesValores[valor_antiguo] = true;
-			}
-		}
-		
-		// Establezco la restricciones en todo el tablero de nuevo
-    	for(i = 0; i < E_SUDOKU_DIM; i++)
-    	{
-    		for(j = 0; j < E_SUDOKU_DIM; j++)
-    		{
-				if( _boardBoxes[i][j].getValor() == valor_antiguo )
-				{
-					for(k = 0; k < (E_SUDOKU_BOX_STATES_COUNT - 1); k++)
-					{
-						_boardBoxes[i][k]._posiblesValores[valor_antiguo] = false;
-						_boardBoxes[k][j]._posiblesValores[valor_antiguo] = false;
-					}
-					cuadhori = i / E_SUDOKU_SQUARE_DIM;
-					cuadvert = j / E_SUDOKU_SQUARE_DIM;
-					for(k = 0;k < E_SUDOKU_SQUARE_DIM; k++)
-					{
-						for(l = 0; l < E_SUDOKU_SQUARE_DIM; l++)
-						{
-							_boardBoxes[cuadhori * E_SUDOKU_SQUARE_DIM + k]
-										[cuadvert * E_SUDOKU_SQUARE_DIM + l].
-											_posiblesValores[valor_antiguo] = false;
-						
-						}
-					}
-				}
-			}
-		}
+		const CSudokuLayout *m_layout;
 
-		//Pone las restricciones en los valores posibles con el valor nuevo
-    	
-		// Ver el cuadrante que ocupa:
-		// Horizontal
-		cuadhori = posX / E_SUDOKU_SQUARE_DIM;
-		// Vertical
-		cuadvert = posY / E_SUDOKU_SQUARE_DIM;
-
-    	// Restricciones de cuadrante
-    	for(i = 0; i < E_SUDOKU_SQUARE_DIM; i++)
-    	{
-    		for(j = 0; j < E_SUDOKU_SQUARE_DIM; j++)
-    		{
-    			_boardBoxes[cuadhori * E_SUDOKU_SQUARE_DIM + i]
-							[cuadvert * E_SUDOKU_SQUARE_DIM + j].
-										_posiblesValores[valor] = false;
-    		}
-    	}
-    	// Restricciones de columna y fila
-    	for(i = 0; i < E_SUDOKU_DIM; i++)
-    	{
-    		_boardBoxes[posX][i]._posiblesValores[valor] = false;
-    		_boardBoxes[i][posY]._posiblesValores[valor] = false;
-    	}
-    		
-		// Actualiza los numeros completos
-    	this->_update_complete();
-
-    	return true;
-		}
-	}
-	
-	return false;
-}
+};
 
 ////////////////////////////////////////////////////////////////////////////////
-bool CSudokuBoard::rulesCheck(int valor, int posX, int posY)
+/**
+ * @brief Lazy children generation of a board (see
+ * CSudokuBoard::beginChildrens): a safe child, or probable children of boxes
+ * with less possible values, one child for each (box, value)
+ */
+struct SSudokuChildren
 {
-	if(valor == 0) return true;
-	return (_boardBoxes[posX][posY])._posiblesValores[valor];
-}
+	CSudokuBoard base;			/**< Safe child, or board of probable children */
+	unsigned char boxes[E_SUDOKU_BOX_COUNT];	/**< Boxes of probable children */
+	short int values[E_SUDOKU_DIM];	/**< Values of current box, in order */
+	unsigned char box_count;
+	unsigned char box_index;	/**< Current box */
+	unsigned char value_count;
+	unsigned char value_index;	/**< Next value of current box */
+	unsigned short generated;	/**< Children given */
+	bool safe;					/**< Safe child isn't given yet */
+	bool done;
+};
 
 ////////////////////////////////////////////////////////////////////////////////
-// Devuelve si un numero o todo el tablero esta completo
-// Si se pregunta por 0, es por todo el tablero,
-// y numero de 1 a 9 por su correpondiente
-// Cualquier valor fuera de [0,9] da false
-bool CSudokuBoard::is_complete(short int valor) const
-{
-	if( (valor<0) || (valor>9) ) return false;
-	return _completo[valor];
-}
+/**
+ * @brief Read sudoku board in text format, 9 rows of 9 values with '|'
+ * separators and a separator line every 3 rows
+ * @param input
+ * @param o
+ * @return input, with badbit if board breaks sudoku rules
+ */
+std::istream& operator>>(std::istream &input, CSudokuBoard &o);
 
 ////////////////////////////////////////////////////////////////////////////////
-// Comprueba si se ha completado algun numero o todo el tablero, y lo rellena en
-// en el vector _completo
-void CSudokuBoard::_update_complete(){
-
-	register int i;
-	int cuenta;
-	int k; // valores posibles de sudoku
-	for(k = 1; k < E_SUDOKU_BOX_STATES_COUNT; k++)
-	{
-		cuenta=0;
-		for(i = 0; i < E_SUDOKU_BOX_COUNT; i++)
-		{
-			if(_boardBoxes[i/9][i%9].getValor() == k) cuenta++;
-		}
-
-		if(cuenta == 9) _completo[k] = true;
-	}
-
-	if( _completo[1] && _completo[2] && _completo[3] && _completo[4] && _completo[5] &&
-		_completo[6] && _completo[7] && _completo[8] && _completo[9]) _completo[0] = true;
-}
-
+/**
+ * @brief Write sudoku board in text format (see operator>>)
+ * @param output
+ * @param o
+ * @return output
+ */
+std::ostream& operator<<(std::ostream &output, const CSudokuBoard &o);
 
 ////////////////////////////////////////////////////////////////////////////////
 /**
@@ -655,26 +431,7 @@ void CSudokuBoard::_update_complete(){
  * @param segundo second sudoku board to compare
  * @return if second board isn't equal from first board return true
  */
-bool diferentes(CSudokuBoard primero,CSudokuBoard segundo){
-
-	if( primero.m_occupiedBoxCount != segundo.m_occupiedBoxCount) return true;
-
-	int i,j;	
-	bool diferencia = false;
-
-	for(i = 0; (i < E_SUDOKU_DIM && !diferencia); i++)
-	{
-		for(j = 0; (j < E_SUDOKU_DIM && !diferencia); j++)
-		{
-			if( (primero._boardBoxes[i][j]).getValor() !=
-				(segundo._boardBoxes[i][j]).getValor() )
-			{
-				diferencia = true;
-			}
-   		}
-	}
-	return diferencia;
-}
+bool diferentes(const CSudokuBoard &primero, const CSudokuBoard &segundo);
 
 ////////////////////////////////////////////////////////////////////////////////
 /**
@@ -684,305 +441,7 @@ bool diferentes(CSudokuBoard primero,CSudokuBoard segundo){
  * @param segundo second sudoku board to compare
  * @return if second board isn't equal and not derived from first board return true
  */
-bool diferentes2(CSudokuBoard primero,CSudokuBoard segundo)
-{
-	register int i;
-	bool diferencia=false;
-	for(i = 0; (i < E_SUDOKU_BOX_COUNT && !diferencia); i++)
-	{
-		if( ( (primero._boardBoxes[i/9][i%9]).getValor()
-					!= (segundo._boardBoxes[i/9][i%9]).getValor() )
-			&& (primero._boardBoxes[i/9][i%9]).getValor() != 0)
-		{
-			diferencia = true;
-		}
-	}
-	return diferencia;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/**
- * @brief This function uses four rules to generate new sudoku boards from
- * original "primero". These new boards are checked with visited
- * before including them into solutions vector. It can generate safe children,
- * with 100% probability, or probable children, if safe children cannot be generated
- * @param solutions
- * @param visited
- * @param primero
- * @return
- */
-bool CSudokuBoard::generateSudokuBoardChildrens(std::vector<CSudokuBoard> *solutions,
-									std::vector<CSudokuBoard> **visited,
-									const CSudokuBoard& primero) const
-{
-	// TODO: this function is too long
-
-	// If sudoku board primero is completed, I cannot generate children
-	if (primero.is_complete(0) ) return false;
-
-	CSudokuBoard aux2 = primero;
-	CSudokuBoard aux1 = primero;
-	CSudokuBoard aux = primero;
-
-	bool is_there_the_same_one = false;
-	bool is_safe_children = false;
-	unsigned int k,l,m,cuentatrue,valor;
-	int z = 0;
-
-	unsigned int P; // Probability
-	unsigned int P_limit; // Probability limit
-	int posXencontrado,posYencontrado;
-	unsigned int register i,j;
-
-	// If there is a safe children (probability 100%)
-	// it will be returned as unique children
-
-	bool nuevaInsercion = false;
-	std::vector<int> antepasados;
-
-	//--------------------------------------------------------------------------
-	do{
-		nuevaInsercion = false;
-		//--------------------------------------------------------------------------
-		// Rule 1. Check immediate values resolution
-		for(i = 0; i < E_SUDOKU_DIM; i++)
-		{
-			for(j = 0; j < E_SUDOKU_DIM; j++)
-			{
-				// Pone el valor en la casilla donde solo se pueda poner ese
-				if(aux1.getValorByXY(i,j) == 0)
-				{ // solo pone en las casillas con 0
-					cuentatrue = 0;
-					for(k = 1; k < E_SUDOKU_BOX_STATES_COUNT; k++)
-					{
-						if(aux1._boardBoxes[i][j]._posiblesValores[k])
-						{
-							cuentatrue++;
-							valor=k;
-						}
-					}
-					if( cuentatrue == 1)
-					{
-						aux1.setValorByXY(valor,i,j);
-						is_safe_children=true;
-						nuevaInsercion = true;
-					}
-				}
-			}
-		}
-		//--------------------------------------------------------------------------
-		// Rule 2. Check 3x3 squares resolution
-		for(l = 0; l < E_SUDOKU_DIM; l++)
-		{
-			for(k = 1; k < E_SUDOKU_BOX_STATES_COUNT; k++)
-			{
-				cuentatrue = 0;
-				for(i = (l / E_SUDOKU_SQUARE_DIM) * E_SUDOKU_SQUARE_DIM;
-					i < ((l / E_SUDOKU_SQUARE_DIM) * E_SUDOKU_SQUARE_DIM + E_SUDOKU_SQUARE_DIM);
-					i++)
-				{
-					for(j = ((l % E_SUDOKU_SQUARE_DIM) * E_SUDOKU_SQUARE_DIM);
-						j < (((l % E_SUDOKU_SQUARE_DIM) * E_SUDOKU_SQUARE_DIM) + E_SUDOKU_SQUARE_DIM);
-						j++)
-					{
-						if(aux1._boardBoxes[i][j]._posiblesValores[k] &&
-								aux1._boardBoxes[i][j]._posiblesValores[0])
-						{
-							cuentatrue++;
-							valor=k;
-							posXencontrado = i;
-							posYencontrado = j;
-						}
-
-					}
-				}
-				if( (cuentatrue == 1)
-						&&
-					(aux1.getValorByXY(posXencontrado,posYencontrado) == 0) )
-				{
-					aux1.setValorByXY(valor,posXencontrado,posYencontrado);
-					is_safe_children = true;
-					nuevaInsercion = true;
-				}
-			}
-		}
-
-		//--------------------------------------------------------------------------
-		// Rules 3 and 4 check column and row values
-		for(i = 0; i < E_SUDOKU_DIM; i++)
-		{
-			// Check column
-			for(k = 1; k < E_SUDOKU_BOX_STATES_COUNT; k++)
-			{
-				cuentatrue = 0;
-				for(l = 0; l < E_SUDOKU_DIM; l++)
-				{
-					if(aux1._boardBoxes[i][l]._posiblesValores[k] &&
-							aux1._boardBoxes[i][l]._posiblesValores[0])
-					{
-						cuentatrue++;
-						valor = k;
-						m = l;
-					}
-				}
-				if( cuentatrue == 1)
-				{
-					if(aux1.getValorByXY(i,m) == 0)
-					{
-						aux1.setValorByXY(valor,i,m);
-						is_safe_children = true;
-						nuevaInsercion = true;
-					}
-					cuentatrue = 0;
-				}
-			}
-
-			// Check row
-			for(k = 1; k < E_SUDOKU_BOX_STATES_COUNT; k++)
-			{
-				cuentatrue = 0;
-				for(l = 0 ; l < E_SUDOKU_DIM; l++)
-				{
-					if(aux1._boardBoxes[l][i]._posiblesValores[k] &&
-							aux1._boardBoxes[l][i]._posiblesValores[0])
-					{
-						cuentatrue++;
-						valor = k;
-						m = l;
-					}
-				}
-				if( cuentatrue == 1)
-				{
-					if(aux1.getValorByXY(m,i) == 0)
-					{
-						aux1.setValorByXY(valor,m,i);
-						is_safe_children = true;
-						nuevaInsercion = true;
-					}
-				}
-			}
-		}
-	}while(nuevaInsercion);
-
-	//--------------------------------------------------------------------------
-	// 100% probability children
-	if(is_safe_children)
-	{
-		is_there_the_same_one = false;
-		z=0;
-		antepasados.clear();
-		while(z < (aux1.m_occupiedBoxCount - 1))
-		{
-			if( (*visited)[z].size()>0){ antepasados.push_back(z);}
-			z++;			
-		}
-		for(m = 0;!is_there_the_same_one && (m < antepasados.size()) ;m++)
-		{
-			for(l=0;!is_there_the_same_one && (l<((*visited)[m]).size());l++)
-			{
-				if(!diferentes2(( (*visited)[m] ).at(l),aux1) )
-				{
-					//std::cout << " Safe children inclusion =" << std::endl;
-					is_there_the_same_one = true;
-				}
-			}
-		}
-		if(!is_there_the_same_one)
-		{
-			solutions->push_back(aux1);
-			//std::cout << " Safe children inclusion" << std::endl;
-			return true;
-		}
-	}
-
-	//--------------------------------------------------------------------------
-	// Probability inclusion. From here, I'am going to include number in sudoku
-	// board with certain probability level but not sure.
-
-	// I have to find the box where it's less probable to make a mistake
-	// and order them.
-	std::vector<int> ii;
-	std::vector<int> jj;
-
-	// VERY IMPORTANT: THE LIMITS OF PROBABILITY MUST BE DEFINE CARESFULLY, THE
-	// EXTENSION OF SEARCH TREE CAN DESTROY YOUR RAM MEMORY JA JA JA JA ....
-	// LIMITS (2->50%, 3->33%, 4->25%, 5->20%, ...)
-
-	// Here, I have to decide how many children I are going to create, and probability
-	// level of them. More children -> more memory and CPU time
-	P = 2; // From 50% probability
-	P_limit = 8; // To 12.5% probability. my memory is infinite
-
-	for(l = P; l < P_limit; l++)
-	{
-		for(i = 0; i < E_SUDOKU_DIM; i++)
-		{
-			for(j = 0; j < E_SUDOKU_DIM; j++)
-			{
-				if(aux2.getValorByXY(i,j) == 0)
-				{
-					cuentatrue=0;
-					for(k = 1; k < E_SUDOKU_BOX_STATES_COUNT; k++)
-					{
-						if(aux2._boardBoxes[i][j]._posiblesValores[k]) cuentatrue++;
-					}
-					if(cuentatrue == l){
-						ii.push_back(i);
-						jj.push_back(j);
-					}
-				}
-			}
-		}
-	}
-	//--------------------------------------------------------------------------
-	// Tomando el orden anterior se realiza una insercion sin reglas
-
-	nuevaInsercion = false;
-
-	do{
-		nuevaInsercion = false;
-
-		for(i = 0; i < ii.size() ;i++)
-		{
-			for(k = 1; k < E_SUDOKU_BOX_STATES_COUNT; k++)
-			{
-				if( aux.getValorByXY( ii.at(i) , jj.at(i) ) == 0)
-				{
-					if( aux.setValorByXY(k, ii.at(i) , jj.at(i) ) )
-					{
-						is_there_the_same_one=false;
-						z=0;
-						antepasados.clear();
-						while(z < (aux.m_occupiedBoxCount - 1))
-						{
-							if( (*visited)[z].size()>0){ antepasados.push_back(z);}
-							z++;
-						}
-						for(m = 0;!is_there_the_same_one && (m < antepasados.size()) ;m++)
-						{
-							for(l=0;!is_there_the_same_one && (l<((*visited)[m]).size());l++)
-							{
-								if(!diferentes2(( (*visited)[m] ).at(l),aux) ) is_there_the_same_one = true;
-							}
-						}
-
-						if(!is_there_the_same_one)
-						{
-							solutions->push_back(aux);
-							if( !aux.setValorByXY(0, ii.at(i) , jj.at(i) ) ) std::cerr << "error";
-							// std::cout << " Probable children inclusion" << std::endl;
-							std::cout << ". ";
-							nuevaInsercion = true;
-						}
-					}
-				}
-			}
-		}
-	}while( (nuevaInsercion) && (k < E_SUDOKU_BOX_STATES_COUNT) );
-
-	return true;
-}
+bool diferentes2(const CSudokuBoard &primero, const CSudokuBoard &segundo);
 
 } // namespace sudoku
 #endif // _SUDOKU_HPP_
-
@@ -0,0 +1,109 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_tables.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sudoku_tables.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * Board geometry tables, generated at compile time. Boxes are numbered
+ * row by row, box = row * E_SUDOKU_DIM + column. Units are numbered: rows
+ * [0, 9), columns [9, 18) and 3x3 squares [18, 27), boxes of every unit are
+ * in row by row order.
+ */
+
+#ifndef _SUDOKU_TABLES_HPP_
+#define _SUDOKU_TABLES_HPP_
+
+#include "sudoku_solver.hpp"
+
+namespace sudoku{
+
+enum E_SUDOKU_TABLES
+{
+	E_SUDOKU_UNIT_COUNT = 3 * E_SUDOKU_DIM,
+	E_SUDOKU_UNITS_BY_BOX = 3,
+	E_SUDOKU_PEER_COUNT = 20,	/**< Other boxes in row, column and square */
+	E_SUDOKU_FIRST_ROW_UNIT = 0,
+	E_SUDOKU_FIRST_COLUMN_UNIT = E_SUDOKU_DIM,
+	E_SUDOKU_FIRST_SQUARE_UNIT = 2 * E_SUDOKU_DIM
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Peers and units of every box, and boxes of every unit
+ */
+struct SSudokuTables
+{
+	unsigned char peers[E_SUDOKU_BOX_COUNT][E_SUDOKU_PEER_COUNT];
+	unsigned char units[E_SUDOKU_UNIT_COUNT][E_SUDOKU_DIM];
+	unsigned char box_units[E_SUDOKU_BOX_COUNT][E_SUDOKU_UNITS_BY_BOX];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @return tables, it's only called at compile time
+ */
+constexpr SSudokuTables make_sudoku_tables(void)
+{
+	SSudokuTables tables{};
+	int used[E_SUDOKU_UNIT_COUNT]{};
+
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		int row = box / E_SUDOKU_DIM;
+		int column = box % E_SUDOKU_DIM;
+		int square = (row / E_SUDOKU_SQUARE_DIM) * E_SUDOKU_SQUARE_DIM +
+						column / E_SUDOKU_SQUARE_DIM;
+		int box_units[E_SUDOKU_UNITS_BY_BOX] = {E_SUDOKU_FIRST_ROW_UNIT + row,
+			E_SUDOKU_FIRST_COLUMN_UNIT + column, E_SUDOKU_FIRST_SQUARE_UNIT + square};
+
+		for (int u = 0; u < E_SUDOKU_UNITS_BY_BOX; u++)
+		{
+			tables.box_units[box][u] = box_units[u];
+			tables.units[box_units[u]][used[box_units[u]]++] = box;
+		}
+	}
+
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		int peer_count = 0;
+		for (int other = 0; other < E_SUDOKU_BOX_COUNT; other++)
+		{
+			bool is_peer = false;
+			for (int u = 0; u < E_SUDOKU_UNITS_BY_BOX; u++)
+			{
+				if (tables.box_units[box][u] == tables.box_units[other][u]) is_peer = true;
+			}
+			if (is_peer && other != box) tables.peers[box][peer_count++] = other;
+		}
+	}
+
+	return tables;
+}
+
+constexpr SSudokuTables sudoku_tables = make_sudoku_tables();
+
+static_assert(sudoku_tables.peers[0][E_SUDOKU_PEER_COUNT - 1] == 72,
+				"box 0 last peer is the last box of its column");
+static_assert(sudoku_tables.units[E_SUDOKU_UNIT_COUNT - 1][0] == 60,
+				"last square starts in box 60");
+
+};
+
+#endif // _SUDOKU_TABLES_HPP_
@@ -0,0 +1,186 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_validator.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sudoku_validator.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _SUDOKU_VALIDATOR_HPP_
+#define _SUDOKU_VALIDATOR_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "sudoku_tables.hpp"
+
+namespace sudoku{
+
+enum E_SUDOKU_VALIDATOR
+{
+	E_SUDOKU_VALIDATOR_LANES = 16,	/**< Grids checked at the same time */
+	E_SUDOKU_VALIDATOR_PACKED_SIZE = (E_SUDOKU_BOX_COUNT + 1) / 2,	/**< Bytes of a
+															packed grid */
+	E_SUDOKU_VALIDATOR_THREAD_GRIDS = 1 << 14	/**< Min grids by thread */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSudokuValidator
+ * @brief Bulk check of claimed solutions, without search: a solution is valid
+ * if every box has a value, every row, column and square has the nine values
+ * and every given value of its puzzle is in the same box.
+ *
+ * Grids are 81 characters row by row, '1' to '9' (puzzles use '0' or '.' for
+ * empty boxes, like CSudokuBoard::load_from_buffer), or packed in 41 bytes:
+ * box i is the low nibble of byte i / 2 if i is even and the high one if it's
+ * odd, 0 is an empty box (see pack()).
+ *
+ * Grids are checked like boards of CSudokuLanes: 16 grids at the same time,
+ * one bit mask by box and lane, so every unit is checked for all of them with
+ * SIMD instructions. Big inputs are split between threads. Only classic layout
+ * is supported (see CSudokuLayout).
+ */
+class CSudokuValidator
+{
+	public:
+
+		/**
+		 * @brief CSudokuValidator constructor
+		 * @param thread_count max threads of every check, 0 means CPUs
+		 */
+		CSudokuValidator(unsigned int thread_count = 0);
+
+		virtual ~CSudokuValidator(){};
+
+		/**
+		 * @brief Check grids of 81 characters stored one after another
+		 * @param solutions count grids
+		 * @param puzzles count puzzles of solutions, or nullptr to check
+		 * only solutions
+		 * @param count
+		 * @param valid if it isn't nullptr, count results: 1 valid, 0 invalid
+		 * @return number of valid solutions
+		 */
+		size_t validate(const char *solutions, const char *puzzles, size_t count,
+						unsigned char *valid) const;
+
+		/**
+		 * @brief Like validate(), with packed grids of
+		 * E_SUDOKU_VALIDATOR_PACKED_SIZE bytes
+		 */
+		size_t validate_packed(const uint8_t *solutions, const uint8_t *puzzles,
+								size_t count, unsigned char *valid) const;
+
+		/**
+		 * @brief Check a text buffer with one claim by line: the solution, or
+		 * the puzzle, one separator character (space, comma...) and the
+		 * solution. Malformed lines are invalid
+		 * @param buffer
+		 * @param size
+		 * @param invalid if it isn't nullptr, line numbers (from 1) of invalid
+		 * claims are appended to it in increasing order
+		 * @return number of claims (non empty lines)
+		 */
+		size_t validate_lines(const char *buffer, size_t size,
+							std::vector<size_t> *invalid) const;
+
+		/**
+		 * @brief Pack a grid of 81 characters
+		 * @param grid
+		 * @param packed E_SUDOKU_VALIDATOR_PACKED_SIZE bytes, characters which
+		 * aren't values are packed as empty boxes
+		 */
+		static void pack(const char *grid, uint8_t *packed);
+
+	private:
+
+		typedef uint16_t lane_vector
+			__attribute__((vector_size(E_SUDOKU_VALIDATOR_LANES * sizeof(uint16_t))));
+
+		/**
+		 * @brief Grids of up to E_SUDOKU_VALIDATOR_LANES claims, one lane for
+		 * each one. Bit v is value v. Given values of puzzles are checked
+		 * when claims are loaded
+		 */
+		struct SLanes
+		{
+			lane_vector values[E_SUDOKU_BOX_COUNT];
+			uint32_t wrong_givens;	/**< Bit i is lane i */
+
+			SLanes(): wrong_givens(0) {}
+		};
+
+		/**
+		 * @brief Put a claim in a lane
+		 * @param lanes
+		 * @param lane
+		 * @param solution 81 characters
+		 * @param puzzle 81 characters or nullptr
+		 */
+		static void _load(SLanes *lanes, unsigned int lane, const char *solution,
+						const char *puzzle);
+
+		/**
+		 * @brief Like _load(), with packed grids
+		 */
+		static void _load(SLanes *lanes, unsigned int lane, const uint8_t *solution,
+						const uint8_t *puzzle);
+
+		/**
+		 * @brief Check every lane, then wrong givens are cleared for next
+		 * claims
+		 * @param lanes
+		 * @return bit i is 1 if claim in lane i is invalid
+		 */
+		static uint32_t _check(SLanes *lanes);
+
+		/**
+		 * @brief Check grids [0, count) in blocks of lanes, split between
+		 * threads
+		 * @param grid_size bytes of a grid
+		 */
+		template <class Grid>
+		size_t _validate(const Grid *solutions, const Grid *puzzles, size_t count,
+						size_t grid_size, unsigned char *valid) const;
+
+		/**
+		 * @brief Check claims of a range of lines
+		 * @param begin start of first line
+		 * @param end end of range, after a new line character or at the end
+		 * of buffer
+		 * @param invalid numbers of invalid claims, from 0 in the range
+		 * @param claims number of claims (non empty lines)
+		 * @return number of lines
+		 */
+		static size_t _validate_lines(const char *begin, const char *end,
+									std::vector<size_t> *invalid, size_t *claims);
+
+		/**
+		 * @param work number of grids
+		 * @return threads to check them
+		 */
+		unsigned int _get_thread_count(size_t work) const;
+
+		unsigned int m_thread_count;
+};
+
+} // namespace sudoku
+#endif // _SUDOKU_VALIDATOR_HPP_
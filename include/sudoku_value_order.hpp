@@ -0,0 +1,120 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_value_order.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sudoku_value_order.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _SUDOKU_VALUE_ORDER_HPP_
+#define _SUDOKU_VALUE_ORDER_HPP_
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sudoku_solver.hpp"
+
+namespace sudoku{
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Order of values tried in a box by probable children
+ */
+enum E_SUDOKU_VALUE_ORDER
+{
+	E_SUDOKU_VALUE_ORDER_NUMERIC = 0,		/**< 1 to 9 */
+	E_SUDOKU_VALUE_ORDER_LEAST_CONSTRAINING,	/**< Value possible in less empty
+												 peers first */
+	E_SUDOKU_VALUE_ORDER_RANDOM,
+	E_SUDOKU_VALUE_ORDER_LEARNED,			/**< Value with more weight first */
+	E_SUDOKU_VALUE_ORDER_COUNT
+};
+
+/**
+ * @brief Get value order by its name: numeric, lcv, random or learned
+ * @param name
+ * @param order
+ * @return false unknown name
+ */
+bool get_value_order_by_name(const std::string &name, E_SUDOKU_VALUE_ORDER *order);
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSudokuValueOrder
+ * @brief Children order of sudoku searches (see CChildrenOrder). Probable
+ * children of the same box are sorted by their value, children of different
+ * boxes keep their order. Values are sorted before their children are built.
+ *
+ * Learned order keeps a weight for every value in every box: values in
+ * nogoods lose weight and values of solutions win it. Weights are kept
+ * between searches, so a worker learns from earlier branches and earlier
+ * boards. In a tie, numeric order is kept.
+ */
+class CSudokuValueOrder: public CChildrenOrder<CSudokuBoard>
+{
+	public:
+
+		/**
+		 * @param order
+		 * @param seed of random order
+		 */
+		CSudokuValueOrder(E_SUDOKU_VALUE_ORDER order = E_SUDOKU_VALUE_ORDER_NUMERIC,
+						unsigned int seed = std::mt19937::default_seed);
+
+		virtual ~CSudokuValueOrder(){};
+
+		inline void set_order(E_SUDOKU_VALUE_ORDER order) { m_order = order; }
+
+		inline E_SUDOKU_VALUE_ORDER get_order(void) const { return m_order; }
+
+		/**
+		 * @brief Forget learned weights
+		 */
+		void clear_learned(void);
+
+		virtual void order(const CSudokuBoard &parent, int box, short int *values, int count);
+
+		virtual void failed(const CSudokuBoard &nogood);
+
+		virtual void solved(const CSudokuBoard &solution);
+
+	private:
+
+		/**
+		 * @param parent
+		 * @param box
+		 * @param valor
+		 * @return lower first
+		 */
+		int _get_score(const CSudokuBoard &parent, int box, short int valor) const;
+
+		E_SUDOKU_VALUE_ORDER m_order;
+
+		std::mt19937 m_random;
+
+		int m_weights[E_SUDOKU_BOX_COUNT][E_SUDOKU_BOX_STATES_COUNT];
+
+		// Sort buffer, kept to allocate it only once
+		std::vector< std::pair<int, short int> > m_scores;
+};
+
+} // namespace sudoku
+#endif // _SUDOKU_VALUE_ORDER_HPP_
@@ -0,0 +1,276 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_worker.hpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sudoku_worker.hpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#ifndef _SUDOKU_WORKER_HPP_
+#define _SUDOKU_WORKER_HPP_
+
+#include <memory>
+
+#include "sudoku_solver.hpp"
+#include "csearch_policy.hpp"
+#include "sudoku_value_order.hpp"
+
+namespace sudoku{
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Search strategies, see CNode::search and csearch_policy.hpp
+ */
+enum E_SUDOKU_STRATEGY
+{
+	E_SUDOKU_STRATEGY_RULES = 0,			/**< CNode::search() */
+	E_SUDOKU_STRATEGY_DEPTH_FIRST,			/**< CDepthFirstPolicy */
+	E_SUDOKU_STRATEGY_BEST_FIRST,			/**< CBestFirstPolicy */
+	E_SUDOKU_STRATEGY_BEAM,					/**< CBeamPolicy<> */
+	E_SUDOKU_STRATEGY_ITERATIVE_DEEPENING,	/**< CIterativeDeepeningPolicy */
+	E_SUDOKU_STRATEGY_COUNT
+};
+
+/**
+ * @brief Get strategy by its name: rules, dfs, best, beam or iddfs
+ * @param name
+ * @param strategy
+ * @return false unknown name
+ */
+bool get_strategy_by_name(const std::string &name, E_SUDOKU_STRATEGY *strategy);
+
+/**
+ * @brief Get strategies by a list of names separated by commas
+ * @param names
+ * @param strategies
+ * @return false any unknown name
+ */
+bool get_strategies_by_names(const std::string &names,
+							std::vector<E_SUDOKU_STRATEGY> *strategies);
+
+/**
+ * @param strategy
+ * @return strategy name
+ */
+const char *get_strategy_name(E_SUDOKU_STRATEGY strategy);
+
+/**
+ * @brief Get visited store eviction by its name: subtree, lru or depth
+ * @param name
+ * @param eviction
+ * @return false unknown name
+ */
+bool get_eviction_by_name(const std::string &name, E_VISITED_EVICTION *eviction);
+
+/**
+ * @brief Get branching fan-out by its spec: min,max[,boxes[,failure_rate]],
+ * see SSearchBranching. Boxes are all (0) if they aren't given, and fan-out is
+ * fixed unless failure rate is given and it isn't 0
+ * @param spec
+ * @param branching
+ * @return false bad spec
+ */
+bool get_branching_by_spec(const std::string &spec, SSearchBranching *branching);
+
+/**
+ * @param branching
+ * @return spec of branching, see get_branching_by_spec
+ */
+std::string get_branching_spec(const SSearchBranching &branching);
+
+/**
+ * @brief Start solution search in root with a strategy
+ * @param root
+ * @param context
+ * @param strategy
+ * @return true solution found, it's root information
+ */
+bool search_with_strategy(CNode<CSudokuBoard> *root,
+						CSearchContext<CSudokuBoard> *context,
+						E_SUDOKU_STRATEGY strategy);
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Options of every search done by a worker
+ */
+struct SSudokuWorkerOptions
+{
+	size_t memory_limit;	/**< Max bytes for one board search, 0 unlimited */
+	E_SUDOKU_STRATEGY strategy;
+	size_t visited_capacity;	/**< Max visited nodes in one board search, 0 unlimited */
+	E_VISITED_EVICTION visited_eviction;
+	bool lockstep;				/**< Batch boards are propagated in groups first
+									 (see CSudokuLanes) */
+	unsigned long timeout;		/**< Max milliseconds for one board search, 0 unlimited */
+	std::vector<E_SUDOKU_STRATEGY> portfolio;	/**< Strategies raced for every board
+													 (see CSudokuPortfolio), empty
+													 for only strategy */
+	E_SUDOKU_VALUE_ORDER value_order;	/**< Order of values tried in a box */
+	unsigned long trace_sample;	/**< Batch boards whose number is a multiple of
+									 it are traced (see CSearchTrace), 0 none */
+	std::string trace_prefix;	/**< Trace of batch board N is written in file
+									 prefix.N.trace */
+	SSearchBranching branching;	/**< Fan-out of search expansions */
+
+	SSudokuWorkerOptions(): memory_limit(0), strategy(E_SUDOKU_STRATEGY_RULES),
+		visited_capacity(0), visited_eviction(E_VISITED_EVICTION_SUBTREE),
+		lockstep(true), timeout(0), value_order(E_SUDOKU_VALUE_ORDER_NUMERIC),
+		trace_sample(0)
+	{
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @class CSudokuWorker
+ * @brief Silent solver for many sudoku boards, one after the other. Search
+ * tree root and visited nodes are kept between boards, so their memory is
+ * allocated just once. Value order is kept too, a learned order learns from
+ * every board solved by the worker. A worker must be used by only one thread
+ * at a time.
+ */
+class CSudokuWorker
+{
+	public:
+
+		CSudokuWorker(const SSudokuWorkerOptions &options = SSudokuWorkerOptions()):
+			m_context(E_SUDOKU_BOX_COUNT - 1, nullptr), m_root()
+		{
+			m_context.set_cancel_token(&m_cancel);
+			set_options(options);
+		}
+
+		void set_options(const SSudokuWorkerOptions &options)
+		{
+			m_context.set_memory_limit(options.memory_limit);
+			m_context.set_visited_capacity(options.visited_capacity);
+			m_context.set_visited_eviction(options.visited_eviction);
+			m_context.set_branching(options.branching);
+			m_strategy = options.strategy;
+			m_timeout = std::chrono::milliseconds(options.timeout);
+			m_value_order.set_order(options.value_order);
+			m_context.set_children_order(
+				options.value_order == E_SUDOKU_VALUE_ORDER_NUMERIC ? nullptr : &m_value_order);
+		}
+
+		/**
+		 * @brief Stop the search running now, it can be called from any
+		 * thread. Every search starts not cancelled
+		 */
+		inline void cancel(void) { m_cancel.cancel(); }
+
+		/**
+		 * @brief Use a cancel token shared with other workers instead of the
+		 * own one. It isn't reset by solve(), and cancel() hasn't got effect
+		 * @param cancel token, nullptr to use the own one again
+		 */
+		inline void set_cancel_token(const CCancelToken *cancel)
+		{
+			m_context.set_cancel_token(cancel ? cancel : &m_cancel);
+		}
+
+		/**
+		 * @brief Record events of next searches in a trace (see
+		 * CSearchTrace), it's started again by every solve(). Its memory is
+		 * allocated the first time
+		 * @param enabled
+		 */
+		void set_tracing(bool enabled)
+		{
+			if (enabled && !m_trace) m_trace.reset(new CSearchTrace());
+			m_context.set_trace(enabled ? m_trace.get() : nullptr);
+		}
+
+		/**
+		 * @return trace of last search, nullptr if tracing isn't enabled
+		 */
+		inline const CSearchTrace *get_trace(void) const { return m_context.get_trace(); }
+
+		/**
+		 * @return statistics of last search
+		 */
+		inline const SSearchStatistics &get_statistics(void) const
+		{
+			return m_context.get_statistics();
+		}
+
+		/**
+		 * @brief Solve sudoku board
+		 * @param puzzle initial sudoku board
+		 * @param solution solved sudoku board if it returns true. If search
+		 * was stopped or gave up (see SSearchStatistics::is_partial), the
+		 * deepest board found, or puzzle if there isn't any
+		 * @param keep_visited failed nodes of last search are kept (see
+		 * CSearchContext::restart), puzzle must have the values of last
+		 * puzzle and maybe some more
+		 * @return true sudoku was solved, false sudoku hasn't got solution or
+		 * search was stopped by timeout or cancel(), or it gave up
+		 */
+		bool solve(const CSudokuBoard &puzzle, CSudokuBoard &solution,
+					bool keep_visited = false);
+
+		/**
+		 * @brief Solve sudoku board in 81 characters format
+		 * (see CSudokuBoard::load_from_buffer)
+		 * @param puzzle 81 characters
+		 * @param solution 81 characters
+		 * @return E_SUDOKU_WORKER_RESULT
+		 */
+		int solve(const char *puzzle, char *solution);
+
+		/**
+		 * @brief Result of last solve(puzzle, solution)
+		 * @param solved returned by solve
+		 * @return E_SUDOKU_WORKER_RESULT
+		 */
+		inline int get_result(bool solved) const
+		{
+			if (solved) return E_SUDOKU_WORKER_SOLVED;
+			return get_statistics().is_partial() ? E_SUDOKU_WORKER_TIMED_OUT :
+												E_SUDOKU_WORKER_UNSOLVABLE;
+		}
+
+		enum E_SUDOKU_WORKER_RESULT
+		{
+			E_SUDOKU_WORKER_SOLVED = 0,
+			E_SUDOKU_WORKER_UNSOLVABLE = 1,
+			E_SUDOKU_WORKER_INVALID = 2,
+			E_SUDOKU_WORKER_TIMED_OUT = 3	/**< Stopped or incomplete search gave
+												 up, solution is partial */
+		};
+
+	private:
+
+		CSearchContext<CSudokuBoard> m_context;
+
+		CNode<CSudokuBoard> m_root;
+
+		E_SUDOKU_STRATEGY m_strategy;
+
+		std::chrono::milliseconds m_timeout;
+
+		CCancelToken m_cancel;
+
+		CSudokuValueOrder m_value_order;
+
+		std::unique_ptr<CSearchTrace> m_trace;
+};
+
+} // namespace sudoku
+#endif // _SUDOKU_WORKER_HPP_
@@ -0,0 +1,938 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_board.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_board.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ * @date 16 Nov 2008
+ */
+
+#include "sudoku_solver.hpp"
+#include "sudoku_tables.hpp"
+
+#include <string>
+#include <type_traits>
+
+namespace sudoku{
+
+// Boards are copied and moved in every expansion, they must be plain memory
+static_assert(std::is_trivially_copyable<CSudokuBoard>::value,
+				"CSudokuBoard must be trivially copyable");
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuBox::CSudokuBox()
+{
+	_valor=0;
+	for(int i = 0; i < E_SUDOKU_BOX_STATES_COUNT; i++) _posiblesValores[i] = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuBox::CSudokuBox(short int valor)
+{
+					 
+	if( (valor < 1) || (valor > 9) ){
+		_valor=0;
+		for(int i = 0; i< E_SUDOKU_BOX_STATES_COUNT; i++)
+			_posiblesValores[i] = true;
+	}
+	else
+	{
+		_valor = valor;
+		for(int i = 0; i < E_SUDOKU_BOX_STATES_COUNT; i++)
+			_posiblesValores[i] = true;
+
+		_posiblesValores[0]=false;
+		_posiblesValores[valor]=false;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuBox::setValor(short int valor)
+{
+	if( (valor < 0) || (valor > 9) ) return false;
+
+	if(valor == 0)
+	{
+		_posiblesValores[_valor]=true;
+		_valor = valor;
+		_posiblesValores[0]=true;
+		return true;
+	}
+	else
+	{
+		_posiblesValores[_valor]=true;
+		_valor = valor;
+		_posiblesValores[valor]=false;
+		_posiblesValores[0]=false;
+		return true;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::istream& operator>>(std::istream &input, CSudokuBoard &o)
+{
+	unsigned int current_row = 0;
+	unsigned int file_row = 0;
+
+	short int value[9];
+	memset(value, 0, sizeof(short int) * E_SUDOKU_DIM);
+
+	char separator[2] = {'\0', '\0'};
+	std::string line_separator;
+
+	while (current_row < E_SUDOKU_DIM)
+	{
+		if (file_row > 0 &&
+			file_row < 11 &&
+			(file_row + 1) % 4 == 0)
+		{
+			input >> line_separator;
+		}
+		else
+		{
+			input >> value[0] >> value[1] >> value[2] >> separator[0] >>
+					value[3] >> value[4] >> value[5] >> separator[1] >>
+					value[6] >> value[7] >> value[8];
+
+			for (unsigned int uiI = 0; uiI < E_SUDOKU_DIM; uiI++)
+			{
+				if (!o.setValorByXY(value[uiI], current_row, uiI))
+				{
+					std::cerr << "Error file_row: " << file_row << std::endl;
+					std::cerr << "Error current_row: " << current_row << std::endl;
+					std::cerr << "Error current_column: " << uiI << std::endl;
+
+					input.setstate(std::ios_base::badbit);
+				    return input;
+				}
+			}
+
+			current_row++;
+		}
+		file_row++;
+	}
+
+    return input;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::ostream& operator<<(std::ostream &output, const CSudokuBoard &o)
+{
+	unsigned int current_row = 0;
+	unsigned int file_row = 0;
+
+	short int value[E_SUDOKU_DIM];
+	memset(value, 0, sizeof(short int) * E_SUDOKU_DIM);
+
+	char separator = '|';
+	const std::string line_separator = "---------------------";
+
+	output << "SUDOKU BOARD (" << o.get_occupiedBoxCount() << ")" << std::endl;
+
+	while (current_row < E_SUDOKU_DIM)
+	{
+		if (file_row > 0 &&
+			file_row < 11 &&
+			(file_row + 1) % 4 == 0)
+		{
+			output << line_separator << std::endl;
+		}
+		else
+		{
+			for (unsigned int uiI = 0; uiI < E_SUDOKU_DIM; uiI++)
+			{
+				value[uiI] = o.getValorByXY(current_row, uiI);
+			}
+
+			output << value[0] << " " << value[1] << " " << value[2] << " " << separator << " " <<
+					value[3] << " " << value[4] << " " << value[5] << " " << separator << " " <<
+					value[6] << " " << value[7] << " " << value[8] << std::endl;
+
+			current_row++;
+		}
+		file_row++;
+	}
+
+    return output;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuBoard::CSudokuBoard()
+{
+	for(int i = 0;i < E_SUDOKU_BOX_STATES_COUNT; i++)
+	{
+		this->_completo[i] = false;
+	}
+	m_occupiedBoxCount = 0;
+	m_last_decision = -1;
+	m_layout = &CSudokuLayout::get_default();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+short int CSudokuBoard::getValorByXY(short int posX, short int posY) const
+{
+	
+	if( (posX < 0) || (posX > 8) || (posY < 0) || (posY > 8) )
+	{
+		return -1;
+	}
+	else
+	{
+		return _boardBoxes[posX][posY].getValor();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Funcion para establecer valores en el tablero
+// Se tienen en cuenta 3 posibilidades:
+//		1- Si pasa de un valor [1-9] a un valor 0.
+//		2- Si pasa de valor 0 a un valor [1-9].
+//		3- Si pasa de valor [1-9] a un valor [1-9].
+bool CSudokuBoard::setValorByXY(short int valor, short int posX, short int posY)
+{
+	// -------------------------------------------------------------------------
+	// Check limits and values
+	if( (valor<0) || (valor>9) || (posX<0) || (posX>8) || (posY<0) || (posY>8) )
+		return false;
+
+	return _set_valor(posX * E_SUDOKU_DIM + posY, valor);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuBoard::_set_valor(int box, short int valor)
+{
+	CSudokuBox &casilla = _box(box);
+
+	// -------------------------------------------------------------------------
+	// 0- Pure initialization, nothing to do
+	if( valor == 0 && casilla.getValor() == 0 ) return true;
+
+	// -------------------------------------------------------------------------
+	// 1- If value is in [1-9] and it will be set to undetermined (0),
+	// I have to remove restrictions
+	if( valor == 0 )
+	{
+		int valor_antiguo = casilla.getValor();
+
+		if( !casilla.setValor(valor)) return false;
+
+		m_occupiedBoxCount--;
+
+		//Quita las restricciones en los valores posibles para valor antiguo
+		this->_update_restrictions(valor_antiguo);
+
+		// Actualiza los numeros completos
+		this->_update_complete();
+		return true;
+	}
+
+	// Value [1-9] must be possible in box
+	if( !casilla._posiblesValores[valor] ) return false;
+
+	// -------------------------------------------------------------------------
+	// 2- If value move from undetermined to [1-9]. I have to put restrictions
+	if( casilla.getValor() == 0 )
+	{
+		// Set value in board box
+		if( !casilla.setValor(valor)) return false;
+
+		m_occupiedBoxCount++;
+
+		//Pone las restricciones en los valores posibles
+		this->_restrict(box, valor);
+
+		// Actualiza los numeros completos
+		this->_update_complete();
+		return true;
+	}
+
+	// -------------------------------------------------------------------------
+	// 3- If value move from [1-9] to [1-9], I have to change restrictions
+
+	// recoge el valor antiguo
+	int valor_antiguo = casilla.getValor();
+
+	// Pone el valor en el tablero
+	if( !casilla.setValor(valor)) return false;
+
+	// Establezco la restricciones en todo el tablero de nuevo
+	this->_update_restrictions(valor_antiguo);
+
+	//Pone las restricciones en los valores posibles con el valor nuevo
+	this->_restrict(box, valor);
+
+	// Actualiza los numeros completos
+	this->_update_complete();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuBoard::load_from_buffer(const char *buffer)
+{
+	short int valor = 0;
+	const CSudokuLayout *layout = m_layout;
+
+	*this = CSudokuBoard();
+	m_layout = layout;
+
+	// Like setValorByXY in every box, but complete values are updated once
+	for (int i = 0; i < E_SUDOKU_BOX_COUNT; i++)
+	{
+		if (buffer[i] == '.')
+		{
+			valor = 0;
+		}
+		else if (buffer[i] >= '0' && buffer[i] <= '9')
+		{
+			valor = buffer[i] - '0';
+		}
+		else
+		{
+			return false;
+		}
+
+		if (valor == 0) continue;
+
+		if (!rulesCheck(valor, i / E_SUDOKU_DIM, i % E_SUDOKU_DIM) ||
+			!_box(i).setValor(valor))
+		{
+			return false;
+		}
+		m_occupiedBoxCount++;
+		_restrict(i, valor);
+	}
+
+	this->_update_complete();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuBoard::save_to_buffer(char *buffer) const
+{
+	for (int i = 0; i < E_SUDOKU_BOX_COUNT; i++)
+	{
+		buffer[i] = '0' + _box(i).getValor();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int CSudokuBoard::get_heuristic(void) const
+{
+	int heuristic = 0;
+	int cuentatrue = 0;
+
+	for (int i = 0; i < E_SUDOKU_BOX_COUNT; i++)
+	{
+		const CSudokuBox &box = _box(i);
+		if (box.getValor() != 0) continue;
+
+		cuentatrue = 0;
+		for (int k = 1; k < E_SUDOKU_BOX_STATES_COUNT; k++)
+		{
+			if (box._posiblesValores[k]) cuentatrue++;
+		}
+
+		if (cuentatrue == 0) return E_SUDOKU_HEURISTIC_DEAD_END;
+		heuristic += cuentatrue;
+	}
+
+	return heuristic;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuBoard::rulesCheck(int valor, int posX, int posY)
+{
+	if(valor == 0) return true;
+	return (_boardBoxes[posX][posY])._posiblesValores[valor];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuBoard::_restrict(int box, short int valor)
+{
+	_box(box)._posiblesValores[valor] = false;
+
+	// Classic layout: compile-time peers, loop of fixed length
+	if (m_layout->is_classic())
+	{
+		const unsigned char *peers = sudoku_tables.peers[box];
+		for (int i = 0; i < E_SUDOKU_PEER_COUNT; i++)
+		{
+			_box(peers[i])._posiblesValores[valor] = false;
+		}
+		return;
+	}
+
+	const unsigned char *peers = m_layout->get_peers(box);
+	int peer_count = m_layout->get_peer_count(box);
+	for (int i = 0; i < peer_count; i++)
+	{
+		_box(peers[i])._posiblesValores[valor] = false;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuBoard::_update_restrictions(short int valor)
+{
+	int i;
+
+	// Pongo todo el tablero a true para ese valor
+	for (i = 0; i < E_SUDOKU_BOX_COUNT; i++)
+	{
+		_box(i)._posiblesValores[valor] = true;
+	}
+
+	// Establezco la restricciones en todo el tablero de nuevo para ese valor
+	for (i = 0; i < E_SUDOKU_BOX_COUNT; i++)
+	{
+		if (_box(i).getValor() == valor) _restrict(i, valor);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuBoard::_set_single_places(int unit, bool *dead)
+{
+	// Units of classic layout are the compile-time ones
+	const unsigned char *boxes = m_layout->is_classic() ? sudoku_tables.units[unit] :
+															m_layout->get_unit(unit);
+	bool insertion = false;
+	bool placed;
+	int cuenta, encontrado = 0;
+
+	for (int k = 1; k < E_SUDOKU_BOX_STATES_COUNT; k++)
+	{
+		cuenta = 0;
+		placed = false;
+		for (int i = 0; i < E_SUDOKU_DIM; i++)
+		{
+			const CSudokuBox &casilla = _box(boxes[i]);
+			if (casilla._posiblesValores[k] && casilla._posiblesValores[0])
+			{
+				cuenta++;
+				encontrado = boxes[i];
+			}
+			else if (casilla.getValor() == k)
+			{
+				placed = true;
+			}
+		}
+
+		// Value without possible box in unit
+		if (cuenta == 0 && !placed) *dead = true;
+
+		if (cuenta == 1 && _box(encontrado).getValor() == 0)
+		{
+			_set_valor(encontrado, k);
+			m_derived.set(encontrado);
+			insertion = true;
+		}
+	}
+
+	return insertion;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuBoard::_propagate(bool *dead)
+{
+	bool is_safe_children = false;
+	bool nuevaInsercion = false;
+	unsigned int i, k, l, cuentatrue, valor = 0;
+
+	do{
+		nuevaInsercion = false;
+		//--------------------------------------------------------------------------
+		// Rule 1. Check immediate values resolution
+		for(i = 0; i < E_SUDOKU_BOX_COUNT; i++)
+		{
+			// Pone el valor en la casilla donde solo se pueda poner ese
+			if(_box(i).getValor() == 0)
+			{ // solo pone en las casillas con 0
+				cuentatrue = 0;
+				for(k = 1; k < E_SUDOKU_BOX_STATES_COUNT; k++)
+				{
+					if(_box(i)._posiblesValores[k])
+					{
+						cuentatrue++;
+						valor=k;
+					}
+				}
+				if (cuentatrue == 0) *dead = true;
+				if( cuentatrue == 1)
+				{
+					_set_valor(i, valor);
+					m_derived.set(i);
+					is_safe_children=true;
+					nuevaInsercion = true;
+				}
+			}
+		}
+		//--------------------------------------------------------------------------
+		// Rules 2 to 4. Check 3x3 squares, then rows and columns (and extra
+		// units of layout)
+		for(l = 0; l < m_layout->get_unit_count(); l++)
+		{
+			if(_set_single_places(m_layout->get_propagation_unit(l), dead))
+			{
+				is_safe_children = true;
+				nuevaInsercion = true;
+			}
+		}
+
+		//--------------------------------------------------------------------------
+		// Rule 5. Killer cages, only possible values are removed
+		if (m_layout->get_cage_count() > 0 && _restrict_cages(dead))
+		{
+			nuevaInsercion = true;
+		}
+	}while(nuevaInsercion && !*dead);
+
+	return is_safe_children;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuBoard::_restrict_cages(bool *dead)
+{
+	bool restricted = false;
+
+	for (unsigned int c = 0; c < m_layout->get_cage_count(); c++)
+	{
+		const SSudokuCage &cage = m_layout->get_cage(c);
+		int sum = cage.sum;
+		int empty = 0;
+		uint16_t used = 0;
+		uint16_t possible = 0;
+
+		for (int i = 0; i < cage.size; i++)
+		{
+			const CSudokuBox &casilla = _box(cage.boxes[i]);
+			if (casilla.getValor() != 0)
+			{
+				sum -= casilla.getValor();
+				used |= 1 << casilla.getValor();
+				continue;
+			}
+
+			empty++;
+			for (int k = 1; k < E_SUDOKU_BOX_STATES_COUNT; k++)
+			{
+				if (casilla._posiblesValores[k]) possible |= 1 << k;
+			}
+		}
+
+		if (empty == 0)
+		{
+			if (sum != 0) *dead = true;
+			continue;
+		}
+
+		// Values of every set which can fill the empty boxes
+		uint16_t allowed = 0;
+		for (uint16_t values : CSudokuLayout::get_combinations(empty, sum))
+		{
+			if ((values & used) == 0 && (values & ~possible) == 0) allowed |= values;
+		}
+
+		if (allowed == 0)
+		{
+			*dead = true;
+			continue;
+		}
+
+		for (int i = 0; i < cage.size; i++)
+		{
+			CSudokuBox &casilla = _box(cage.boxes[i]);
+			if (casilla.getValor() != 0) continue;
+
+			for (int k = 1; k < E_SUDOKU_BOX_STATES_COUNT; k++)
+			{
+				if (casilla._posiblesValores[k] && !(allowed & (1 << k)))
+				{
+					casilla._posiblesValores[k] = false;
+					restricted = true;
+				}
+			}
+		}
+	}
+
+	return restricted;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuBoard CSudokuBoard::_get_values(const std::bitset<E_SUDOKU_BOX_COUNT> &boxes) const
+{
+	CSudokuBoard board;
+
+	// Like load_from_buffer, values come from a valid board
+	board.m_layout = m_layout;
+	for (int i = 0; i < E_SUDOKU_BOX_COUNT; i++)
+	{
+		short int valor = _box(i).getValor();
+		if (!boxes[i] || valor == 0) continue;
+
+		board._box(i).setValor(valor);
+		board.m_occupiedBoxCount++;
+		board._restrict(i, valor);
+	}
+
+	board._update_complete();
+	return board;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuBoard CSudokuBoard::get_nogood(void) const
+{
+	std::bitset<E_SUDOKU_BOX_COUNT> givens;
+	std::bitset<E_SUDOKU_BOX_COUNT> decisions = m_decisions;
+
+	for (int i = 0; i < E_SUDOKU_BOX_COUNT; i++)
+	{
+		if (_box(i).getValor() != 0 && !m_decisions[i] && !m_derived[i]) givens.set(i);
+	}
+
+	// Contradiction found by safe rules from givens and decisions
+	auto fails = [this, &givens](const std::bitset<E_SUDOKU_BOX_COUNT> &tried)
+	{
+		bool dead = false;
+		CSudokuBoard board = _get_values(givens | tried);
+		board._propagate(&dead);
+		return dead;
+	};
+
+	// Failed after a search, every decision is needed
+	if (decisions.none() || !fails(decisions)) return _get_values(decisions);
+
+	// Without the last decision, parent node fails too (see CNode::search)
+	if (m_last_decision >= 0)
+	{
+		decisions.reset(m_last_decision);
+		if (!fails(decisions)) decisions.set(m_last_decision);
+	}
+
+	for (int i = 0; i < E_SUDOKU_BOX_COUNT; i++)
+	{
+		if (!decisions[i] || i == m_last_decision) continue;
+
+		decisions.reset(i);
+		if (!fails(decisions)) decisions.set(i);
+	}
+
+	return _get_values(decisions);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Devuelve si un numero o todo el tablero esta completo
+// Si se pregunta por 0, es por todo el tablero,
+// y numero de 1 a 9 por su correpondiente
+// Cualquier valor fuera de [0,9] da false
+bool CSudokuBoard::is_complete(short int valor) const
+{
+	if( (valor<0) || (valor>9) ) return false;
+	return _completo[valor];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Comprueba si se ha completado algun numero o todo el tablero, y lo rellena en
+// en el vector _completo. Se recalcula entero: al vaciar casillas un numero (o
+// el tablero) deja de estar completo
+void CSudokuBoard::_update_complete(){
+
+	register int i;
+	int cuenta[E_SUDOKU_BOX_STATES_COUNT] = {0};
+	int k; // valores posibles de sudoku
+
+	for(i = 0; i < E_SUDOKU_BOX_COUNT; i++)
+	{
+		cuenta[_box(i).getValor()]++;
+	}
+
+	_completo[0] = true;
+	for(k = 1; k < E_SUDOKU_BOX_STATES_COUNT; k++)
+	{
+		_completo[k] = (cuenta[k] == E_SUDOKU_DIM);
+		_completo[0] = _completo[0] && _completo[k];
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+bool diferentes(const CSudokuBoard &primero, const CSudokuBoard &segundo){
+
+	if( primero.m_occupiedBoxCount != segundo.m_occupiedBoxCount) return true;
+
+	int i,j;	
+	bool diferencia = false;
+
+	for(i = 0; (i < E_SUDOKU_DIM && !diferencia); i++)
+	{
+		for(j = 0; (j < E_SUDOKU_DIM && !diferencia); j++)
+		{
+			if( (primero._boardBoxes[i][j]).getValor() !=
+				(segundo._boardBoxes[i][j]).getValor() )
+			{
+				diferencia = true;
+			}
+   		}
+	}
+	return diferencia;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool diferentes2(const CSudokuBoard &primero, const CSudokuBoard &segundo)
+{
+	register int i;
+	bool diferencia=false;
+	for(i = 0; (i < E_SUDOKU_BOX_COUNT && !diferencia); i++)
+	{
+		if( ( primero._box(i).getValor() != segundo._box(i).getValor() )
+			&& primero._box(i).getValor() != 0)
+		{
+			diferencia = true;
+		}
+	}
+	return diferencia;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief This function uses four rules to generate new sudoku boards from
+ * original "primero". These new boards are checked with visited
+ * before including them into solutions vector. It can generate safe children,
+ * with 100% probability, or probable children, if safe children cannot be generated.
+ * Probable children of the same box are consecutive, in numeric order of
+ * values unless context has a children order (see CSudokuValueOrder).
+ * If search is stopped (see CSearchContext::is_stopped), children aren't
+ * generated or only part of them are generated. Children come from a lazy
+ * generation (see beginChildrens), all of them are built here
+ * @param solutions
+ * @param context
+ * @param primero
+ * @return
+ */
+bool CSudokuBoard::generateSudokuBoardChildrens(std::vector<CSudokuBoard> *solutions,
+									CSearchContext<CSudokuBoard> *context,
+									const CSudokuBoard& primero) const
+{
+	SSudokuChildren cursor;
+
+	if (!primero.beginChildrens(&cursor, context)) return false;
+
+	// Children are built in their place in vector
+	do
+	{
+		solutions->emplace_back();
+	} while (nextChildren(&cursor, &solutions->back(), context));
+
+	solutions->pop_back();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuBoard::beginChildrens(SSudokuChildren *cursor,
+								CSearchContext<CSudokuBoard> *context) const
+{
+	// If sudoku board is completed, I cannot generate children
+	if (is_complete(0)) return false;
+
+	if (context->is_stopped()) return false;
+
+	context->trace(E_SEARCH_TRACE_EXPAND, m_occupiedBoxCount, m_last_decision,
+					(m_last_decision >= 0) ? _box(m_last_decision).getValor() : 0);
+
+	cursor->base = *this;
+	cursor->box_count = 0;
+	cursor->box_index = 0;
+	cursor->value_count = 0;
+	cursor->value_index = 0;
+	cursor->generated = 0;
+	cursor->safe = false;
+	cursor->done = false;
+
+	CSudokuBoard &aux1 = cursor->base;
+
+	// If there is a safe children (probability 100%)
+	// it will be returned as unique children
+
+	//--------------------------------------------------------------------------
+	// Safe rules, see _propagate
+	bool dead = false;
+	bool is_safe_children = aux1._propagate(&dead);
+
+	// Safe rules found a contradiction, there aren't children
+	if (dead)
+	{
+		context->trace(E_SEARCH_TRACE_DEAD_END, m_occupiedBoxCount);
+		return false;
+	}
+
+	//--------------------------------------------------------------------------
+	// 100% probability children
+	if (is_safe_children)
+	{
+		// A board which contains a failed board fails too
+		bool is_there_the_same_one = context->find_visited(aux1.m_occupiedBoxCount - 1,
+			[&aux1](const CSudokuBoard &visitado) { return !diferentes2(visitado, aux1); });
+		if (!is_there_the_same_one)
+		{
+			context->trace(E_SEARCH_TRACE_SAFE_CHILD, aux1.m_occupiedBoxCount);
+			cursor->safe = true;
+			return true;
+		}
+		context->trace(E_SEARCH_TRACE_VISITED_HIT, aux1.m_occupiedBoxCount);
+
+		// Probable children are built from original board. If safe rules
+		// didn't set any value, possible values they removed (killer cages)
+		// are kept
+		aux1 = *this;
+	}
+
+	//--------------------------------------------------------------------------
+	// Probability inclusion. From here, I'am going to include number in sudoku
+	// board with certain probability level but not sure.
+
+	// I have to find the box where it's less probable to make a mistake
+	// and order them.
+
+	// VERY IMPORTANT: THE LIMITS OF PROBABILITY MUST BE DEFINE CARESFULLY, THE
+	// EXTENSION OF SEARCH TREE CAN DESTROY YOUR RAM MEMORY JA JA JA JA ....
+	// LIMITS (2->50%, 3->33%, 4->25%, 5->20%, ...)
+
+	// Here, I have to decide how many children I are going to create, and probability
+	// level of them. More children -> more memory and CPU time. Limits come from
+	// search context (SSearchBranching), from 50% to 12.5% by default
+	const SSearchBranching &branching = context->get_branching();
+	unsigned int P = branching.min_values;
+	unsigned int P_limit = branching.max_values;
+	unsigned int l, k, cuentatrue;
+	int box;
+
+	// Boxes over the limit only if there isn't any other one (sparse boards)
+	for (l = P; l < P_limit || (l < E_SUDOKU_BOX_STATES_COUNT && cursor->box_count == 0); l++)
+	{
+		for (box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+		{
+			if (aux1._box(box).getValor() != 0) continue;
+
+			cuentatrue = 0;
+			for (k = 1; k < E_SUDOKU_BOX_STATES_COUNT; k++)
+			{
+				if (aux1._box(box)._posiblesValores[k]) cuentatrue++;
+			}
+			if (cuentatrue == l) cursor->boxes[cursor->box_count++] = box;
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// Memory budget reached: depth-first with bounded frontier. Only the box
+	// with less possible values is expanded, one child for each value. The
+	// search is still complete because that box must have one of them.
+	// Some search policies always want this bounded branching.
+	bool memory_exceeded = context->is_memory_exceeded();
+	if ((memory_exceeded || context->get_bounded_branching()) && cursor->box_count > 1)
+	{
+		cursor->box_count = 1;
+		if (memory_exceeded) context->bounded_expansion();
+	}
+	else if (cursor->box_count > 1)
+	{
+		cursor->box_count = context->get_fan_out(cursor->box_count, m_occupiedBoxCount);
+	}
+
+	_load_values(cursor, context);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuBoard::nextChildren(SSudokuChildren *cursor, CSudokuBoard *child,
+								CSearchContext<CSudokuBoard> *context)
+{
+	if (cursor->safe)
+	{
+		cursor->safe = false;
+		cursor->generated++;
+		*child = cursor->base;
+		return true;
+	}
+
+	// Every possible value of a box is tried, children in visited store (or
+	// which include a failed board) are skipped. Boxes are tried one after
+	// other, but when a child is skipped its box becomes the last one: values
+	// of a box are all the choices, so children of one box are enough not to
+	// lose any solution
+	while (cursor->box_index < cursor->box_count && !context->is_stopped())
+	{
+		int box = cursor->boxes[cursor->box_index];
+
+		while (cursor->value_index < cursor->value_count)
+		{
+			short int valor = cursor->values[cursor->value_index++];
+
+			*child = cursor->base;
+			child->_set_valor(box, valor);
+
+			bool is_there_the_same_one = context->find_visited(child->m_occupiedBoxCount - 1,
+				[child](const CSudokuBoard &visitado) { return !diferentes2(visitado, *child); });
+			context->trace(is_there_the_same_one ? E_SEARCH_TRACE_VISITED_HIT :
+							E_SEARCH_TRACE_PROBABLE_CHILD,
+							child->m_occupiedBoxCount, box, valor);
+
+			if (!is_there_the_same_one)
+			{
+				child->_set_decision(box);
+				cursor->generated++;
+				if (context->log()) *context->log() << ". ";
+				return true;
+			}
+
+			cursor->box_count = cursor->box_index + 1;
+		}
+
+		cursor->box_index++;
+		_load_values(cursor, context);
+	}
+
+	if (!cursor->done && cursor->generated == 0)
+	{
+		context->trace(E_SEARCH_TRACE_DEAD_END, cursor->base.m_occupiedBoxCount);
+	}
+	cursor->done = true;
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuBoard::_load_values(SSudokuChildren *cursor,
+								CSearchContext<CSudokuBoard> *context)
+{
+	cursor->value_count = 0;
+	cursor->value_index = 0;
+	if (cursor->box_index >= cursor->box_count) return;
+
+	int box = cursor->boxes[cursor->box_index];
+	const CSudokuBox &casilla = cursor->base._box(box);
+	for (short int valor = 1; valor < E_SUDOKU_BOX_STATES_COUNT; valor++)
+	{
+		if (casilla._posiblesValores[valor]) cursor->values[cursor->value_count++] = valor;
+	}
+
+	// Values of every box are tried in the order chosen by context
+	if (context->get_children_order())
+	{
+		context->get_children_order()->order(cursor->base, box, cursor->values,
+											cursor->value_count);
+	}
+}
+
+} // namespace sudoku
@@ -0,0 +1,245 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_capi.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_capi.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#include "sudoku.h"
+
+#include <mutex>
+#include <new>
+
+#include "sudoku_worker.hpp"
+#include "sudoku_session.hpp"
+#include "sudoku_validator.hpp"
+
+using namespace sudoku;
+
+static_assert(SUDOKU_BOARD_SIZE == E_SUDOKU_BOX_COUNT, "Board size mismatch");
+static_assert((int)SUDOKU_SOLVED == (int)CSudokuWorker::E_SUDOKU_WORKER_SOLVED &&
+			(int)SUDOKU_UNSOLVABLE == (int)CSudokuWorker::E_SUDOKU_WORKER_UNSOLVABLE &&
+			(int)SUDOKU_INVALID == (int)CSudokuWorker::E_SUDOKU_WORKER_INVALID &&
+			(int)SUDOKU_TIMED_OUT == (int)CSudokuWorker::E_SUDOKU_WORKER_TIMED_OUT,
+			"Result mismatch");
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Opaque C context, a worker with its options and the lock to share it
+ * between threads
+ */
+struct sudoku_context
+{
+	SSudokuWorkerOptions options;
+	CSudokuWorker worker;
+	std::mutex mutex;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Opaque C session, it isn't shared between threads
+ */
+struct sudoku_session
+{
+	SSudokuWorkerOptions options;
+	CSudokuSession session;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Write session solution like sudoku_solve
+ * @param session
+ * @param result
+ * @param solution
+ * @return result
+ */
+static int _session_solution(const CSudokuSession &session, int result, char *solution)
+{
+	if (result == SUDOKU_UNSOLVABLE)
+	{
+		memset(solution, '0', SUDOKU_BOARD_SIZE);
+	}
+	else if (result != SUDOKU_INVALID)
+	{
+		session.get_solution().save_to_buffer(solution);
+	}
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int sudoku_api_version(void)
+{
+	return SUDOKU_API_VERSION;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+sudoku_context *sudoku_context_new(void)
+{
+	return new (std::nothrow) sudoku_context;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void sudoku_context_free(sudoku_context *context)
+{
+	delete context;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void sudoku_context_set_memory_limit(sudoku_context *context, size_t limit)
+{
+	if (context == nullptr) return;
+
+	std::lock_guard<std::mutex> lock(context->mutex);
+	context->options.memory_limit = limit;
+	context->worker.set_options(context->options);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void sudoku_set_process_memory_limit(size_t limit)
+{
+	CMemoryBudget::process().set_limit(limit);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int sudoku_context_memory_degraded(sudoku_context *context)
+{
+	if (context == nullptr) return 0;
+
+	std::lock_guard<std::mutex> lock(context->mutex);
+	return context->worker.get_statistics().is_degraded() ? 1 : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void sudoku_context_set_timeout(sudoku_context *context, unsigned long timeout)
+{
+	if (context == nullptr) return;
+
+	std::lock_guard<std::mutex> lock(context->mutex);
+	context->options.timeout = timeout;
+	context->worker.set_options(context->options);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void sudoku_context_cancel(sudoku_context *context)
+{
+	if (context == nullptr) return;
+
+	// Without lock, sudoku_solve keeps it while it's running
+	context->worker.cancel();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int sudoku_solve(sudoku_context *context, const char *puzzle, char *solution)
+{
+	if (context == nullptr || puzzle == nullptr || solution == nullptr)
+	{
+		return SUDOKU_ERROR;
+	}
+
+	// C++ exceptions can't go through C callers
+	try
+	{
+		std::lock_guard<std::mutex> lock(context->mutex);
+		return context->worker.solve(puzzle, solution);
+	}
+	catch (...)
+	{
+		return SUDOKU_ERROR;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+sudoku_session *sudoku_session_new(void)
+{
+	return new (std::nothrow) sudoku_session;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void sudoku_session_free(sudoku_session *session)
+{
+	delete session;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void sudoku_session_set_timeout(sudoku_session *session, unsigned long timeout)
+{
+	if (session == nullptr) return;
+
+	session->options.timeout = timeout;
+	session->session.set_options(session->options);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int sudoku_session_load(sudoku_session *session, const char *puzzle, char *solution)
+{
+	if (session == nullptr || puzzle == nullptr || solution == nullptr)
+	{
+		return SUDOKU_ERROR;
+	}
+
+	try
+	{
+		return _session_solution(session->session, session->session.load(puzzle),
+								solution);
+	}
+	catch (...)
+	{
+		return SUDOKU_ERROR;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int sudoku_session_set(sudoku_session *session, int row, int column, int value,
+						char *solution)
+{
+	if (session == nullptr || solution == nullptr) return SUDOKU_ERROR;
+
+	if (row < 0 || row >= E_SUDOKU_DIM || column < 0 || column >= E_SUDOKU_DIM ||
+		value < 0 || value > E_SUDOKU_DIM)
+	{
+		return SUDOKU_INVALID;
+	}
+
+	try
+	{
+		return _session_solution(session->session,
+					session->session.set_value(value, row, column), solution);
+	}
+	catch (...)
+	{
+		return SUDOKU_ERROR;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+long sudoku_validate(const char *solutions, const char *puzzles, size_t count,
+					unsigned char *valid)
+{
+	if (solutions == nullptr && count > 0) return SUDOKU_ERROR;
+
+	try
+	{
+		static const CSudokuValidator validator;
+		return validator.validate(solutions, puzzles, count, valid);
+	}
+	catch (...)
+	{
+		return SUDOKU_ERROR;
+	}
+}
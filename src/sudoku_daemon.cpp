@@ -0,0 +1,480 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_daemon.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_daemon.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#include "sudoku_daemon.hpp"
+
+#include <cerrno>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+namespace sudoku{
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuDaemon::CSudokuDaemon(const std::string &socket_path,
+							unsigned int worker_count,
+							const SSudokuWorkerOptions &options):
+	m_socket_path(socket_path), m_worker_count(worker_count), m_options(options),
+	m_listen_fd(-1), m_stop_requested(false), m_stop(false), m_metrics(nullptr)
+{
+	m_wake_fd[0] = -1;
+	m_wake_fd[1] = -1;
+
+	if (m_worker_count == 0)
+	{
+		m_worker_count = std::thread::hardware_concurrency();
+		if (m_worker_count == 0) m_worker_count = 1;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuDaemon::~CSudokuDaemon()
+{
+	if (m_metrics) m_metrics->set_queue_depth(nullptr);
+
+	{
+		std::lock_guard<std::mutex> lock(m_jobs_mutex);
+		m_stop = true;
+
+		// Workers don't take more jobs, waiting boards are answered here
+		for (auto &job : m_jobs) _fail_job(&job);
+		m_jobs.clear();
+	}
+	m_jobs_cond.notify_all();
+	m_room_cond.notify_all();
+
+	// Readers blocked in socket wake up, running searches stop
+	for (auto &connection : m_connections)
+	{
+		connection.cancel->cancel();
+		shutdown(connection.fd, SHUT_RDWR);
+	}
+
+	for (auto &worker : m_workers) worker.join();
+	_join_connections(true);
+
+	if (m_listen_fd >= 0)
+	{
+		close(m_listen_fd);
+		unlink(m_socket_path.c_str());
+	}
+	if (m_wake_fd[0] >= 0)
+	{
+		close(m_wake_fd[0]);
+		close(m_wake_fd[1]);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuDaemon::stop(void)
+{
+	m_stop_requested.store(true);
+	_wake();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int CSudokuDaemon::run(void)
+{
+	struct sockaddr_un address;
+
+	if (m_socket_path.size() >= sizeof(address.sun_path))
+	{
+		std::cerr << " Socket path too long: " << m_socket_path << std::endl;
+		return -1;
+	}
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, m_socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+	// Connections which finish and stop() wake up accept loop
+	if (pipe(m_wake_fd) < 0 || fcntl(m_wake_fd[0], F_SETFL, O_NONBLOCK) < 0 ||
+		fcntl(m_wake_fd[1], F_SETFL, O_NONBLOCK) < 0)
+	{
+		std::cerr << " Error creating pipe: " << strerror(errno) << std::endl;
+		return -1;
+	}
+
+	m_listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (m_listen_fd < 0 || fcntl(m_listen_fd, F_SETFL, O_NONBLOCK) < 0)
+	{
+		std::cerr << " Error creating socket: " << strerror(errno) << std::endl;
+		return -1;
+	}
+
+	unlink(m_socket_path.c_str());
+	if (bind(m_listen_fd, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+		listen(m_listen_fd, SOMAXCONN) < 0)
+	{
+		std::cerr << " Error listening in " << m_socket_path << ": "
+					<< strerror(errno) << std::endl;
+		return -1;
+	}
+
+	// Boards waiting for a worker
+	if (m_metrics)
+	{
+		m_metrics->set_queue_depth([this]
+		{
+			std::lock_guard<std::mutex> lock(m_jobs_mutex);
+			return (long)m_jobs.size();
+		});
+	}
+
+	for (unsigned int i = 0; i < m_worker_count; i++)
+	{
+		m_workers.push_back(std::thread(&CSudokuDaemon::_worker_loop, this));
+	}
+
+	std::cout << " Sudoku daemon listening in " << m_socket_path << " with "
+				<< m_worker_count << " workers" << std::endl;
+
+	struct pollfd events[2] = {{m_listen_fd, POLLIN, 0}, {m_wake_fd[0], POLLIN, 0}};
+	char wake[64];
+
+	while (!m_stop_requested.load())
+	{
+		if (poll(events, 2, -1) < 0)
+		{
+			if (errno == EINTR) continue;
+			std::cerr << " Error waiting for connections: " << strerror(errno)
+						<< std::endl;
+			return -1;
+		}
+
+		// Finished connections are joined as soon as they finish
+		if (events[1].revents & POLLIN)
+		{
+			while (read(m_wake_fd[0], wake, sizeof(wake)) > 0);
+			_join_connections(false);
+		}
+		if (!(events[0].revents & POLLIN)) continue;
+
+		int fd = accept(m_listen_fd, nullptr, nullptr);
+		if (fd < 0)
+		{
+			if (errno == EINTR || errno == ECONNABORTED || errno == EAGAIN ||
+				errno == EWOULDBLOCK)
+			{
+				continue;
+			}
+			std::cerr << " Error accepting connection: " << strerror(errno)
+						<< std::endl;
+			return -1;
+		}
+
+		// Connection sockets block, only listening socket doesn't
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+		m_connections.emplace_back(fd);
+		SConnection *connection = &m_connections.back();
+		connection->thread = std::thread(&CSudokuDaemon::_connection_loop, this, connection);
+	}
+
+	// New clients can't connect, connections are stopped by destructor
+	close(m_listen_fd);
+	m_listen_fd = -1;
+	unlink(m_socket_path.c_str());
+
+	std::cout << " Sudoku daemon stopped" << std::endl;
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuDaemon::_wake(void)
+{
+	// Write end doesn't block, a full pipe wakes up accept loop anyway
+	if (m_wake_fd[1] >= 0)
+	{
+		ssize_t written = write(m_wake_fd[1], "w", 1);
+		(void)written;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuDaemon::_worker_loop(void)
+{
+	// Worker allocations are reused by every board solved in this thread
+	CSudokuWorker worker(m_options);
+	std::unique_ptr<CSudokuPortfolio> portfolio;
+	CSudokuMetrics::SThreadMetrics *slot =
+							m_metrics ? m_metrics->register_thread() : nullptr;
+	std::string result(E_SUDOKU_DAEMON_RESULT_SIZE, '0');
+	int status = 0;
+
+	if (!m_options.portfolio.empty()) portfolio.reset(new CSudokuPortfolio(m_options));
+
+	while (true)
+	{
+		SJob job;
+		{
+			std::unique_lock<std::mutex> lock(m_jobs_mutex);
+			m_jobs_cond.wait(lock, [this]{ return m_stop || !m_jobs.empty(); });
+			if (m_stop) return;
+
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+		m_room_cond.notify_one();
+
+		// Client closed its connection
+		if (job.cancel->is_cancelled())
+		{
+			_fail_job(&job);
+			continue;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		if (portfolio)
+		{
+			status = portfolio->solve(job.puzzle.data(), &result[1], job.cancel.get());
+			if (slot && status == CSudokuWorker::E_SUDOKU_WORKER_SOLVED)
+			{
+				CSudokuMetrics::record_win(slot, portfolio->get_winner());
+			}
+		}
+		else
+		{
+			worker.set_cancel_token(job.cancel.get());
+			status = worker.solve(job.puzzle.data(), &result[1]);
+			worker.set_cancel_token(nullptr);
+		}
+
+		if (slot)
+		{
+			CSudokuMetrics::record(slot, std::chrono::steady_clock::now() - start,
+								get_outcome_by_result(status));
+			CSudokuMetrics::record_search(slot, portfolio ? portfolio->get_statistics() :
+														worker.get_statistics());
+		}
+
+		result[0] = '0' + status;
+		job.result.set_value(result);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::future<std::string> CSudokuDaemon::_submit(const char *puzzle,
+											const std::shared_ptr<CCancelToken> &cancel)
+{
+	SJob job;
+	job.puzzle.assign(puzzle, E_SUDOKU_BOX_COUNT);
+	job.cancel = cancel;
+	std::future<std::string> result = job.result.get_future();
+
+	{
+		std::unique_lock<std::mutex> lock(m_jobs_mutex);
+		m_room_cond.wait(lock, [this]{
+			return m_stop || m_jobs.size() < E_SUDOKU_DAEMON_MAX_QUEUED_BOARDS; });
+		if (m_stop)
+		{
+			_fail_job(&job);
+			return result;
+		}
+		m_jobs.push_back(std::move(job));
+	}
+	m_jobs_cond.notify_one();
+
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuDaemon::_fail_job(SJob *job)
+{
+	std::string result(1, '0' + CSudokuWorker::E_SUDOKU_WORKER_TIMED_OUT);
+	job->result.set_value(result + job->puzzle);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuDaemon::_join_connections(bool all)
+{
+	for (auto it = m_connections.begin(); it != m_connections.end();)
+	{
+		if (all || it->done)
+		{
+			it->thread.join();
+			close(it->fd);
+			it = m_connections.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Every connection has two threads: this one reads requests and sends their
+// boards to workers, and the writer waits for results in request order.
+void CSudokuDaemon::_connection_loop(SConnection *connection)
+{
+	int fd = connection->fd;
+	typedef std::vector< std::future<std::string> > TRequestResults;
+
+	std::deque<TRequestResults> pending;
+	std::mutex pending_mutex;
+	std::condition_variable pending_cond;
+	bool reader_done = false;
+	bool writer_done = false;
+
+	std::thread writer([&]()
+	{
+		bool connection_ok = true;
+		std::string response;
+
+		while (true)
+		{
+			TRequestResults results;
+			{
+				std::unique_lock<std::mutex> lock(pending_mutex);
+				pending_cond.wait(lock, [&]{ return reader_done || !pending.empty(); });
+				if (pending.empty())
+				{
+					writer_done = true;
+					return;
+				}
+
+				results = std::move(pending.front());
+				pending.pop_front();
+			}
+			pending_cond.notify_all();
+
+			uint32_t length = htonl(results.size() * E_SUDOKU_DAEMON_RESULT_SIZE);
+			response.assign((const char *)&length, sizeof(length));
+			for (auto &result : results) response += result.get();
+
+			if (connection_ok)
+			{
+				connection_ok = _write_full(fd, response.data(), response.size());
+				if (!connection_ok)
+				{
+					connection->cancel->cancel();
+					shutdown(fd, SHUT_RD);
+				}
+			}
+		}
+	});
+
+	std::vector<char> request;
+	uint32_t length = 0;
+
+	while (_read_full(fd, &length, sizeof(length)))
+	{
+		length = ntohl(length);
+		if (length % E_SUDOKU_BOX_COUNT != 0 ||
+			length / E_SUDOKU_BOX_COUNT > E_SUDOKU_DAEMON_MAX_BOARDS_BY_REQUEST)
+		{
+			std::cerr << " Invalid request length: " << length << std::endl;
+			break;
+		}
+
+		request.resize(length);
+		if (length > 0 && !_read_full(fd, request.data(), length)) break;
+
+		TRequestResults results;
+		for (uint32_t offset = 0; offset < length; offset += E_SUDOKU_BOX_COUNT)
+		{
+			results.push_back(_submit(&request[offset], connection->cancel));
+		}
+
+		// Requests in flight are limited, client waits here if writer is slow
+		std::unique_lock<std::mutex> lock(pending_mutex);
+		pending_cond.wait(lock, [&]{
+			return pending.size() < E_SUDOKU_DAEMON_MAX_REQUESTS_IN_FLIGHT; });
+		pending.push_back(std::move(results));
+		lock.unlock();
+		pending_cond.notify_all();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(pending_mutex);
+		reader_done = true;
+	}
+	pending_cond.notify_all();
+
+	// A client can close only its write side and wait for responses, its
+	// searches are cancelled when it closes the whole connection
+	while (true)
+	{
+		{
+			std::lock_guard<std::mutex> lock(pending_mutex);
+			if (writer_done) break;
+		}
+
+		struct pollfd hang_up = {fd, 0, 0};
+		if (poll(&hang_up, 1, 100) > 0 && (hang_up.revents & (POLLHUP | POLLERR)))
+		{
+			connection->cancel->cancel();
+			break;
+		}
+	}
+
+	// Socket is closed when thread is joined, so fd can't be reused before
+	writer.join();
+	shutdown(fd, SHUT_RDWR);
+	connection->done = true;
+	_wake();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuDaemon::_read_full(int fd, void *buffer, size_t size)
+{
+	char *position = (char *)buffer;
+	ssize_t count = 0;
+
+	while (size > 0)
+	{
+		count = read(fd, position, size);
+		if (count < 0 && errno == EINTR) continue;
+		if (count <= 0) return false;
+
+		position += count;
+		size -= count;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuDaemon::_write_full(int fd, const void *buffer, size_t size)
+{
+	const char *position = (const char *)buffer;
+	ssize_t count = 0;
+
+	while (size > 0)
+	{
+		count = send(fd, position, size, MSG_NOSIGNAL);
+		if (count < 0 && errno == EINTR) continue;
+		if (count <= 0) return false;
+
+		position += count;
+		size -= count;
+	}
+
+	return true;
+}
+
+} // namespace sudoku
@@ -0,0 +1,282 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_journal.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_journal.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#include "sudoku_journal.hpp"
+
+#include <cerrno>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace sudoku{
+
+static const char JOURNAL_MAGIC[8] = {'S', 'U', 'D', 'O', 'K', 'U', 'J', '2'};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Write all bytes, write() can write only part of them
+ */
+static bool write_all(int fd, const unsigned char *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t written = write(fd, data, size);
+		if (written < 0)
+		{
+			if (errno == EINTR) continue;
+			return false;
+		}
+		data += written;
+		size -= written;
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuJournal::CSudokuJournal(): m_fd(-1), m_sync_interval(0), m_resume_count(0),
+	m_resume_offset(0), m_pending_offset(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuJournal::~CSudokuJournal()
+{
+	if (m_fd >= 0)
+	{
+		sync();
+		close(m_fd);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuJournal::open(const std::string &path, std::istream &input,
+						std::chrono::milliseconds sync_interval)
+{
+	uint64_t input_id[2];
+	unsigned char header[sizeof(JOURNAL_MAGIC) + sizeof(input_id)];
+
+	_identify(input, input_id);
+
+	m_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (m_fd < 0)
+	{
+		perror(" Error opening journal");
+		return false;
+	}
+
+	m_sync_interval = sync_interval;
+	m_last_sync = std::chrono::steady_clock::now();
+
+	ssize_t size = read(m_fd, header, sizeof(header));
+	if (size <= 0)
+	{
+		// New journal
+		memcpy(header, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+		memcpy(header + sizeof(JOURNAL_MAGIC), input_id, sizeof(input_id));
+		return write_all(m_fd, header, sizeof(header)) && fsync(m_fd) == 0;
+	}
+
+	if (size != (ssize_t)sizeof(header) ||
+		memcmp(header, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0 ||
+		memcmp(header + sizeof(JOURNAL_MAGIC), input_id, sizeof(input_id)) != 0)
+	{
+		std::cerr << " Error: journal " << path << " isn't of this batch file"
+				<< std::endl;
+		return false;
+	}
+
+	return _load();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuJournal::get_result(long index, int *status, CSudokuBoard *board) const
+{
+	const unsigned char *result = &m_loaded[index * E_SUDOKU_JOURNAL_RESULT_SIZE];
+	char buffer[E_SUDOKU_BOX_COUNT];
+
+	*status = result[0];
+	for (int i = 0; i < E_SUDOKU_BOX_COUNT; i++)
+	{
+		buffer[i] = '0' + ((result[1 + i / 2] >> ((i % 2) * 4)) & 0x0F);
+	}
+	board->load_from_buffer(buffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuJournal::release(void)
+{
+	std::vector<unsigned char>().swap(m_loaded);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuJournal::append(int status, const CSudokuBoard &board,
+							std::streamoff input_offset)
+{
+	char buffer[E_SUDOKU_BOX_COUNT];
+	size_t begin = m_pending.size();
+
+	// Room for block count
+	if (begin == 0) m_pending.resize(sizeof(uint32_t));
+	begin = m_pending.size();
+
+	board.save_to_buffer(buffer);
+	m_pending.resize(begin + E_SUDOKU_JOURNAL_RESULT_SIZE, 0);
+	m_pending[begin] = status;
+	for (int i = 0; i < E_SUDOKU_BOX_COUNT; i++)
+	{
+		m_pending[begin + 1 + i / 2] |= (buffer[i] - '0') << ((i % 2) * 4);
+	}
+	m_pending_offset = input_offset;
+
+	return sync_if_due();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuJournal::sync_if_due(void)
+{
+	if (m_pending.empty() ||
+		std::chrono::steady_clock::now() - m_last_sync < m_sync_interval)
+	{
+		return true;
+	}
+	return sync();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuJournal::sync(void)
+{
+	m_last_sync = std::chrono::steady_clock::now();
+	if (m_pending.empty() || m_fd < 0) return true;
+
+	uint32_t count = (m_pending.size() - sizeof(uint32_t)) / E_SUDOKU_JOURNAL_RESULT_SIZE;
+	int64_t offset = m_pending_offset;
+
+	memcpy(&m_pending[0], &count, sizeof(count));
+	m_pending.insert(m_pending.end(), (unsigned char *)&offset,
+					(unsigned char *)&offset + sizeof(offset));
+
+	uint32_t checksum = _checksum(m_pending.data(), m_pending.size());
+	m_pending.insert(m_pending.end(), (unsigned char *)&checksum,
+					(unsigned char *)&checksum + sizeof(checksum));
+
+	bool written = write_all(m_fd, m_pending.data(), m_pending.size()) && fsync(m_fd) == 0;
+	if (!written) perror(" Error writing journal");
+
+	m_pending.clear();
+	return written;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuJournal::_load(void)
+{
+	off_t valid_end = lseek(m_fd, 0, SEEK_CUR);
+	off_t file_end = lseek(m_fd, 0, SEEK_END);
+	std::vector<unsigned char> block;
+
+	if (valid_end < 0 || file_end < 0 || lseek(m_fd, valid_end, SEEK_SET) < 0)
+	{
+		perror(" Error reading journal");
+		return false;
+	}
+
+	while (true)
+	{
+		uint32_t count = 0;
+		if (read(m_fd, &count, sizeof(count)) != (ssize_t)sizeof(count)) break;
+
+		// Count of a torn block can be anything, it must fit in file
+		size_t size = sizeof(count) + (size_t)count * E_SUDOKU_JOURNAL_RESULT_SIZE +
+						sizeof(int64_t) + sizeof(uint32_t);
+		if ((uint64_t)size > (uint64_t)(file_end - valid_end)) break;
+		block.resize(size);
+		memcpy(block.data(), &count, sizeof(count));
+
+		ssize_t rest = size - sizeof(count);
+		if (read(m_fd, block.data() + sizeof(count), rest) != rest) break;
+
+		uint32_t checksum;
+		memcpy(&checksum, block.data() + size - sizeof(checksum), sizeof(checksum));
+		if (_checksum(block.data(), size - sizeof(checksum)) != checksum) break;
+
+		int64_t offset;
+		memcpy(&offset, block.data() + size - sizeof(checksum) - sizeof(offset),
+				sizeof(offset));
+
+		m_loaded.insert(m_loaded.end(), block.begin() + sizeof(count),
+						block.begin() + sizeof(count) + count * E_SUDOKU_JOURNAL_RESULT_SIZE);
+		m_resume_count += count;
+		m_resume_offset = offset;
+		valid_end += size;
+	}
+
+	// Incomplete block of a crash
+	if (ftruncate(m_fd, valid_end) != 0 || lseek(m_fd, valid_end, SEEK_SET) < 0)
+	{
+		perror(" Error truncating journal");
+		return false;
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuJournal::_identify(std::istream &input, uint64_t *id)
+{
+	char buffer[64 * 1024];
+	uint64_t hash = 14695981039346656037ull;
+	uint64_t size = 0;
+
+	// FNV-1a of every byte
+	input.clear();
+	input.seekg(0);
+	while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0)
+	{
+		for (std::streamsize i = 0; i < input.gcount(); i++)
+		{
+			hash ^= (unsigned char)buffer[i];
+			hash *= 1099511628211ull;
+		}
+		size += input.gcount();
+	}
+	input.clear();
+	input.seekg(0);
+
+	id[0] = size;
+	id[1] = hash;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint32_t CSudokuJournal::_checksum(const unsigned char *data, size_t size)
+{
+	uint32_t hash = 2166136261u;
+
+	// FNV-1a
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+} // namespace sudoku
@@ -0,0 +1,225 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_lanes.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_lanes.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#include "sudoku_lanes.hpp"
+#include "sudoku_tables.hpp"
+
+namespace sudoku{
+
+// Bit v is value v, bit 0 isn't used
+static const uint16_t ALL_VALUES = 0x3FE;
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuLanes::CSudokuLanes()
+{
+	clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuLanes::clear(void)
+{
+	const lane_vector zero = {0};
+
+	for (auto &values : m_values) values = zero;
+	for (auto &used : m_used) used = zero;
+	m_failed = zero;
+
+	m_count = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuLanes::add(const CSudokuBoard &board)
+{
+	if (m_count == E_SUDOKU_LANES_COUNT) return false;
+
+	unsigned int lane = m_count++;
+	char buffer[E_SUDOKU_BOX_COUNT];
+
+	board.save_to_buffer(buffer);
+
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		if (buffer[box] == '0') continue;
+
+		uint16_t valor = 1 << (buffer[box] - '0');
+		for (int u = 0; u < E_SUDOKU_UNITS_BY_BOX; u++)
+		{
+			lane_vector &used = m_used[sudoku_tables.box_units[box][u]];
+
+			// Repeated value in a unit
+			if (used[lane] & valor) m_failed[lane] = 1;
+			used[lane] |= valor;
+		}
+		m_values[box][lane] = valor;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuLanes::propagate(void)
+{
+	bool changed = true;
+
+	while (changed)
+	{
+		changed = _naked_singles();
+		changed = _hidden_singles() || changed;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuLanes::is_solved(unsigned int lane) const
+{
+	if (lane >= m_count || m_failed[lane]) return false;
+
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		if (m_values[box][lane] == 0) return false;
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuLanes::get_board(unsigned int lane, CSudokuBoard *board) const
+{
+	if (lane >= m_count) return false;
+
+	char buffer[E_SUDOKU_BOX_COUNT];
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		buffer[box] = '0';
+		for (int valor = 1; valor <= E_SUDOKU_DIM; valor++)
+		{
+			if (m_values[box][lane] & (1 << valor)) buffer[box] = '0' + valor;
+		}
+	}
+
+	return board->load_from_buffer(buffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuLanes::_assign(int box, const lane_vector &values)
+{
+	const unsigned char *units = sudoku_tables.box_units[box];
+
+	m_values[box] |= values;
+	m_used[units[0]] |= values;
+	m_used[units[1]] |= values;
+	m_used[units[2]] |= values;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuLanes::_get_possible(int box, lane_vector &possible) const
+{
+	const unsigned char *units = sudoku_tables.box_units[box];
+	lane_vector empty = (lane_vector)(m_values[box] == 0);
+
+	possible = empty & ~(m_used[units[0]] | m_used[units[1]] | m_used[units[2]]) &
+				ALL_VALUES;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuLanes::_any(const lane_vector &values)
+{
+	uint16_t any = 0;
+	for (int lane = 0; lane < E_SUDOKU_LANES_COUNT; lane++) any |= values[lane];
+	return any != 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuLanes::_naked_singles(void)
+{
+	bool changed = false;
+
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		lane_vector possible;
+
+		_get_possible(box, possible);
+
+		// Empty box without possible values
+		m_failed |= (lane_vector)((m_values[box] | possible) == 0);
+
+		lane_vector singles = possible & (lane_vector)((possible & (possible - 1)) == 0);
+		if (_any(singles))
+		{
+			_assign(box, singles);
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuLanes::_hidden_singles(void)
+{
+	bool changed = false;
+	int i;
+
+	for (int unit = 0; unit < E_SUDOKU_UNIT_COUNT; unit++)
+	{
+		const unsigned char *boxes = sudoku_tables.units[unit];
+		lane_vector once = {0};
+		lane_vector twice = {0};
+
+		for (i = 0; i < E_SUDOKU_DIM; i++)
+		{
+			lane_vector possible;
+
+			_get_possible(boxes[i], possible);
+			twice |= once & possible;
+			once |= possible;
+		}
+
+		// A value without box in unit is a dead end
+		m_failed |= (lane_vector)((once | m_used[unit]) != ALL_VALUES);
+
+		once &= ~twice;
+		if (!_any(once)) continue;
+
+		for (i = 0; i < E_SUDOKU_DIM; i++)
+		{
+			lane_vector singles;
+
+			_get_possible(boxes[i], singles);
+			singles &= once;
+			lane_vector several = (lane_vector)((singles & (singles - 1)) != 0);
+
+			// Two values can't be only in the same box
+			m_failed |= several;
+			singles &= ~several;
+
+			if (_any(singles))
+			{
+				_assign(boxes[i], singles);
+				changed = true;
+			}
+		}
+	}
+
+	return changed;
+}
+
+} // namespace sudoku
@@ -0,0 +1,329 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_layout.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_layout.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#include "sudoku_solver.hpp"
+#include "sudoku_tables.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace sudoku{
+
+const CSudokuLayout *CSudokuLayout::m_default = nullptr;
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuLayout::CSudokuLayout(): m_unit_count(E_SUDOKU_UNIT_COUNT), m_classic(true)
+{
+	unsigned int i = 0;
+
+	for (int unit = 0; unit < E_SUDOKU_UNIT_COUNT; unit++)
+	{
+		for (int j = 0; j < E_SUDOKU_DIM; j++) m_units[unit][j] = sudoku_tables.units[unit][j];
+	}
+
+	// Squares first, then rows and columns, like the original rules 2 to 4
+	for (int l = 0; l < E_SUDOKU_DIM; l++) m_order[i++] = E_SUDOKU_FIRST_SQUARE_UNIT + l;
+	for (int l = 0; l < E_SUDOKU_DIM; l++)
+	{
+		m_order[i++] = E_SUDOKU_FIRST_ROW_UNIT + l;
+		m_order[i++] = E_SUDOKU_FIRST_COLUMN_UNIT + l;
+	}
+
+	for (auto &cage : m_box_cage) cage = -1;
+	_compile();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuLayout::set_regions(const char *regions)
+{
+	unsigned char units[E_SUDOKU_DIM][E_SUDOKU_DIM];
+	int count[E_SUDOKU_DIM] = {0};
+
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		int region = regions[box] - '1';
+		if (region < 0 || region >= E_SUDOKU_DIM || count[region] == E_SUDOKU_DIM)
+		{
+			return false;
+		}
+		units[region][count[region]++] = box;
+	}
+
+	for (int region = 0; region < E_SUDOKU_DIM; region++)
+	{
+		for (int j = 0; j < E_SUDOKU_DIM; j++)
+		{
+			m_units[E_SUDOKU_FIRST_SQUARE_UNIT + region][j] = units[region][j];
+		}
+	}
+
+	m_classic = false;
+	_compile();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuLayout::add_diagonals(void)
+{
+	unsigned char diagonal[E_SUDOKU_DIM];
+	unsigned char anti_diagonal[E_SUDOKU_DIM];
+
+	for (int i = 0; i < E_SUDOKU_DIM; i++)
+	{
+		diagonal[i] = i * E_SUDOKU_DIM + i;
+		anti_diagonal[i] = i * E_SUDOKU_DIM + E_SUDOKU_DIM - 1 - i;
+	}
+
+	return add_unit(diagonal) && add_unit(anti_diagonal);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuLayout::add_windows(void)
+{
+	static const int corners[] = {1, 5};
+
+	for (int row : corners)
+	{
+		for (int column : corners)
+		{
+			unsigned char window[E_SUDOKU_DIM];
+			for (int i = 0; i < E_SUDOKU_DIM; i++)
+			{
+				window[i] = (row + i / E_SUDOKU_SQUARE_DIM) * E_SUDOKU_DIM +
+							column + i % E_SUDOKU_SQUARE_DIM;
+			}
+			if (!add_unit(window)) return false;
+		}
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuLayout::add_unit(const unsigned char *boxes)
+{
+	bool used[E_SUDOKU_BOX_COUNT] = {false};
+
+	if (m_unit_count == E_SUDOKU_LAYOUT_MAX_UNITS) return false;
+
+	for (int i = 0; i < E_SUDOKU_DIM; i++)
+	{
+		if (boxes[i] >= E_SUDOKU_BOX_COUNT || used[boxes[i]]) return false;
+		used[boxes[i]] = true;
+		m_units[m_unit_count][i] = boxes[i];
+	}
+
+	m_order[m_unit_count] = m_unit_count;
+	m_unit_count++;
+	m_classic = false;
+	_compile();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuLayout::add_cage(const std::vector<int> &boxes, int sum)
+{
+	SSudokuCage cage;
+
+	if (boxes.empty() || boxes.size() > E_SUDOKU_DIM || sum < 1 ||
+		sum > E_SUDOKU_LAYOUT_MAX_SUM)
+	{
+		return false;
+	}
+
+	cage.size = boxes.size();
+	cage.sum = sum;
+	for (unsigned int i = 0; i < boxes.size(); i++)
+	{
+		if (boxes[i] < 0 || boxes[i] >= E_SUDOKU_BOX_COUNT ||
+			m_box_cage[boxes[i]] >= 0)
+		{
+			// Boxes of this cage which were already marked
+			for (unsigned int j = 0; j < i; j++) m_box_cage[boxes[j]] = -1;
+			return false;
+		}
+		m_box_cage[boxes[i]] = m_cages.size();
+		cage.boxes[i] = boxes[i];
+	}
+
+	m_cages.push_back(cage);
+	m_classic = false;
+	_compile();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuLayout::load(std::istream &input)
+{
+	std::string line;
+	unsigned int line_number = 0;
+
+	while (std::getline(input, line))
+	{
+		std::istringstream fields(line);
+		std::string variant;
+		bool ok = true;
+
+		line_number++;
+		if (!(fields >> variant) || variant[0] == '#') continue;
+
+		if (variant == "diagonals")
+		{
+			ok = add_diagonals();
+		}
+		else if (variant == "windows")
+		{
+			ok = add_windows();
+		}
+		else if (variant == "regions")
+		{
+			std::string regions;
+			ok = (fields >> regions) && regions.size() == E_SUDOKU_BOX_COUNT &&
+				set_regions(regions.c_str());
+		}
+		else if (variant == "cage")
+		{
+			std::vector<int> boxes;
+			int sum = 0;
+			int box = 0;
+
+			ok = (bool)(fields >> sum);
+			while (ok && fields >> box) boxes.push_back(box);
+			ok = ok && fields.eof() && add_cage(boxes, sum);
+		}
+		else
+		{
+			ok = false;
+		}
+
+		if (!ok)
+		{
+			std::cerr << " Error in sudoku layout, line " << line_number << ": "
+					<< line << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuLayout::load_by_name(const std::string &name)
+{
+	*this = CSudokuLayout();
+
+	if (name == "classic") return true;
+	if (name == "x") return add_diagonals();
+	if (name == "windoku") return add_windows();
+
+	std::ifstream file(name.c_str());
+	if (!file.is_open())
+	{
+		std::cerr << " Error opening sudoku layout: " << name << std::endl;
+		return false;
+	}
+	return load(file);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const std::vector<uint16_t> &CSudokuLayout::get_combinations(int count, int sum)
+{
+	typedef std::vector<uint16_t> combinations_t[E_SUDOKU_DIM + 1][E_SUDOKU_LAYOUT_MAX_SUM + 1];
+	static const std::vector<uint16_t> none;
+
+	// Built once, every subset of values by its size and sum
+	static const struct STable
+	{
+		combinations_t combinations;
+
+		STable()
+		{
+			for (uint16_t values = 1; values < (1 << E_SUDOKU_DIM); values++)
+			{
+				int values_sum = 0;
+				for (int v = 1; v <= E_SUDOKU_DIM; v++)
+				{
+					if (values & (1 << (v - 1))) values_sum += v;
+				}
+				combinations[__builtin_popcount(values)][values_sum].push_back(values << 1);
+			}
+		}
+	} table;
+
+	if (count < 1 || count > E_SUDOKU_DIM || sum < 1 || sum > E_SUDOKU_LAYOUT_MAX_SUM)
+	{
+		return none;
+	}
+	return table.combinations[count][sum];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const CSudokuLayout &CSudokuLayout::get_default(void)
+{
+	static const CSudokuLayout classic;
+
+	return m_default ? *m_default : classic;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuLayout::set_default(const CSudokuLayout *layout)
+{
+	m_default = layout;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuLayout::_compile(void)
+{
+	bool peers[E_SUDOKU_BOX_COUNT][E_SUDOKU_BOX_COUNT] = {{false}};
+
+	for (unsigned int unit = 0; unit < m_unit_count; unit++)
+	{
+		for (int i = 0; i < E_SUDOKU_DIM; i++)
+		{
+			for (int j = 0; j < E_SUDOKU_DIM; j++)
+			{
+				peers[m_units[unit][i]][m_units[unit][j]] = true;
+			}
+		}
+	}
+
+	for (const auto &cage : m_cages)
+	{
+		for (int i = 0; i < cage.size; i++)
+		{
+			for (int j = 0; j < cage.size; j++) peers[cage.boxes[i]][cage.boxes[j]] = true;
+		}
+	}
+
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		m_peer_count[box] = 0;
+		for (int other = 0; other < E_SUDOKU_BOX_COUNT; other++)
+		{
+			if (peers[box][other] && other != box) m_peers[box][m_peer_count[box]++] = other;
+		}
+	}
+}
+
+} // namespace sudoku
@@ -0,0 +1,410 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_metrics.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file sudoku_metrics.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#include "sudoku_metrics.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <sys/resource.h>
+
+namespace sudoku{
+
+static const char *outcome_names[E_SUDOKU_METRICS_OUTCOME_COUNT] =
+{
+	"lockstep", "searched", "unsolvable", "timed_out", "invalid"
+};
+
+static const char *memory_names[E_SUDOKU_METRICS_MEMORY_COUNT] =
+{
+	"peak_bytes", "tree_bytes", "tree_width", "visited_bytes", "children_bytes"
+};
+
+std::atomic<bool> CSudokuMetrics::m_dump_requested(false);
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuMetrics::SThreadMetrics::SThreadMetrics(): latency_sum(0), latency_max(0),
+	expanded_nodes(0)
+{
+	for (auto &bucket : latency) bucket.store(0, std::memory_order_relaxed);
+	for (auto &outcome : outcomes) outcome.store(0, std::memory_order_relaxed);
+	for (auto &strategy_wins : wins) strategy_wins.store(0, std::memory_order_relaxed);
+	for (auto &peak : memory) peak.store(0, std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuMetrics::CSudokuMetrics(): m_period(0), m_stop(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuMetrics::~CSudokuMetrics()
+{
+	stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuMetrics::SThreadMetrics *CSudokuMetrics::register_thread(void)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_slots.push_back(std::unique_ptr<SThreadMetrics>(new SThreadMetrics()));
+	return m_slots.back().get();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuMetrics::set_queue_depth(std::function<long(void)> queue_depth)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_queue_depth = queue_depth;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuMetrics::start(const std::string &path, unsigned int period)
+{
+	if (m_reporter.joinable()) return;
+
+	m_path = path;
+	m_period = (period > 0) ? period : 1;
+	m_stop = false;
+	m_reporter = std::thread(&CSudokuMetrics::_reporter, this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuMetrics::stop(void)
+{
+	if (!m_reporter.joinable()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_stop_cond.notify_all();
+	m_reporter.join();
+
+	_sample();
+	if (!m_path.empty()) _write_file();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuMetrics::request_dump(void)
+{
+	m_dump_requested.store(true, std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t CSudokuMetrics::get_bucket_limit(unsigned int bucket)
+{
+	if (bucket < E_SUDOKU_METRICS_SUB_BUCKETS) return bucket;
+
+	unsigned int shift = bucket / E_SUDOKU_METRICS_SUB_BUCKETS - 1;
+	uint64_t sub = bucket % E_SUDOKU_METRICS_SUB_BUCKETS;
+
+	return ((E_SUDOKU_METRICS_SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+long CSudokuMetrics::get_peak_rss(void)
+{
+	struct rusage usage;
+
+	// ru_maxrss is in KB in Linux
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+	return usage.ru_maxrss;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuMetrics::write_memory(std::ostream &output)
+{
+	STotals totals;
+	_get_totals(&totals);
+
+	output << " Memory by board search (max): peak "
+			<< totals.memory[E_SUDOKU_METRICS_MEMORY_PEAK] << " bytes, tree "
+			<< totals.memory[E_SUDOKU_METRICS_MEMORY_TREE] << " bytes ("
+			<< totals.memory[E_SUDOKU_METRICS_MEMORY_WIDTH] << " nodes wide), visited store "
+			<< totals.memory[E_SUDOKU_METRICS_MEMORY_VISITED] << " bytes, children "
+			<< totals.memory[E_SUDOKU_METRICS_MEMORY_CHILDREN] << " bytes" << std::endl;
+	output << " Peak RSS: " << get_peak_rss() << " KB" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuMetrics::write_text(std::ostream &output)
+{
+	STotals totals;
+	_get_totals(&totals);
+
+	output << " Sudoku metrics" << std::endl;
+	output << " Boards: " << totals.boards << " (";
+	for (int i = 0; i < E_SUDOKU_METRICS_OUTCOME_COUNT; i++)
+	{
+		output << (i ? ", " : "") << outcome_names[i] << " " << totals.outcomes[i];
+	}
+	output << ")" << std::endl;
+
+	output << " Latency (us): mean "
+			<< (totals.boards ? totals.latency_sum / 1000.0 / totals.boards : 0.0)
+			<< ", p50 " << _get_percentile(totals, 0.5)
+			<< ", p90 " << _get_percentile(totals, 0.9)
+			<< ", p99 " << _get_percentile(totals, 0.99)
+			<< ", p99.9 " << _get_percentile(totals, 0.999)
+			<< ", max " << totals.latency_max / 1000.0 << std::endl;
+
+	output << " Throughput (boards/s): 1s " << _get_throughput(1)
+			<< ", 10s " << _get_throughput(10)
+			<< ", 60s " << _get_throughput(60) << std::endl;
+
+	output << " Queue depth: " << _get_queue_depth() << std::endl;
+
+	output << " Expanded nodes: " << totals.expanded_nodes << " ("
+			<< (totals.boards ? (double)totals.expanded_nodes / totals.boards : 0.0)
+			<< " by board)" << std::endl;
+
+	uint64_t wins = 0;
+	for (auto strategy_wins : totals.wins) wins += strategy_wins;
+	if (wins > 0)
+	{
+		output << " Portfolio wins:";
+		for (int i = 0; i < E_SUDOKU_STRATEGY_COUNT; i++)
+		{
+			output << (i ? ", " : " ") << get_strategy_name((E_SUDOKU_STRATEGY)i)
+					<< " " << totals.wins[i];
+		}
+		output << std::endl;
+	}
+
+	write_memory(output);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuMetrics::write_json(std::ostream &output)
+{
+	STotals totals;
+	_get_totals(&totals);
+
+	output << "{\"boards\":" << totals.boards << ",\"outcomes\":{";
+	for (int i = 0; i < E_SUDOKU_METRICS_OUTCOME_COUNT; i++)
+	{
+		output << (i ? "," : "") << "\"" << outcome_names[i] << "\":"
+				<< totals.outcomes[i];
+	}
+
+	output << "},\"latency_us\":{\"mean\":"
+			<< (totals.boards ? totals.latency_sum / 1000.0 / totals.boards : 0.0)
+			<< ",\"p50\":" << _get_percentile(totals, 0.5)
+			<< ",\"p90\":" << _get_percentile(totals, 0.9)
+			<< ",\"p99\":" << _get_percentile(totals, 0.99)
+			<< ",\"p999\":" << _get_percentile(totals, 0.999)
+			<< ",\"max\":" << totals.latency_max / 1000.0 << "}";
+
+	// Only buckets with boards: [highest latency in ns, count]
+	output << ",\"histogram_ns\":[";
+	bool first = true;
+	for (unsigned int i = 0; i < E_SUDOKU_METRICS_BUCKETS; i++)
+	{
+		if (totals.latency[i] == 0) continue;
+		output << (first ? "" : ",") << "[" << get_bucket_limit(i) << ","
+				<< totals.latency[i] << "]";
+		first = false;
+	}
+
+	output << "],\"throughput\":{\"1s\":" << _get_throughput(1)
+			<< ",\"10s\":" << _get_throughput(10)
+			<< ",\"60s\":" << _get_throughput(60) << "}"
+			<< ",\"queue_depth\":" << _get_queue_depth()
+			<< ",\"expanded_nodes\":" << totals.expanded_nodes;
+
+	output << ",\"portfolio_wins\":{";
+	for (int i = 0; i < E_SUDOKU_STRATEGY_COUNT; i++)
+	{
+		output << (i ? "," : "") << "\"" << get_strategy_name((E_SUDOKU_STRATEGY)i)
+				<< "\":" << totals.wins[i];
+	}
+
+	output << "},\"memory\":{";
+	for (int i = 0; i < E_SUDOKU_METRICS_MEMORY_COUNT; i++)
+	{
+		output << "\"" << memory_names[i] << "\":" << totals.memory[i] << ",";
+	}
+	output << "\"peak_rss_kb\":" << get_peak_rss() << "}}" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuMetrics::_get_totals(STotals *totals)
+{
+	*totals = STotals();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const auto &slot : m_slots)
+	{
+		for (unsigned int i = 0; i < E_SUDOKU_METRICS_BUCKETS; i++)
+		{
+			totals->latency[i] += slot->latency[i].load(std::memory_order_relaxed);
+		}
+		for (unsigned int i = 0; i < E_SUDOKU_METRICS_OUTCOME_COUNT; i++)
+		{
+			uint64_t count = slot->outcomes[i].load(std::memory_order_relaxed);
+			totals->outcomes[i] += count;
+			totals->boards += count;
+		}
+		totals->latency_sum += slot->latency_sum.load(std::memory_order_relaxed);
+		totals->expanded_nodes += slot->expanded_nodes.load(std::memory_order_relaxed);
+		for (unsigned int i = 0; i < E_SUDOKU_STRATEGY_COUNT; i++)
+		{
+			totals->wins[i] += slot->wins[i].load(std::memory_order_relaxed);
+		}
+		for (unsigned int i = 0; i < E_SUDOKU_METRICS_MEMORY_COUNT; i++)
+		{
+			uint64_t peak = slot->memory[i].load(std::memory_order_relaxed);
+			if (peak > totals->memory[i]) totals->memory[i] = peak;
+		}
+
+		uint64_t max = slot->latency_max.load(std::memory_order_relaxed);
+		if (max > totals->latency_max) totals->latency_max = max;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double CSudokuMetrics::_get_percentile(const STotals &totals, double fraction)
+{
+	uint64_t target = (uint64_t)(fraction * totals.boards + 0.5);
+	uint64_t count = 0;
+
+	if (target == 0) target = 1;
+	for (unsigned int i = 0; i < E_SUDOKU_METRICS_BUCKETS; i++)
+	{
+		count += totals.latency[i];
+		if (count >= target)
+		{
+			uint64_t limit = get_bucket_limit(i);
+			if (limit > totals.latency_max) limit = totals.latency_max;
+			return limit / 1000.0;
+		}
+	}
+
+	return 0.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+double CSudokuMetrics::_get_throughput(unsigned int seconds)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_samples.size() < 2) return 0.0;
+
+	const SSample &last = m_samples.back();
+	auto it = m_samples.rbegin() + 1;
+	while (it + 1 != m_samples.rend() &&
+		last.time - it->time < std::chrono::seconds(seconds))
+	{
+		++it;
+	}
+
+	double elapsed = std::chrono::duration<double>(last.time - it->time).count();
+	return (elapsed > 0) ? (last.boards - it->boards) / elapsed : 0.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+long CSudokuMetrics::_get_queue_depth(void)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_queue_depth ? m_queue_depth() : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuMetrics::_sample(void)
+{
+	SSample sample;
+	sample.boards = 0;
+	sample.time = std::chrono::steady_clock::now();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const auto &slot : m_slots)
+	{
+		for (const auto &outcome : slot->outcomes)
+		{
+			sample.boards += outcome.load(std::memory_order_relaxed);
+		}
+	}
+
+	m_samples.push_back(sample);
+	if (m_samples.size() > E_SUDOKU_METRICS_SAMPLES) m_samples.pop_front();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuMetrics::_write_file(void)
+{
+	std::string temporal = m_path + ".tmp";
+	std::ofstream file(temporal.c_str());
+
+	if (!file.is_open())
+	{
+		std::cerr << " Error writing metrics file: " << temporal << std::endl;
+		return;
+	}
+
+	write_json(file);
+	file.close();
+
+	if (file.fail() || rename(temporal.c_str(), m_path.c_str()) != 0)
+	{
+		std::cerr << " Error writing metrics file: " << m_path << std::endl;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuMetrics::_reporter(void)
+{
+	auto next_sample = std::chrono::steady_clock::now();
+	auto next_write = next_sample + std::chrono::seconds(m_period);
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (!m_stop)
+	{
+		// Signals are checked 10 times by second
+		m_stop_cond.wait_for(lock, std::chrono::milliseconds(100));
+		if (m_stop) break;
+		lock.unlock();
+
+		auto now = std::chrono::steady_clock::now();
+		if (now >= next_sample)
+		{
+			_sample();
+			next_sample += std::chrono::seconds(1);
+		}
+
+		if (m_dump_requested.exchange(false, std::memory_order_relaxed))
+		{
+			write_text(std::cerr);
+		}
+
+		if (!m_path.empty() && now >= next_write)
+		{
+			_write_file();
+			next_write = now + std::chrono::seconds(m_period);
+		}
+
+		lock.lock();
+	}
+}
+
+} // namespace sudoku
@@ -0,0 +1,385 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_pipeline.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_pipeline.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#include "sudoku_pipeline.hpp"
+
+#include <map>
+#include <fstream>
+
+namespace sudoku{
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuPipeline::CSudokuPipeline(unsigned int solver_count,
+								const SSudokuWorkerOptions &options,
+								size_t queue_capacity):
+	m_solver_count(solver_count), m_options(options), m_window(queue_capacity * 2),
+	m_input_queue(queue_capacity), m_output_queue(queue_capacity),
+	m_read_count(0), m_written_count(0), m_input_error(false), m_metrics(nullptr),
+	m_input_end(-1), m_journal(nullptr), m_first_number(0)
+{
+	if (m_solver_count == 0)
+	{
+		m_solver_count = std::thread::hardware_concurrency();
+		if (m_solver_count == 0) m_solver_count = 1;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+long CSudokuPipeline::run(std::istream &input, std::ostream &output)
+{
+	std::vector<std::thread> solvers;
+
+	m_read_count = 0;
+	m_written_count = 0;
+	m_input_error = false;
+	m_first_number = 0;
+
+	// Boards already solved in journal are written again, and input goes on
+	// after them
+	if (m_journal)
+	{
+		int status;
+		CSudokuBoard board;
+
+		m_first_number = m_journal->get_resume_count();
+		for (long i = 0; i < m_first_number; i++)
+		{
+			m_journal->get_result(i, &status, &board);
+			_write_result(output, i, status, board);
+		}
+		m_journal->release();
+
+		if (m_first_number > 0)
+		{
+			input.clear();
+			input.seekg(m_journal->get_resume_offset());
+		}
+	}
+
+	// Boards read and not written yet
+	if (m_metrics)
+	{
+		m_metrics->set_queue_depth([this]{ return m_read_count - m_written_count; });
+	}
+
+	std::thread reader(&CSudokuPipeline::_reader, this, std::ref(input));
+	for (unsigned int i = 0; i < m_solver_count; i++)
+	{
+		solvers.push_back(std::thread(&CSudokuPipeline::_solver, this));
+	}
+
+	_writer(output);
+
+	reader.join();
+	for (auto &solver : solvers) solver.join();
+
+	if (m_metrics) m_metrics->set_queue_depth(nullptr);
+
+	return m_input_error ? -1 : m_first_number + m_read_count.load();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuPipeline::_reader(std::istream &input)
+{
+	SBatchItem item;
+	item.status = CSudokuWorker::E_SUDOKU_WORKER_SOLVED;
+	item.winner = -1;
+
+	while (true)
+	{
+		CSudokuBoard board;
+
+		input >> std::ws;
+		if (input.eof()) break;
+		if (m_input_end >= 0 && input.tellg() >= m_input_end) break;
+
+		input >> board;
+		if (input.fail())
+		{
+			std::cerr << " Error getting sudoku board " << m_first_number + m_read_count
+						<< " from input" << std::endl;
+			m_input_error = true;
+			break;
+		}
+
+		if (m_input_filter && !m_input_filter(board)) continue;
+
+		// Writer can't keep more than window boards to reorder them
+		for (unsigned int tries = 0;
+			m_read_count - m_written_count >= (long)m_window; tries++)
+		{
+			if (tries < 128) std::this_thread::yield();
+			else std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+
+		item.sequence = m_read_count++;
+		item.input_offset = input.tellg();
+		item.board = board;
+		m_input_queue.push(item);
+	}
+
+	// One end mark for each solver
+	item.sequence = -1;
+	for (unsigned int i = 0; i < m_solver_count; i++) m_input_queue.push(item);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuPipeline::_solver(void)
+{
+	CSudokuWorker worker(m_options);
+	std::unique_ptr<CSudokuPortfolio> portfolio;
+	CSudokuLanes lanes;
+	CSudokuMetrics::SThreadMetrics *slot =
+							m_metrics ? m_metrics->register_thread() : nullptr;
+	std::vector<SBatchItem> group;
+	// Lockstep propagation only knows classic rules
+	unsigned int group_size = (m_options.lockstep &&
+		CSudokuLayout::get_default().is_classic()) ? E_SUDOKU_LANES_COUNT : 1;
+	SBatchItem item;
+	bool finished = false;
+
+	if (!m_options.portfolio.empty()) portfolio.reset(new CSudokuPortfolio(m_options));
+
+	group.reserve(group_size);
+	while (!finished)
+	{
+		// Wait for one board, and take the ones which are already queued
+		group.clear();
+		m_input_queue.pop(item);
+		while (true)
+		{
+			if (item.sequence < 0)
+			{
+				finished = true;
+				break;
+			}
+
+			group.push_back(item);
+			if (group.size() == group_size || !m_input_queue.try_pop(item)) break;
+		}
+
+		if (group.size() > 1)
+		{
+			_solve_group(group, worker, portfolio.get(), lanes, slot);
+		}
+		else if (group.size() == 1)
+		{
+			_solve_item(group[0], worker, portfolio.get(), slot);
+		}
+
+		for (const auto &solved : group) m_output_queue.push(solved);
+	}
+
+	m_output_queue.push(item);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuPipeline::_solve_group(std::vector<SBatchItem> &group,
+								CSudokuWorker &worker, CSudokuPortfolio *portfolio,
+								CSudokuLanes &lanes, CSudokuMetrics::SThreadMetrics *slot)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	lanes.clear();
+	for (const auto &item : group) lanes.add(item.board);
+
+	lanes.propagate();
+
+	// Every board waits for the whole propagation
+	std::chrono::nanoseconds shared_latency = std::chrono::steady_clock::now() - start;
+
+	for (unsigned int lane = 0; lane < group.size(); lane++)
+	{
+		if (lanes.is_solved(lane) && lanes.get_board(lane, &group[lane].board))
+		{
+			group[lane].status = CSudokuWorker::E_SUDOKU_WORKER_SOLVED;
+			group[lane].statistics = SSearchStatistics();
+			if (slot)
+			{
+				CSudokuMetrics::record(slot, shared_latency, E_SUDOKU_METRICS_LOCKSTEP);
+			}
+		}
+		else
+		{
+			// It needs a search, it starts again from the original board
+			_solve_item(group[lane], worker, portfolio, slot, shared_latency);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuPipeline::_solve_item(SBatchItem &item, CSudokuWorker &worker,
+								CSudokuPortfolio *portfolio,
+								CSudokuMetrics::SThreadMetrics *slot,
+								std::chrono::nanoseconds shared_latency)
+{
+	CSudokuBoard solution;
+	long number = m_first_number + item.sequence;
+	auto start = std::chrono::steady_clock::now();
+
+	if (portfolio)
+	{
+		item.status = portfolio->solve(item.board, solution);
+		item.statistics = portfolio->get_statistics();
+	}
+	else
+	{
+		bool traced = m_options.trace_sample > 0 && number % m_options.trace_sample == 0;
+
+		worker.set_tracing(traced);
+		item.status = worker.get_result(worker.solve(item.board, solution));
+		item.statistics = worker.get_statistics();
+		if (traced) _write_trace(number, *worker.get_trace());
+	}
+
+	// Solved or partial board
+	if (item.status != CSudokuWorker::E_SUDOKU_WORKER_UNSOLVABLE) item.board = solution;
+
+	item.winner = -1;
+	if (portfolio && item.status == CSudokuWorker::E_SUDOKU_WORKER_SOLVED)
+	{
+		item.winner = portfolio->get_winner();
+		if (slot) CSudokuMetrics::record_win(slot, portfolio->get_winner());
+	}
+
+	if (slot)
+	{
+		CSudokuMetrics::record(slot,
+							shared_latency + (std::chrono::steady_clock::now() - start),
+							get_outcome_by_result(item.status));
+		CSudokuMetrics::record_search(slot, item.statistics);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuPipeline::_write_trace(long number, const CSearchTrace &trace) const
+{
+	std::string file_name = m_options.trace_prefix + "." + std::to_string(number) +
+							".trace";
+	std::ofstream file(file_name, std::ios::binary);
+
+	if (!file.is_open() || !trace.write(file))
+	{
+		std::cerr << " Error writing search trace: " << file_name << std::endl;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuPipeline::_writer(std::ostream &output)
+{
+	std::map<long, SBatchItem> reorder;
+	unsigned int finished_solvers = 0;
+	long next_sequence = 0;
+	SBatchItem item;
+	CSudokuJournal *journal = m_journal;
+
+	while (finished_solvers < m_solver_count || !reorder.empty())
+	{
+		if (finished_solvers < m_solver_count)
+		{
+			// Written boards must be durable in journal interval, though no
+			// more boards are written for a long time
+			while (journal && !m_output_queue.try_pop(item))
+			{
+				if (!journal->sync_if_due()) journal = nullptr;
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+			if (!journal) m_output_queue.pop(item);
+			if (item.sequence < 0)
+			{
+				finished_solvers++;
+				continue;
+			}
+			reorder[item.sequence] = item;
+		}
+
+		auto it = reorder.find(next_sequence);
+		while (it != reorder.end())
+		{
+			long number = m_first_number + next_sequence;
+
+			_write_result(output, number, it->second.status, it->second.board);
+			if (journal &&
+				!journal->append(it->second.status, it->second.board,
+								it->second.input_offset))
+			{
+				// Output is still right, only resume is lost
+				journal = nullptr;
+			}
+
+			if (it->second.winner >= 0)
+			{
+				std::cerr << " Sudoku board " << number << " solved first by "
+						<< get_strategy_name((E_SUDOKU_STRATEGY)it->second.winner)
+						<< std::endl;
+			}
+
+			if (it->second.statistics.is_degraded())
+			{
+				std::cerr << " Sudoku board " << number
+						<< " reached memory budget: "
+						<< it->second.statistics.visited_dropped
+						<< " visited nodes dropped, "
+						<< it->second.statistics.bounded_expansions
+						<< " bounded expansions" << std::endl;
+			}
+
+			reorder.erase(it);
+			m_written_count = ++next_sequence;
+			it = reorder.find(next_sequence);
+		}
+
+		if (finished_solvers == m_solver_count && !reorder.empty() &&
+			reorder.begin()->first != next_sequence)
+		{
+			// It can't happen, every board read is solved
+			break;
+		}
+	}
+
+	output.flush();
+	if (journal) journal->sync();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuPipeline::_write_result(std::ostream &output, long number, int status,
+									const CSudokuBoard &board)
+{
+	if (status == CSudokuWorker::E_SUDOKU_WORKER_SOLVED)
+	{
+		output << board << std::endl;
+	}
+	else if (status == CSudokuWorker::E_SUDOKU_WORKER_TIMED_OUT)
+	{
+		output << " Sudoku board " << number
+				<< " timed out or gave up, partial board:" << std::endl
+				<< board << std::endl;
+	}
+	else
+	{
+		output << " Sudoku board " << number
+				<< " hasn't got solution" << std::endl << std::endl;
+	}
+}
+
+} // namespace sudoku
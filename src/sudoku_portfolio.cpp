@@ -0,0 +1,181 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_portfolio.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file sudoku_portfolio.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#include "sudoku_portfolio.hpp"
+
+namespace sudoku{
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuPortfolio::CSudokuPortfolio(const SSudokuWorkerOptions &options):
+	m_puzzle(nullptr), m_race(0), m_running(0), m_winner(-1), m_stop(false)
+{
+	std::vector<E_SUDOKU_STRATEGY> strategies = options.portfolio;
+	if (strategies.empty()) strategies.push_back(options.strategy);
+
+	for (auto strategy : strategies)
+	{
+		SSudokuWorkerOptions racer_options = options;
+		racer_options.strategy = strategy;
+		racer_options.portfolio.clear();
+
+		m_racers.push_back(std::unique_ptr<SRacer>(new SRacer(strategy, racer_options)));
+		m_racers.back()->worker.set_cancel_token(&m_cancel);
+	}
+
+	for (auto &wins : m_wins) wins = 0;
+
+	// First racer runs in the calling thread
+	for (unsigned int i = 1; i < m_racers.size(); i++)
+	{
+		m_racers[i]->thread = std::thread(&CSudokuPortfolio::_racer_loop, this, i);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuPortfolio::~CSudokuPortfolio()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_start_cond.notify_all();
+
+	for (auto &racer : m_racers)
+	{
+		if (racer->thread.joinable()) racer->thread.join();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int CSudokuPortfolio::solve(const CSudokuBoard &puzzle, CSudokuBoard &solution,
+							const CCancelToken *cancel)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_cancel.reset();
+		m_cancel.set_parent(cancel);
+		m_puzzle = &puzzle;
+		m_running = m_racers.size();
+		m_winner = -1;
+		m_race++;
+	}
+	m_start_cond.notify_all();
+
+	_race(0);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done_cond.wait(lock, [this]{ return m_running == 0; });
+	m_cancel.set_parent(nullptr);
+
+	if (m_winner >= 0)
+	{
+		const SRacer &winner = *m_racers[m_winner];
+		if (winner.result == CSudokuWorker::E_SUDOKU_WORKER_SOLVED)
+		{
+			m_wins[winner.strategy]++;
+			solution = winner.solution;
+		}
+		return winner.result;
+	}
+
+	// Every search stopped (deadline, external cancel) or gave up (beam),
+	// the deepest partial board is returned
+	int result = CSudokuWorker::E_SUDOKU_WORKER_UNSOLVABLE;
+	for (const auto &racer : m_racers)
+	{
+		if (racer->result != CSudokuWorker::E_SUDOKU_WORKER_TIMED_OUT) continue;
+
+		if (result != CSudokuWorker::E_SUDOKU_WORKER_TIMED_OUT ||
+			racer->solution.get_occupiedBoxCount() > solution.get_occupiedBoxCount())
+		{
+			solution = racer->solution;
+		}
+		result = CSudokuWorker::E_SUDOKU_WORKER_TIMED_OUT;
+	}
+
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int CSudokuPortfolio::solve(const char *puzzle, char *solution, const CCancelToken *cancel)
+{
+	CSudokuBoard board;
+	CSudokuBoard solved_board;
+
+	if (!board.load_from_buffer(puzzle))
+	{
+		memset(solution, '0', E_SUDOKU_BOX_COUNT);
+		return CSudokuWorker::E_SUDOKU_WORKER_INVALID;
+	}
+
+	int result = this->solve(board, solved_board, cancel);
+	if (result == CSudokuWorker::E_SUDOKU_WORKER_UNSOLVABLE)
+	{
+		memset(solution, '0', E_SUDOKU_BOX_COUNT);
+		return result;
+	}
+
+	// Solved or partial board
+	solved_board.save_to_buffer(solution);
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuPortfolio::_race(unsigned int racer)
+{
+	SRacer &current = *m_racers[racer];
+
+	current.result = current.worker.get_result(
+							current.worker.solve(*m_puzzle, current.solution));
+
+	// A solution, or a complete search which proved there isn't any (searches
+	// which give up or stop are timed out), ends the race
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if ((current.result == CSudokuWorker::E_SUDOKU_WORKER_SOLVED ||
+		current.result == CSudokuWorker::E_SUDOKU_WORKER_UNSOLVABLE) && m_winner < 0)
+	{
+		m_winner = racer;
+		m_cancel.cancel();
+	}
+
+	if (--m_running == 0) m_done_cond.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuPortfolio::_racer_loop(unsigned int racer)
+{
+	unsigned long race = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_start_cond.wait(lock, [this, race]{ return m_stop || m_race != race; });
+			if (m_stop) return;
+			race = m_race;
+		}
+
+		_race(racer);
+	}
+}
+
+} // namespace sudoku
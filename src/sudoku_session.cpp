@@ -0,0 +1,111 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_session.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_session.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#include "sudoku_session.hpp"
+
+namespace sudoku{
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuSession::CSudokuSession(const SSudokuWorkerOptions &options):
+	m_worker(options), m_result(CSudokuWorker::E_SUDOKU_WORKER_TIMED_OUT), m_searches(0),
+	m_keep_visited(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int CSudokuSession::load(const CSudokuBoard &puzzle)
+{
+	m_puzzle = puzzle;
+	m_keep_visited = false;
+	m_result = _solve();
+	return m_result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int CSudokuSession::load(const char *puzzle)
+{
+	CSudokuBoard board;
+
+	if (!board.load_from_buffer(puzzle)) return CSudokuWorker::E_SUDOKU_WORKER_INVALID;
+	return load(board);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int CSudokuSession::set_value(short int valor, short int posX, short int posY)
+{
+	if (valor < 0 || valor > E_SUDOKU_DIM || posX < 0 || posX >= E_SUDOKU_DIM ||
+		posY < 0 || posY >= E_SUDOKU_DIM)
+	{
+		return CSudokuWorker::E_SUDOKU_WORKER_INVALID;
+	}
+
+	short int valor_antiguo = m_puzzle.getValorByXY(posX, posY);
+	if (valor == valor_antiguo) return m_result;
+
+	if (!m_puzzle.setValorByXY(valor, posX, posY))
+	{
+		return CSudokuWorker::E_SUDOKU_WORKER_INVALID;
+	}
+
+	//--------------------------------------------------------------------------
+	// New value: last solution is still valid if it has the same value. In
+	// other case, nogoods of last search are still valid (an unsolvable board
+	// has an empty nogood, so it fails at once)
+	if (valor_antiguo == 0)
+	{
+		if (m_result == CSudokuWorker::E_SUDOKU_WORKER_SOLVED &&
+			m_solution.getValorByXY(posX, posY) == valor)
+		{
+			return m_result;
+		}
+
+		m_result = _solve();
+		return m_result;
+	}
+
+	// Nogoods of last search could need the old value
+	m_keep_visited = false;
+
+	//--------------------------------------------------------------------------
+	// Removed value: last solution is still valid
+	if (valor == 0 && m_result == CSudokuWorker::E_SUDOKU_WORKER_SOLVED)
+	{
+		return m_result;
+	}
+
+	// Changed value, or removed value of an unsolvable board
+	m_result = _solve();
+	return m_result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int CSudokuSession::_solve(void)
+{
+	bool solved = m_worker.solve(m_puzzle, m_solution, m_keep_visited);
+
+	m_searches++;
+	m_keep_visited = true;
+	return m_worker.get_result(solved);
+}
+
+} // namespace sudoku
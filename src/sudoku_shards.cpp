@@ -0,0 +1,410 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_shards.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_shards.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#include "sudoku_shards.hpp"
+
+#include <fstream>
+#include <memory>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace sudoku{
+
+// Lines after the first one in the output of a board (see
+// CSudokuPipeline::_writer): solved board, timed out partial board and
+// board without solution. Every output ends with an empty line
+static const unsigned int SOLVED_OUTPUT_LINES = E_SUDOKU_DIM + 2 + 1;
+static const unsigned int TIMED_OUT_OUTPUT_LINES = 1 + E_SUDOKU_DIM + 2 + 1;
+static const unsigned int UNSOLVABLE_OUTPUT_LINES = 1;
+
+static const char *const UNSOLVED_OUTPUT = " Sudoku board ";
+
+// Lines of a board in a batch file, and rows before each separator
+static const int BOARD_LINES = E_SUDOKU_DIM + 2;
+static const int FIRST_SEPARATOR_LINE = E_SUDOKU_SQUARE_DIM;
+static const int SECOND_SEPARATOR_LINE = 2 * E_SUDOKU_SQUARE_DIM + 1;
+
+////////////////////////////////////////////////////////////////////////////////
+bool get_sharding_by_name(const std::string &name, E_SUDOKU_SHARDING *sharding)
+{
+	if (name == "range")
+	{
+		*sharding = E_SUDOKU_SHARDING_RANGE;
+		return true;
+	}
+	if (name == "hash")
+	{
+		*sharding = E_SUDOKU_SHARDING_HASH;
+		return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuShards::CSudokuShards(const std::string &batch_file_name, unsigned int count,
+							E_SUDOKU_SHARDING sharding):
+	m_batch_file_name(batch_file_name), m_count(count > 0 ? count : 1),
+	m_sharding(sharding)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+long CSudokuShards::solve(unsigned int index, CSudokuPipeline &pipeline,
+						std::ostream &output)
+{
+	std::ifstream input(m_batch_file_name);
+	if (!input.is_open() || index >= m_count)
+	{
+		std::cerr << " Error opening shard " << index << " of batch file: "
+				<< m_batch_file_name << std::endl;
+		return -1;
+	}
+
+	if (m_sharding == E_SUDOKU_SHARDING_RANGE)
+	{
+		input.seekg(0, std::ios::end);
+		std::streamoff size = input.tellg();
+		std::streamoff begin = find_board_start(input, size * index / m_count, size);
+		std::streamoff end = find_board_start(input, size * (index + 1) / m_count, size);
+
+		input.clear();
+		input.seekg(begin);
+		pipeline.set_input_end(end);
+	}
+	else
+	{
+		unsigned int count = m_count;
+		pipeline.set_input_filter([index, count](const CSudokuBoard &board)
+			{ return get_board_shard(board, count) == index; });
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	long boards = pipeline.run(input, output);
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+										std::chrono::steady_clock::now() - start);
+
+	std::cerr << " Shard " << index << "/" << m_count << ": " << boards
+			<< " boards in " << elapsed.count() << " ms" << std::endl;
+	return boards;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuShards::merge(const std::string &prefix, std::ostream &output,
+						std::vector<long> *counts)
+{
+	std::vector< std::unique_ptr<std::ifstream> > shards;
+	std::vector<long> shard_counts(m_count, 0);
+	std::string first, rest;
+	long sequence = 0;
+
+	for (unsigned int i = 0; i < m_count; i++)
+	{
+		shards.push_back(std::unique_ptr<std::ifstream>(
+									new std::ifstream(get_file_name(prefix, i))));
+		if (!shards.back()->is_open())
+		{
+			std::cerr << " Error opening shard output: " << get_file_name(prefix, i)
+					<< std::endl;
+			return false;
+		}
+	}
+
+	// Output of every board, with its number in input
+	auto write = [&](unsigned int shard)
+	{
+		if (!_read_output(*shards[shard], &first, &rest)) return false;
+
+		if (first.compare(0, strlen(UNSOLVED_OUTPUT), UNSOLVED_OUTPUT) == 0)
+		{
+			size_t number_end = first.find(' ', strlen(UNSOLVED_OUTPUT));
+			first = UNSOLVED_OUTPUT + std::to_string(sequence) + first.substr(number_end);
+		}
+		output << first << std::endl << rest;
+		shard_counts[shard]++;
+		sequence++;
+		return true;
+	};
+
+	if (m_sharding == E_SUDOKU_SHARDING_RANGE)
+	{
+		// Shards are consecutive ranges
+		for (unsigned int i = 0; i < m_count; i++)
+		{
+			while (shards[i]->peek() != EOF)
+			{
+				if (!write(i))
+				{
+					std::cerr << " Error merging sudoku board " << sequence << std::endl;
+					return false;
+				}
+			}
+		}
+	}
+	else
+	{
+		// Shard of every board in input, in the same order
+		std::ifstream input(m_batch_file_name);
+		if (!input.is_open())
+		{
+			std::cerr << " Error opening batch file: " << m_batch_file_name << std::endl;
+			return false;
+		}
+
+		while (true)
+		{
+			CSudokuBoard board;
+
+			input >> std::ws;
+			if (input.eof()) break;
+
+			input >> board;
+			if (input.fail() || !write(get_board_shard(board, m_count)))
+			{
+				std::cerr << " Error merging sudoku board " << sequence << std::endl;
+				return false;
+			}
+		}
+	}
+
+	output.flush();
+	if (counts) *counts = shard_counts;
+
+	for (unsigned int i = 0; i < m_count; i++)
+	{
+		if (shards[i]->peek() != EOF)
+		{
+			std::cerr << " Error merging shard output: " << get_file_name(prefix, i)
+					<< std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int CSudokuShards::run(const std::string &prefix, unsigned int worker_count,
+					const SSudokuWorkerOptions &options, std::ostream &output)
+{
+	std::string files_prefix = prefix;
+	char temporary_dir[] = "/tmp/sudoku_shards.XXXXXX";
+	std::vector<pid_t> children(m_count, -1);
+	std::vector<std::chrono::steady_clock::time_point> ends(m_count);
+	bool failed = false;
+
+	if (files_prefix.empty())
+	{
+		if (mkdtemp(temporary_dir) == nullptr)
+		{
+			perror(" Error creating shards directory");
+			return -1;
+		}
+		files_prefix = std::string(temporary_dir) + "/shard";
+	}
+
+	// CPUs are divided between shards
+	if (worker_count == 0)
+	{
+		worker_count = std::thread::hardware_concurrency() / m_count;
+		if (worker_count == 0) worker_count = 1;
+	}
+
+	// Buffered output mustn't be written by children too
+	output.flush();
+	std::cout.flush();
+	std::cerr.flush();
+
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < m_count && !failed; i++)
+	{
+		children[i] = fork();
+		if (children[i] < 0)
+		{
+			perror(" Error creating shard process");
+			failed = true;
+		}
+		else if (children[i] == 0)
+		{
+			std::ofstream shard_output(get_file_name(files_prefix, i));
+			CSudokuPipeline pipeline(worker_count, options);
+
+			long boards = solve(i, pipeline, shard_output);
+			shard_output.close();
+			std::cerr.flush();
+			_exit((boards < 0 || shard_output.fail()) ? 1 : 0);
+		}
+	}
+
+	for (unsigned int running = 0; running < m_count; running++)
+	{
+		int status = 0;
+		pid_t child = wait(&status);
+		if (child < 0) break;
+
+		for (unsigned int i = 0; i < m_count; i++)
+		{
+			if (children[i] == child) ends[i] = std::chrono::steady_clock::now();
+		}
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed = true;
+	}
+
+	std::vector<long> counts;
+	if (!failed && !merge(files_prefix, output, &counts)) failed = true;
+
+	//--------------------------------------------------------------------------
+	// Time of every shard, the slowest one is the time of the whole run
+	if (!failed)
+	{
+		long slowest = 0, total = 0;
+		for (unsigned int i = 0; i < m_count; i++)
+		{
+			long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+														ends[i] - start).count();
+			std::cerr << " Shard " << i << ": " << counts[i] << " boards, "
+					<< elapsed << " ms" << std::endl;
+			if (elapsed > slowest) slowest = elapsed;
+			total += elapsed;
+		}
+
+		double mean = (double)total / m_count;
+		std::cerr << " Shards skew: slowest " << slowest << " ms, mean " << mean
+				<< " ms (" << (mean > 0 ? slowest / mean : 1.0) << "x)" << std::endl;
+	}
+
+	if (prefix.empty())
+	{
+		for (unsigned int i = 0; i < m_count; i++)
+		{
+			remove(get_file_name(files_prefix, i).c_str());
+		}
+		rmdir(temporary_dir);
+	}
+
+	return failed ? -1 : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+unsigned int CSudokuShards::get_board_shard(const CSudokuBoard &board, unsigned int count)
+{
+	char buffer[E_SUDOKU_BOX_COUNT];
+	uint32_t hash = 2166136261u;
+
+	// FNV-1a, it doesn't depend on the platform
+	board.save_to_buffer(buffer);
+	for (char value : buffer)
+	{
+		hash ^= (unsigned char)value;
+		hash *= 16777619u;
+	}
+
+	return hash % count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::streamoff CSudokuShards::find_board_start(std::istream &input,
+										std::streamoff offset, std::streamoff size)
+{
+	std::vector<std::streamoff> lines;
+	std::vector<int> separators;
+	std::string line;
+
+	if (offset <= 0) return 0;
+	if (offset >= size) return size;
+
+	// Go to the first line which starts at offset or after it
+	input.clear();
+	input.seekg(offset - 1);
+	std::getline(input, line);
+
+	// Two separators show the row of every line: the first one of a board
+	// is followed by the second one, the second one by next board
+	while (separators.size() < 2 ||
+			(int)lines.size() <= separators[0] + BOARD_LINES)
+	{
+		std::streamoff position = input.tellg();
+		if (!std::getline(input, line)) break;
+
+		size_t first_char = line.find_first_not_of(" \t\r");
+		if (first_char == std::string::npos) continue;
+
+		if (line[first_char] == '-') separators.push_back(lines.size());
+		lines.push_back(position);
+	}
+
+	if (separators.size() < 2) return size;
+
+	int separator_line = (separators[1] - separators[0] == SECOND_SEPARATOR_LINE -
+						FIRST_SEPARATOR_LINE) ? FIRST_SEPARATOR_LINE : SECOND_SEPARATOR_LINE;
+	int first_line = ((separator_line - separators[0]) % BOARD_LINES + BOARD_LINES) %
+						BOARD_LINES;
+	int board_start = (BOARD_LINES - first_line) % BOARD_LINES;
+
+	return board_start < (int)lines.size() ? lines[board_start] : size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string CSudokuShards::get_file_name(const std::string &prefix, unsigned int index)
+{
+	return prefix + "." + std::to_string(index);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuShards::_read_output(std::istream &input, std::string *first,
+								std::string *rest)
+{
+	std::string line;
+	unsigned int lines;
+
+	if (!std::getline(input, *first)) return false;
+
+	if (first->compare(0, strlen(UNSOLVED_OUTPUT), UNSOLVED_OUTPUT) != 0)
+	{
+		lines = SOLVED_OUTPUT_LINES;
+	}
+	else if (first->find("timed out") != std::string::npos)
+	{
+		lines = TIMED_OUT_OUTPUT_LINES;
+	}
+	else
+	{
+		lines = UNSOLVABLE_OUTPUT_LINES;
+	}
+
+	rest->clear();
+	for (unsigned int i = 0; i < lines; i++)
+	{
+		if (!std::getline(input, line)) return false;
+		*rest += line;
+		*rest += '\n';
+	}
+
+	return true;
+}
+
+} // namespace sudoku
@@ -0,0 +1,166 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_solutions.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_solutions.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#include "sudoku_solutions.hpp"
+
+namespace sudoku{
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuSolutions::CSudokuSolutions(): m_empty_count(0), m_depth(0),
+	m_found(false), m_finished(true), m_count(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuSolutions::start(const CSudokuBoard &puzzle)
+{
+	m_finished = true;
+	if (!is_supported(puzzle.get_layout())) return false;
+
+	puzzle.save_to_buffer(m_values);
+
+	for (auto &used : m_used) used = 0;
+	m_empty_count = 0;
+	m_depth = 0;
+	m_found = false;
+	m_count = 0;
+
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		if (m_values[box] == '0')
+		{
+			m_empty[m_empty_count++] = box;
+			continue;
+		}
+
+		uint16_t valor = 1 << (m_values[box] - '0');
+		for (int u = 0; u < E_SUDOKU_UNITS_BY_BOX; u++)
+		{
+			uint16_t &used = m_used[sudoku_tables.box_units[box][u]];
+
+			if (used & valor) return false;
+			used |= valor;
+		}
+	}
+
+	m_finished = false;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuSolutions::next(void)
+{
+	if (m_finished) return false;
+
+	// Search goes on from the last solution
+	if (m_found && !_backtrack())
+	{
+		m_finished = true;
+		return false;
+	}
+	m_found = false;
+
+	while (m_depth < m_empty_count)
+	{
+		// Empty box with less possible values
+		unsigned int best = m_depth;
+		uint16_t best_possible = 0;
+		int best_count = E_SUDOKU_DIM + 1;
+
+		for (unsigned int i = m_depth; i < m_empty_count && best_count > 1; i++)
+		{
+			uint16_t possible = _get_possible(m_empty[i]);
+			int count = __builtin_popcount(possible);
+
+			if (count < best_count)
+			{
+				best = i;
+				best_possible = possible;
+				best_count = count;
+			}
+		}
+
+		if (best_count == 0)
+		{
+			if (!_backtrack())
+			{
+				m_finished = true;
+				return false;
+			}
+			continue;
+		}
+
+		unsigned char box = m_empty[best];
+		m_empty[best] = m_empty[m_depth];
+		m_empty[m_depth] = box;
+		m_untried[m_depth] = best_possible;
+		_push_value();
+	}
+
+	m_found = true;
+	m_count++;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuSolutions::_push_value(void)
+{
+	int box = m_empty[m_depth];
+	const unsigned char *units = sudoku_tables.box_units[box];
+	uint16_t valor = m_untried[m_depth] & -m_untried[m_depth];
+
+	m_untried[m_depth] ^= valor;
+	m_values[box] = '0' + __builtin_ctz(valor);
+	m_used[units[0]] |= valor;
+	m_used[units[1]] |= valor;
+	m_used[units[2]] |= valor;
+	m_depth++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuSolutions::_backtrack(void)
+{
+	while (m_depth > 0)
+	{
+		m_depth--;
+
+		int box = m_empty[m_depth];
+		const unsigned char *units = sudoku_tables.box_units[box];
+		uint16_t valor = ~(1 << (m_values[box] - '0'));
+
+		m_values[box] = '0';
+		m_used[units[0]] &= valor;
+		m_used[units[1]] &= valor;
+		m_used[units[2]] &= valor;
+
+		if (m_untried[m_depth] != 0)
+		{
+			_push_value();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+} // namespace sudoku
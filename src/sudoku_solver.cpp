@@ -28,20 +28,37 @@
 #include <fstream>
 #include <cstdlib>
 #include <vector>
+#include <csignal>
+#include <iterator>
 
 #include <getopt.h>
 
 #include "cnode.hpp"
+#include "sudoku_daemon.hpp"
+#include "sudoku_pipeline.hpp"
+#include "sudoku_shards.hpp"
+#include "sudoku_solutions.hpp"
+#include "sudoku_validator.hpp"
 
 using namespace sudoku;
 
+static void metrics_signal_handler(int)
+{
+	CSudokuMetrics::request_dump();
+}
+
+static CSudokuDaemon *running_daemon = nullptr;
+
+static void daemon_signal_handler(int)
+{
+	if (running_daemon) running_daemon->stop();
+}
+
 int main(int argc, char** argv)
 {
 
 	CNode<CSudokuBoard> *initialState;
-	initialState = new CNode<CSudokuBoard>;
-	std::vector<CSudokuBoard> *visitados;
-	visitados = new std::vector<CSudokuBoard>[E_SUDOKU_BOX_COUNT - 1];
+	CSearchContext<CSudokuBoard> *visitados;
 
 	CSudokuBoard sudoku;
 
@@ -49,19 +66,247 @@ int main(int argc, char** argv)
 	// Get arguments
 	int c = 0;
 	char* file_name = nullptr;
+	char* socket_path = nullptr;
+	char* batch_file_name = nullptr;
+	char* metrics_file_name = nullptr;
+	unsigned int metrics_period = 10;
+	unsigned int worker_count = 0;
+	bool interactive = false;
+	unsigned int shard_count = 0;
+	int shard_index = -1;
+	E_SUDOKU_SHARDING sharding = E_SUDOKU_SHARDING_RANGE;
+	std::string shards_prefix;
+	bool shards_merge = false;
+	char* journal_file_name = nullptr;
+	char* claims_file_name = nullptr;
+	char* trace_file_name = nullptr;
+	unsigned long journal_interval = 1000;
+	bool memory_report = false;
+	bool enumerate = false;
+	bool enumerate_write = false;
+	unsigned long long enumerate_limit = 0;
+	CSudokuLayout layout;
+	SSudokuWorkerOptions options;
 	opterr = 0;
 
-	while ((c = getopt (argc, argv, "f:")) != -1)
+	while ((c = getopt (argc, argv, "f:d:w:b:m:M:s:P:c:e:t:o:i:n:k:p:g:j:u:v:B:a:A:L:V:T:Y:JSrI")) != -1)
 	{
 		switch (c)
 		{
 			case 'f':
 				file_name = optarg;
 				break;
+			case 'd':
+				socket_path = optarg;
+				break;
+			case 'w':
+				worker_count = atoi(optarg);
+				break;
+			case 'b':
+				batch_file_name = optarg;
+				break;
+			case 'm':
+				options.memory_limit = strtoul(optarg, nullptr, 10) * 1024 * 1024;
+				break;
+			case 's':
+				if (!get_strategy_by_name(optarg, &options.strategy))
+				{
+					fprintf (stderr, "Unknown strategy: %s "
+						"(rules, dfs, best, beam or iddfs).\n", optarg);
+					return 1;
+				}
+				break;
+			case 'P':
+				if (!get_strategies_by_names(optarg, &options.portfolio))
+				{
+					fprintf (stderr, "Unknown strategy in portfolio: %s "
+						"(list of rules, dfs, best, beam or iddfs).\n", optarg);
+					return 1;
+				}
+				break;
+			case 'S':
+				options.lockstep = false;
+				break;
+			case 'v':
+				if (!get_value_order_by_name(optarg, &options.value_order))
+				{
+					fprintf (stderr, "Unknown value order: %s "
+						"(numeric, lcv, random or learned).\n", optarg);
+					return 1;
+				}
+				break;
+			case 'B':
+				if (!get_branching_by_spec(optarg, &options.branching))
+				{
+					fprintf (stderr, "Bad branching: %s "
+						"(min,max[,boxes[,failure rate]]).\n", optarg);
+					return 1;
+				}
+				break;
+			case 'r':
+				memory_report = true;
+				break;
+			case 'L':
+				// Every board is built with this layout from here
+				if (!layout.load_by_name(optarg))
+				{
+					fprintf (stderr, "Unknown sudoku layout: %s "
+						"(classic, x, windoku or layout file).\n", optarg);
+					return 1;
+				}
+				CSudokuLayout::set_default(&layout);
+				sudoku.set_layout(&layout);
+				break;
+			case 'a':
+			case 'A':
+				enumerate = true;
+				enumerate_write = (c == 'A');
+				enumerate_limit = strtoull(optarg, nullptr, 10);
+				break;
+			case 'V':
+				claims_file_name = optarg;
+				break;
+			case 'T':
+				trace_file_name = optarg;
+				options.trace_prefix = optarg;
+				break;
+			case 'Y':
+				options.trace_sample = strtoul(optarg, nullptr, 10);
+				break;
+			case 'c':
+				options.visited_capacity = strtoul(optarg, nullptr, 10);
+				break;
+			case 'e':
+				if (!get_eviction_by_name(optarg, &options.visited_eviction))
+				{
+					fprintf (stderr, "Unknown visited eviction: %s "
+						"(subtree, lru or depth).\n", optarg);
+					return 1;
+				}
+				break;
+			case 'o':
+				metrics_file_name = optarg;
+				break;
+			case 'i':
+				metrics_period = atoi(optarg);
+				break;
+			case 't':
+				options.timeout = strtoul(optarg, nullptr, 10);
+				break;
+			case 'n':
+				shard_count = atoi(optarg);
+				break;
+			case 'k':
+				shard_index = atoi(optarg);
+				break;
+			case 'p':
+				if (!get_sharding_by_name(optarg, &sharding))
+				{
+					fprintf (stderr, "Unknown sharding: %s (range or hash).\n", optarg);
+					return 1;
+				}
+				break;
+			case 'g':
+				shards_prefix = optarg;
+				break;
+			case 'J':
+				shards_merge = true;
+				break;
+			case 'j':
+				journal_file_name = optarg;
+				break;
+			case 'u':
+				journal_interval = strtoul(optarg, nullptr, 10);
+				break;
+			case 'M':
+				CMemoryBudget::process().set_limit(
+									strtoul(optarg, nullptr, 10) * 1024 * 1024);
+				break;
+			case 'I':
+				interactive = true;
+				break;
 			case '?':
 				if (optopt == 'f')
 					fprintf (stderr,
 						"Option -%c requires an argument: file name.\n", optopt);
+				else if (optopt == 'd')
+					fprintf (stderr,
+						"Option -%c requires an argument: socket path.\n", optopt);
+				else if (optopt == 'b')
+					fprintf (stderr,
+						"Option -%c requires an argument: batch file name.\n", optopt);
+				else if (optopt == 'm' || optopt == 'M')
+					fprintf (stderr,
+						"Option -%c requires an argument: memory limit in MB.\n", optopt);
+				else if (optopt == 's')
+					fprintf (stderr,
+						"Option -%c requires an argument: strategy.\n", optopt);
+				else if (optopt == 'P')
+					fprintf (stderr,
+						"Option -%c requires an argument: strategies.\n", optopt);
+				else if (optopt == 'c')
+					fprintf (stderr,
+						"Option -%c requires an argument: visited capacity.\n", optopt);
+				else if (optopt == 'e')
+					fprintf (stderr,
+						"Option -%c requires an argument: visited eviction.\n", optopt);
+				else if (optopt == 'a' || optopt == 'A')
+					fprintf (stderr,
+						"Option -%c requires an argument: max solutions, 0 all.\n",
+						optopt);
+				else if (optopt == 'T')
+					fprintf (stderr,
+						"Option -%c requires an argument: trace file name or prefix.\n",
+						optopt);
+				else if (optopt == 'Y')
+					fprintf (stderr,
+						"Option -%c requires an argument: trace sample period.\n",
+						optopt);
+				else if (optopt == 'V')
+					fprintf (stderr,
+						"Option -%c requires an argument: claims file name.\n", optopt);
+				else if (optopt == 'L')
+					fprintf (stderr,
+						"Option -%c requires an argument: sudoku layout.\n", optopt);
+				else if (optopt == 'v')
+					fprintf (stderr,
+						"Option -%c requires an argument: value order.\n", optopt);
+				else if (optopt == 'B')
+					fprintf (stderr,
+						"Option -%c requires an argument: branching.\n", optopt);
+				else if (optopt == 'o')
+					fprintf (stderr,
+						"Option -%c requires an argument: metrics file name.\n", optopt);
+				else if (optopt == 'i')
+					fprintf (stderr,
+						"Option -%c requires an argument: metrics period in seconds.\n",
+						optopt);
+				else if (optopt == 't')
+					fprintf (stderr,
+						"Option -%c requires an argument: timeout in ms.\n", optopt);
+				else if (optopt == 'w')
+					fprintf (stderr,
+						"Option -%c requires an argument: worker count.\n", optopt);
+				else if (optopt == 'n')
+					fprintf (stderr,
+						"Option -%c requires an argument: shard count.\n", optopt);
+				else if (optopt == 'k')
+					fprintf (stderr,
+						"Option -%c requires an argument: shard index.\n", optopt);
+				else if (optopt == 'p')
+					fprintf (stderr,
+						"Option -%c requires an argument: sharding.\n", optopt);
+				else if (optopt == 'j')
+					fprintf (stderr,
+						"Option -%c requires an argument: journal file name.\n", optopt);
+				else if (optopt == 'u')
+					fprintf (stderr,
+						"Option -%c requires an argument: journal interval in ms.\n",
+						optopt);
+				else if (optopt == 'g')
+					fprintf (stderr,
+						"Option -%c requires an argument: shard output prefix.\n",
+						optopt);
 				else if (isprint (optopt))
 					fprintf (stderr, "Unknown option `-%c'.\n", optopt);
 				else
@@ -74,6 +319,145 @@ int main(int argc, char** argv)
 		}
 	}
 
+	//--------------------------------------------------------------------------
+	// Validation of claimed solutions, line numbers of invalid ones are
+	// written in stdout
+	if (claims_file_name != nullptr)
+	{
+		std::ifstream claims_file(claims_file_name, std::ios::binary);
+		if (!claims_file.is_open())
+		{
+			std::cerr << " Error opening claims file: " << claims_file_name << std::endl;
+			return -1;
+		}
+
+		std::vector<char> claims((std::istreambuf_iterator<char>(claims_file)),
+								std::istreambuf_iterator<char>());
+		std::vector<size_t> invalid;
+		CSudokuValidator validator(worker_count);
+
+		auto start = std::chrono::steady_clock::now();
+		size_t count = validator.validate_lines(claims.data(), claims.size(), &invalid);
+		double seconds = std::chrono::duration<double>(
+								std::chrono::steady_clock::now() - start).count();
+
+		for (size_t line : invalid) std::cout << line << '\n';
+		std::cout.flush();
+		std::cerr << " " << count << " claims, " << invalid.size() << " invalid in "
+				<< seconds * 1000 << " ms (" << (seconds > 0 ?
+				claims.size() / seconds / (1024 * 1024) : 0.0) << " MB/s)" << std::endl;
+
+		return invalid.empty() ? 0 : 1;
+	}
+
+	// Batch boards are traced with -T, every one by default
+	if (trace_file_name != nullptr && options.trace_sample == 0)
+	{
+		options.trace_sample = 1;
+	}
+	if (trace_file_name == nullptr) options.trace_sample = 0;
+
+	//--------------------------------------------------------------------------
+	// Sharded batch: merge of shard outputs, or every shard in a child
+	// process. It's done before metrics thread starts, children are forked
+	if (batch_file_name != nullptr && shard_count > 0 && shard_index < 0)
+	{
+		CSudokuShards shards(batch_file_name, shard_count, sharding);
+
+		if (shards_merge)
+		{
+			return shards.merge(shards_prefix, std::cout) ? 0 : -1;
+		}
+		return shards.run(shards_prefix, worker_count, options, std::cout);
+	}
+
+	//--------------------------------------------------------------------------
+	// Metrics of daemon and batch modes, SIGUSR1 writes them in stderr
+	CSudokuMetrics metrics;
+	if (socket_path != nullptr || batch_file_name != nullptr)
+	{
+		signal(SIGUSR1, metrics_signal_handler);
+		metrics.start(metrics_file_name ? metrics_file_name : "", metrics_period);
+	}
+
+	//--------------------------------------------------------------------------
+	// Daemon mode, boards are received from Unix domain socket
+	if (socket_path != nullptr)
+	{
+		CSudokuDaemon daemon(socket_path, worker_count, options);
+		daemon.set_metrics(&metrics);
+
+		// SIGTERM and SIGINT stop it, socket file is removed
+		running_daemon = &daemon;
+		signal(SIGTERM, daemon_signal_handler);
+		signal(SIGINT, daemon_signal_handler);
+		int result = daemon.run();
+		signal(SIGTERM, SIG_DFL);
+		signal(SIGINT, SIG_DFL);
+		running_daemon = nullptr;
+		return result;
+	}
+
+	//--------------------------------------------------------------------------
+	// Batch mode, every board in file is solved and written in stdout
+	if (batch_file_name != nullptr)
+	{
+		std::ifstream batch_file(batch_file_name);
+		if (!batch_file.is_open())
+		{
+			std::cerr << " Error opening batch file: " << batch_file_name << std::endl;
+			return -1;
+		}
+
+		CSudokuPipeline pipeline(worker_count, options);
+		pipeline.set_metrics(&metrics);
+
+		// Progress journal, a run with the same journal resumes this one
+		CSudokuJournal journal;
+		if (journal_file_name != nullptr)
+		{
+			if (!journal.open(journal_file_name, batch_file,
+							std::chrono::milliseconds(journal_interval)))
+			{
+				return -1;
+			}
+			if (journal.get_resume_count() > 0)
+			{
+				std::cerr << " Resuming after " << journal.get_resume_count()
+						<< " boards in journal" << std::endl;
+			}
+			pipeline.set_journal(&journal);
+		}
+
+		// Only one shard, in stdout or in its output file
+		if (shard_count > 0)
+		{
+			CSudokuShards shards(batch_file_name, shard_count, sharding);
+			std::ofstream shard_file;
+
+			if (!shards_prefix.empty())
+			{
+				shard_file.open(CSudokuShards::get_file_name(shards_prefix, shard_index));
+				if (!shard_file.is_open())
+				{
+					std::cerr << " Error opening shard output: " << CSudokuShards::
+							get_file_name(shards_prefix, shard_index) << std::endl;
+					return -1;
+				}
+			}
+
+			return (shards.solve(shard_index, pipeline,
+					shards_prefix.empty() ? std::cout : shard_file) < 0) ? -1 : 0;
+		}
+
+		long boards = pipeline.run(batch_file, std::cout);
+
+		// Memory peaks of this batch, to size memory budget
+		if (memory_report) metrics.write_memory(std::cerr);
+
+		return (boards < 0) ? -1 : 0;
+	}
+
 	//--------------------------------------------------------------------------
 	// Get sudoku board from file
 	std::ifstream sudoku_file(file_name);
@@ -87,20 +471,156 @@ int main(int argc, char** argv)
 	}
 	sudoku_file.close();
 
+	//--------------------------------------------------------------------------
+	// Enumeration of every solution, one by line (81 characters)
+	if (enumerate)
+	{
+		CSudokuSolutions solutions;
+		if (!CSudokuSolutions::is_supported(sudoku.get_layout()))
+		{
+			std::cerr << " Enumeration of solutions supports only the classic layout"
+					<< std::endl;
+			return -1;
+		}
+		if (!solutions.start(sudoku))
+		{
+			std::cerr << " Sudoku board breaks sudoku rules" << std::endl;
+			return -1;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		uint64_t count = solutions.for_each([enumerate_write](const char *solution)
+			{
+				if (enumerate_write)
+				{
+					std::cout.write(solution, E_SUDOKU_BOX_COUNT);
+					std::cout.put('\n');
+				}
+				return true;
+			}, enumerate_limit);
+		double seconds = std::chrono::duration<double>(
+								std::chrono::steady_clock::now() - start).count();
+
+		std::cout.flush();
+		std::cerr << " " << count << " solutions in " << seconds * 1000 << " ms ("
+				<< (seconds > 0 ? count / seconds : 0.0) << " solutions/s)" << std::endl;
+		return 0;
+	}
+
 	//--------------------------------------------------------------------------
 	// Sudoku resolution
 	std::cout << " This sodoku will be solved: " <<
 								std::endl << std::endl << sudoku << std::endl;
 
-	std::cout << " Press intro key: " << std::endl << std::endl;
-	c = getchar();
+	// Only with -I, single board mode is used by scripts too
+	if (interactive)
+	{
+		std::cout << " Press intro key: " << std::endl << std::endl;
+		c = getchar();
+	}
+
+	// Portfolio is silent, only the first solution is written
+	if (!options.portfolio.empty())
+	{
+		CSudokuPortfolio portfolio(options);
+		CSudokuBoard solution;
+
+		int result = portfolio.solve(sudoku, solution);
+		if (result == CSudokuWorker::E_SUDOKU_WORKER_SOLVED)
+		{
+			std::cout << solution << std::endl << " Solved first by "
+					<< get_strategy_name(portfolio.get_winner()) << std::endl;
+		}
+		else if (result == CSudokuWorker::E_SUDOKU_WORKER_TIMED_OUT)
+		{
+			std::cout << " Timeout or gave up. Partial board:" << std::endl << std::endl
+					<< solution << std::endl;
+		}
+		else
+		{
+			std::cout << " Sudoku board hasn't got solution" << std::endl;
+		}
+		return 0;
+	}
+	initialState = new CNode<CSudokuBoard>;
+	visitados = new CSearchContext<CSudokuBoard>(E_SUDOKU_BOX_COUNT - 1);
+	visitados->set_memory_limit(options.memory_limit);
+	visitados->set_visited_capacity(options.visited_capacity);
+	visitados->set_visited_eviction(options.visited_eviction);
+	visitados->set_branching(options.branching);
+	CSudokuValueOrder value_order(options.value_order);
+	if (options.value_order != E_SUDOKU_VALUE_ORDER_NUMERIC)
+	{
+		visitados->set_children_order(&value_order);
+	}
+	if (options.timeout > 0)
+	{
+		visitados->set_deadline(std::chrono::steady_clock::now() +
+								std::chrono::milliseconds(options.timeout));
+	}
 	initialState->set_information(sudoku);
-	for(c = 0; c < E_SUDOKU_BOX_COUNT - 1; c++) visitados[c].clear();
 
-	initialState->search(&visitados);
+	std::unique_ptr<CSearchTrace> trace;
+	if (trace_file_name != nullptr)
+	{
+		trace.reset(new CSearchTrace(1 << 20));
+		visitados->set_trace(trace.get());
+	}
+
+	bool solved = search_with_strategy(initialState, visitados, options.strategy);
+
+	// Search trace, in Chrome format if file name ends in .json
+	if (trace)
+	{
+		std::string name(trace_file_name);
+		bool chrome = name.size() > 5 && name.compare(name.size() - 5, 5, ".json") == 0;
+		std::ofstream trace_file(name, std::ios::binary);
+
+		if (chrome) trace->write_chrome(trace_file);
+		if ((!chrome && !trace->write(trace_file)) || trace_file.fail())
+		{
+			std::cerr << " Error writing search trace: " << name << std::endl;
+		}
+	}
+
+	const SSearchStatistics &statistics = visitados->get_statistics();
+	if (statistics.stopped)
+	{
+		std::cout << " Timeout, search stopped after " << statistics.expanded_nodes
+				<< " expanded nodes. Partial board:" << std::endl << std::endl
+				<< (visitados->has_best() ? visitados->get_best() : sudoku)
+				<< std::endl;
+	}
+	else if (!solved && statistics.gave_up)
+	{
+		// Beam dropped nodes, the board can have a solution
+		std::cout << " Search gave up after " << statistics.expanded_nodes
+				<< " expanded nodes. Partial board:" << std::endl << std::endl
+				<< (visitados->has_best() ? visitados->get_best() : sudoku)
+				<< std::endl;
+	}
+	if (statistics.is_degraded())
+	{
+		std::cout << " Memory budget reached: " << statistics.visited_dropped
+				<< " visited nodes dropped, " << statistics.bounded_expansions
+				<< " bounded expansions" << std::endl;
+	}
+
+	std::cout << " Visited store: " << statistics.visited_lookups << " lookups, "
+			<< statistics.visited_hits << " hits ("
+			<< 100.0 * statistics.visited_hit_rate() << "%), "
+			<< statistics.visited_evicted << " evicted, "
+			<< statistics.visited_count << " kept, "
+			<< statistics.backjumps << " backjumps" << std::endl;
+
+	std::cout << " Memory (bytes): " << statistics.live_bytes() << " live, "
+			<< statistics.peak_bytes << " peak. Peaks by component: tree "
+			<< statistics.peak_tree_bytes << " (" << statistics.peak_live_nodes
+			<< " nodes wide), visited store " << statistics.peak_visited_bytes
+			<< ", children " << statistics.peak_children_bytes << std::endl;
 
 	delete initialState;
-	delete[] visitados;
+	delete visitados;
 
 	return 0;
 }
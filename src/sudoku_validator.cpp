@@ -0,0 +1,339 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_validator.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_validator.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#include "sudoku_validator.hpp"
+
+#include <cstring>
+#include <thread>
+#include <algorithm>
+
+namespace sudoku{
+
+// Bit v is value v, bit 0 isn't used
+static const uint16_t ALL_VALUES = 0x3FE;
+
+// Given value which isn't a value nor an empty box, it never matches
+static const uint16_t INVALID_GIVEN = 1;
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Bit masks of characters and nibbles, in solutions and in puzzles
+ */
+struct SValidatorMasks
+{
+	uint16_t value[256];
+	uint16_t given[256];
+	uint16_t packed_value[16];
+	uint16_t packed_given[16];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @return masks, it's only called at compile time
+ */
+constexpr SValidatorMasks make_validator_masks(void)
+{
+	SValidatorMasks masks{};
+
+	for (int c = 0; c < 256; c++)
+	{
+		masks.given[c] = (c == '0' || c == '.') ? 0 : INVALID_GIVEN;
+	}
+	for (int n = 0; n < 16; n++) masks.packed_given[n] = (n == 0) ? 0 : INVALID_GIVEN;
+
+	for (int valor = 1; valor <= E_SUDOKU_DIM; valor++)
+	{
+		masks.value['0' + valor] = masks.given['0' + valor] = 1 << valor;
+		masks.packed_value[valor] = masks.packed_given[valor] = 1 << valor;
+	}
+
+	return masks;
+}
+
+static constexpr SValidatorMasks validator_masks = make_validator_masks();
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuValidator::CSudokuValidator(unsigned int thread_count):
+	m_thread_count(thread_count)
+{
+	if (m_thread_count == 0)
+	{
+		m_thread_count = std::thread::hardware_concurrency();
+		if (m_thread_count == 0) m_thread_count = 1;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+size_t CSudokuValidator::validate(const char *solutions, const char *puzzles,
+								size_t count, unsigned char *valid) const
+{
+	return _validate(solutions, puzzles, count, E_SUDOKU_BOX_COUNT, valid);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+size_t CSudokuValidator::validate_packed(const uint8_t *solutions,
+									const uint8_t *puzzles, size_t count,
+									unsigned char *valid) const
+{
+	return _validate(solutions, puzzles, count, E_SUDOKU_VALIDATOR_PACKED_SIZE, valid);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+size_t CSudokuValidator::validate_lines(const char *buffer, size_t size,
+										std::vector<size_t> *invalid) const
+{
+	// Every claim has a solution line at least
+	unsigned int thread_count = _get_thread_count(size / (E_SUDOKU_BOX_COUNT + 1));
+	std::vector<const char *> starts(thread_count + 1, buffer + size);
+	std::vector< std::vector<size_t> > invalids(thread_count);
+	std::vector<size_t> lines(thread_count, 0);
+	std::vector<size_t> claims(thread_count, 0);
+	std::vector<std::thread> threads;
+
+	// Ranges start after a new line character
+	starts[0] = buffer;
+	for (unsigned int t = 1; t < thread_count; t++)
+	{
+		const char *start = std::max(buffer + size * t / thread_count, starts[t - 1]);
+		const char *eol = (const char *)memchr(start, '\n', buffer + size - start);
+
+		starts[t] = eol ? eol + 1 : buffer + size;
+	}
+
+	auto check = [&](unsigned int t)
+		{
+			lines[t] = _validate_lines(starts[t], starts[t + 1], &invalids[t], &claims[t]);
+		};
+	for (unsigned int t = 1; t < thread_count; t++) threads.push_back(std::thread(check, t));
+	check(0);
+	for (auto &thread : threads) thread.join();
+
+	size_t claim_count = 0;
+	size_t first_line = 1;
+	for (unsigned int t = 0; t < thread_count; t++)
+	{
+		if (invalid)
+		{
+			for (size_t line : invalids[t]) invalid->push_back(first_line + line);
+		}
+		first_line += lines[t];
+		claim_count += claims[t];
+	}
+
+	return claim_count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuValidator::pack(const char *grid, uint8_t *packed)
+{
+	memset(packed, 0, E_SUDOKU_VALIDATOR_PACKED_SIZE);
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		uint8_t valor = (grid[box] >= '1' && grid[box] <= '9') ? grid[box] - '0' : 0;
+		packed[box / 2] |= valor << ((box & 1) * 4);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuValidator::_load(SLanes *lanes, unsigned int lane, const char *solution,
+							const char *puzzle)
+{
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		lanes->values[box][lane] = validator_masks.value[(unsigned char)solution[box]];
+	}
+
+	if (puzzle == nullptr) return;
+
+	// Masks have one bit, a given value without bit in value is wrong
+	uint16_t wrong = 0;
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		wrong |= validator_masks.given[(unsigned char)puzzle[box]] &
+				~validator_masks.value[(unsigned char)solution[box]];
+	}
+	if (wrong) lanes->wrong_givens |= 1u << lane;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuValidator::_load(SLanes *lanes, unsigned int lane, const uint8_t *solution,
+							const uint8_t *puzzle)
+{
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		uint8_t nibble = (solution[box / 2] >> ((box & 1) * 4)) & 0xF;
+		lanes->values[box][lane] = validator_masks.packed_value[nibble];
+	}
+
+	if (puzzle == nullptr) return;
+
+	uint16_t wrong = 0;
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		int shift = (box & 1) * 4;
+		wrong |= validator_masks.packed_given[(puzzle[box / 2] >> shift) & 0xF] &
+				~validator_masks.packed_value[(solution[box / 2] >> shift) & 0xF];
+	}
+	if (wrong) lanes->wrong_givens |= 1u << lane;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint32_t CSudokuValidator::_check(SLanes *lanes)
+{
+	lane_vector failed = {0};
+
+	// Nine boxes with nine different values, an empty box or an invalid
+	// character hasn't got any bit
+	for (int unit = 0; unit < E_SUDOKU_UNIT_COUNT; unit++)
+	{
+		const unsigned char *boxes = sudoku_tables.units[unit];
+		lane_vector used = lanes->values[boxes[0]];
+
+		for (int i = 1; i < E_SUDOKU_DIM; i++) used |= lanes->values[boxes[i]];
+		failed |= (lane_vector)(used != ALL_VALUES);
+	}
+
+	uint32_t result = lanes->wrong_givens;
+	for (int lane = 0; lane < E_SUDOKU_VALIDATOR_LANES; lane++)
+	{
+		if (failed[lane]) result |= 1u << lane;
+	}
+
+	lanes->wrong_givens = 0;
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <class Grid>
+size_t CSudokuValidator::_validate(const Grid *solutions, const Grid *puzzles,
+								size_t count, size_t grid_size,
+								unsigned char *valid) const
+{
+	unsigned int thread_count = _get_thread_count(count);
+	size_t block_count = (count + E_SUDOKU_VALIDATOR_LANES - 1) / E_SUDOKU_VALIDATOR_LANES;
+	std::vector<size_t> valid_counts(thread_count, 0);
+	std::vector<std::thread> threads;
+
+	// Every thread checks a range of blocks of lanes
+	auto check = [&](unsigned int t)
+		{
+			size_t end = std::min(count, block_count * (t + 1) / thread_count *
+											E_SUDOKU_VALIDATOR_LANES);
+			SLanes lanes;
+
+			for (size_t first = block_count * t / thread_count * E_SUDOKU_VALIDATOR_LANES;
+				first < end; first += E_SUDOKU_VALIDATOR_LANES)
+			{
+				unsigned int lane_count = std::min<size_t>(E_SUDOKU_VALIDATOR_LANES,
+															end - first);
+
+				for (unsigned int lane = 0; lane < lane_count; lane++)
+				{
+					size_t offset = (first + lane) * grid_size;
+					_load(&lanes, lane, solutions + offset,
+						puzzles ? puzzles + offset : (const Grid *)nullptr);
+				}
+
+				// Lanes over lane_count have old grids, they are ignored
+				uint32_t failed = _check(&lanes);
+				for (unsigned int lane = 0; lane < lane_count; lane++)
+				{
+					bool is_valid = !(failed & (1u << lane));
+
+					if (valid) valid[first + lane] = is_valid;
+					valid_counts[t] += is_valid;
+				}
+			}
+		};
+	for (unsigned int t = 1; t < thread_count; t++) threads.push_back(std::thread(check, t));
+	check(0);
+	for (auto &thread : threads) thread.join();
+
+	size_t valid_count = 0;
+	for (size_t n : valid_counts) valid_count += n;
+	return valid_count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+size_t CSudokuValidator::_validate_lines(const char *begin, const char *end,
+										std::vector<size_t> *invalid, size_t *claims)
+{
+	SLanes lanes;
+	size_t numbers[E_SUDOKU_VALIDATOR_LANES];
+	unsigned int lane_count = 0;
+	size_t line = 0;
+
+	auto flush = [&]()
+		{
+			uint32_t failed = _check(&lanes);
+			for (unsigned int lane = 0; lane < lane_count; lane++)
+			{
+				if (failed & (1u << lane)) invalid->push_back(numbers[lane]);
+			}
+			lane_count = 0;
+		};
+
+	*claims = 0;
+	for (const char *p = begin; p < end; line++)
+	{
+		const char *eol = (const char *)memchr(p, '\n', end - p);
+		if (eol == nullptr) eol = end;
+
+		size_t length = eol - p;
+		if (length > 0 && p[length - 1] == '\r') length--;
+
+		if (length == E_SUDOKU_BOX_COUNT)
+		{
+			numbers[lane_count] = line;
+			_load(&lanes, lane_count++, p, nullptr);
+		}
+		else if (length == 2 * E_SUDOKU_BOX_COUNT + 1)
+		{
+			numbers[lane_count] = line;
+			_load(&lanes, lane_count++, p + E_SUDOKU_BOX_COUNT + 1, p);
+		}
+		else if (length > 0)
+		{
+			// Malformed line, after the previous lines to keep the order
+			if (lane_count > 0) flush();
+			invalid->push_back(line);
+		}
+
+		if (length > 0) (*claims)++;
+		if (lane_count == E_SUDOKU_VALIDATOR_LANES) flush();
+
+		p = eol + 1;
+	}
+	if (lane_count > 0) flush();
+
+	return line;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+unsigned int CSudokuValidator::_get_thread_count(size_t work) const
+{
+	return std::max<size_t>(1, std::min<size_t>(m_thread_count,
+									work / E_SUDOKU_VALIDATOR_THREAD_GRIDS));
+}
+
+} // namespace sudoku
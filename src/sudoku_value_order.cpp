@@ -0,0 +1,138 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_value_order.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_value_order.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#include "sudoku_value_order.hpp"
+
+#include <algorithm>
+
+namespace sudoku{
+
+////////////////////////////////////////////////////////////////////////////////
+bool get_value_order_by_name(const std::string &name, E_SUDOKU_VALUE_ORDER *order)
+{
+	static const struct
+	{
+		const char *name;
+		E_SUDOKU_VALUE_ORDER order;
+	} orders[] =
+	{
+		{"numeric", E_SUDOKU_VALUE_ORDER_NUMERIC},
+		{"lcv", E_SUDOKU_VALUE_ORDER_LEAST_CONSTRAINING},
+		{"random", E_SUDOKU_VALUE_ORDER_RANDOM},
+		{"learned", E_SUDOKU_VALUE_ORDER_LEARNED}
+	};
+
+	for (const auto &it : orders)
+	{
+		if (name == it.name)
+		{
+			*order = it.order;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+CSudokuValueOrder::CSudokuValueOrder(E_SUDOKU_VALUE_ORDER order, unsigned int seed):
+	m_order(order), m_random(seed)
+{
+	clear_learned();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuValueOrder::clear_learned(void)
+{
+	for (auto &box : m_weights)
+	{
+		for (auto &weight : box) weight = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuValueOrder::order(const CSudokuBoard &parent, int box,
+							short int *values, int count)
+{
+	if (m_order == E_SUDOKU_VALUE_ORDER_NUMERIC || count < 2) return;
+
+	if (m_order == E_SUDOKU_VALUE_ORDER_RANDOM)
+	{
+		std::shuffle(values, values + count, m_random);
+		return;
+	}
+
+	m_scores.clear();
+	for (int i = 0; i < count; i++)
+	{
+		m_scores.push_back(std::make_pair(_get_score(parent, box, values[i]), values[i]));
+	}
+	std::stable_sort(m_scores.begin(), m_scores.end(),
+		[](const std::pair<int, short int> &a, const std::pair<int, short int> &b)
+		{ return a.first < b.first; });
+
+	for (int i = 0; i < count; i++) values[i] = m_scores[i].second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuValueOrder::failed(const CSudokuBoard &nogood)
+{
+	if (m_order != E_SUDOKU_VALUE_ORDER_LEARNED) return;
+
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		if (nogood.get_valor(box) != 0) m_weights[box][nogood.get_valor(box)]--;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CSudokuValueOrder::solved(const CSudokuBoard &solution)
+{
+	if (m_order != E_SUDOKU_VALUE_ORDER_LEARNED) return;
+
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		if (solution.get_valor(box) != 0) m_weights[box][solution.get_valor(box)]++;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int CSudokuValueOrder::_get_score(const CSudokuBoard &parent, int box,
+								short int valor) const
+{
+	if (m_order == E_SUDOKU_VALUE_ORDER_LEARNED) return -m_weights[box][valor];
+
+	// Least constraining: possible values removed from empty peers
+	const CSudokuLayout &layout = parent.get_layout();
+	const unsigned char *peers = layout.get_peers(box);
+	int removed = 0;
+
+	for (unsigned int i = 0; i < layout.get_peer_count(box); i++)
+	{
+		int peer = peers[i];
+		if (parent.get_valor(peer) == 0 && parent.is_possible(peer, valor)) removed++;
+	}
+	return removed;
+}
+
+} // namespace sudoku
@@ -0,0 +1,281 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_worker.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_worker.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ */
+
+#include "sudoku_worker.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+
+namespace sudoku{
+
+static const struct
+{
+	const char *name;
+	E_SUDOKU_STRATEGY strategy;
+} strategies[] =
+{
+	{"rules", E_SUDOKU_STRATEGY_RULES},
+	{"dfs", E_SUDOKU_STRATEGY_DEPTH_FIRST},
+	{"best", E_SUDOKU_STRATEGY_BEST_FIRST},
+	{"beam", E_SUDOKU_STRATEGY_BEAM},
+	{"iddfs", E_SUDOKU_STRATEGY_ITERATIVE_DEEPENING}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+bool get_strategy_by_name(const std::string &name, E_SUDOKU_STRATEGY *strategy)
+{
+	for (const auto &it : strategies)
+	{
+		if (name == it.name)
+		{
+			*strategy = it.strategy;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool get_strategies_by_names(const std::string &names,
+							std::vector<E_SUDOKU_STRATEGY> *strategies)
+{
+	size_t begin = 0;
+
+	strategies->clear();
+	while (begin <= names.size())
+	{
+		size_t end = names.find(',', begin);
+		if (end == std::string::npos) end = names.size();
+
+		E_SUDOKU_STRATEGY strategy;
+		if (!get_strategy_by_name(names.substr(begin, end - begin), &strategy))
+		{
+			return false;
+		}
+		strategies->push_back(strategy);
+		begin = end + 1;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const char *get_strategy_name(E_SUDOKU_STRATEGY strategy)
+{
+	for (const auto &it : strategies)
+	{
+		if (strategy == it.strategy) return it.name;
+	}
+
+	return "unknown";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool get_eviction_by_name(const std::string &name, E_VISITED_EVICTION *eviction)
+{
+	static const struct
+	{
+		const char *name;
+		E_VISITED_EVICTION eviction;
+	} evictions[] =
+	{
+		{"subtree", E_VISITED_EVICTION_SUBTREE},
+		{"lru", E_VISITED_EVICTION_LRU},
+		{"depth", E_VISITED_EVICTION_DEPTH}
+	};
+
+	for (const auto &it : evictions)
+	{
+		if (name == it.name)
+		{
+			*eviction = it.eviction;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool get_branching_by_spec(const std::string &spec, SSearchBranching *branching)
+{
+	SSearchBranching parsed;
+	std::vector<std::string> fields;
+	size_t begin = 0;
+
+	while (begin <= spec.size())
+	{
+		size_t end = spec.find(',', begin);
+		if (end == std::string::npos) end = spec.size();
+		fields.push_back(spec.substr(begin, end - begin));
+		begin = end + 1;
+	}
+	if (fields.size() < 2 || fields.size() > 4) return false;
+
+	// Every field is a whole number, without junk after it
+	unsigned int *counts[] = {&parsed.min_values, &parsed.max_values, &parsed.max_boxes};
+	for (size_t i = 0; i < fields.size(); i++)
+	{
+		const char *text = fields[i].c_str();
+		char *end = nullptr;
+
+		if (fields[i].empty() || !isdigit((unsigned char)text[0])) return false;
+		if (i < 3) *counts[i] = strtoul(text, &end, 10);
+		else parsed.failure_rate = strtod(text, &end);
+		if (*end != '\0') return false;
+	}
+
+	// Box states are 1..9 possible values, max_values is exclusive
+	if (parsed.min_values < 1 || parsed.min_values >= parsed.max_values ||
+		parsed.max_values > E_SUDOKU_BOX_STATES_COUNT ||
+		parsed.max_boxes > E_SUDOKU_BOX_COUNT)
+	{
+		return false;
+	}
+
+	*branching = parsed;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::string get_branching_spec(const SSearchBranching &branching)
+{
+	char spec[64];
+
+	if (branching.is_adaptive())
+	{
+		snprintf(spec, sizeof(spec), "%u,%u,%u,%g", branching.min_values,
+				branching.max_values, branching.max_boxes, branching.failure_rate);
+	}
+	else
+	{
+		snprintf(spec, sizeof(spec), "%u,%u,%u", branching.min_values,
+				branching.max_values, branching.max_boxes);
+	}
+
+	return spec;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool search_with_strategy(CNode<CSudokuBoard> *root,
+						CSearchContext<CSudokuBoard> *context,
+						E_SUDOKU_STRATEGY strategy)
+{
+	bool solved = false;
+
+	// Policy is resolved here once, search loops haven't got virtual calls
+	switch (strategy)
+	{
+		case E_SUDOKU_STRATEGY_DEPTH_FIRST:
+			solved = root->search<CDepthFirstPolicy>(context);
+			break;
+		case E_SUDOKU_STRATEGY_BEST_FIRST:
+			solved = root->search<CBestFirstPolicy>(context);
+			break;
+		case E_SUDOKU_STRATEGY_BEAM:
+			solved = root->search< CBeamPolicy<> >(context);
+			break;
+		case E_SUDOKU_STRATEGY_ITERATIVE_DEEPENING:
+			solved = root->search<CIterativeDeepeningPolicy>(context);
+			break;
+		case E_SUDOKU_STRATEGY_RULES:
+		default:
+			solved = root->search(context);
+			break;
+	}
+
+	if (solved)
+	{
+		context->trace(E_SEARCH_TRACE_SOLUTION,
+						root->get_informacion().get_occupiedBoxCount());
+	}
+	return solved;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool CSudokuWorker::solve(const CSudokuBoard &puzzle, CSudokuBoard &solution,
+						bool keep_visited)
+{
+	bool solved = false;
+
+	if (keep_visited)
+	{
+		m_context.restart();
+	}
+	else
+	{
+		m_context.clear();
+	}
+	m_cancel.reset();
+	if (m_timeout.count() > 0)
+	{
+		m_context.set_deadline(std::chrono::steady_clock::now() + m_timeout);
+	}
+	else
+	{
+		m_context.clear_deadline();
+	}
+	m_root.reset(puzzle);
+	if (m_context.get_trace()) m_context.get_trace()->start();
+
+	solved = search_with_strategy(&m_root, &m_context, m_strategy);
+	if (solved)
+	{
+		solution = m_root.get_informacion();
+		if (m_context.get_children_order()) m_context.get_children_order()->solved(solution);
+	}
+	else if (m_context.get_statistics().is_partial())
+	{
+		solution = m_context.has_best() ? m_context.get_best() : puzzle;
+	}
+
+	return solved;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int CSudokuWorker::solve(const char *puzzle, char *solution)
+{
+	CSudokuBoard board;
+	CSudokuBoard solved_board;
+
+	if (!board.load_from_buffer(puzzle))
+	{
+		memset(solution, '0', E_SUDOKU_BOX_COUNT);
+		return E_SUDOKU_WORKER_INVALID;
+	}
+
+	int result = get_result(this->solve(board, solved_board));
+	if (result == E_SUDOKU_WORKER_UNSOLVABLE)
+	{
+		memset(solution, '0', E_SUDOKU_BOX_COUNT);
+		return result;
+	}
+
+	// Solved or partial board
+	solved_board.save_to_buffer(solution);
+	return result;
+}
+
+} // namespace sudoku
@@ -0,0 +1,190 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test_daemon.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file test_daemon.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * Round trip with a daemon in this process: two pipelined requests (a
+ * solvable board, an unsolvable board and an invalid board) are answered in
+ * order, then stop() makes run() return and the socket is removed. It returns
+ * 1 if any check fails.
+ */
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+#include "sudoku_daemon.hpp"
+
+using namespace sudoku;
+
+// sudoku_test_1.sudoku
+static const char *puzzle =
+	"020006000006028040700000060000080206008307100903040000030000009080650700000400020";
+
+// One value changed in a solved grid, box (3, 1) hasn't got any value
+static const char *unsolvable =
+	"534678912672195348198342567800761423426853790713924856960507284087439605345086109";
+
+// Two 5 in first row
+static const char *invalid =
+	"550000000000000000000000000000000000000000000000000000000000000000000000000000000";
+
+static int failures = 0;
+
+static void check(bool condition, const char *name)
+{
+	if (!condition)
+	{
+		std::cerr << " FAILED: " << name << std::endl;
+		failures++;
+	}
+}
+
+// Solution is valid and it keeps every value of board
+static bool is_solution_of(const std::string &solution, const char *board)
+{
+	if (solution.size() != E_SUDOKU_BOX_COUNT) return false;
+	for (int i = 0; i < E_SUDOKU_BOX_COUNT; i++)
+	{
+		if (solution[i] < '1' || solution[i] > '9') return false;
+		if (board[i] != '0' && board[i] != solution[i]) return false;
+	}
+	for (int unit = 0; unit < E_SUDOKU_DIM; unit++)
+	{
+		bool row[E_SUDOKU_DIM + 1] = {false};
+		bool column[E_SUDOKU_DIM + 1] = {false};
+		bool square[E_SUDOKU_DIM + 1] = {false};
+		for (int i = 0; i < E_SUDOKU_DIM; i++)
+		{
+			int square_box = (unit / 3 * 3 + i / 3) * E_SUDOKU_DIM + unit % 3 * 3 + i % 3;
+			bool *seen[] = {&row[solution[unit * E_SUDOKU_DIM + i] - '0'],
+							&column[solution[i * E_SUDOKU_DIM + unit] - '0'],
+							&square[solution[square_box] - '0']};
+			for (bool *value : seen)
+			{
+				if (*value) return false;
+				*value = true;
+			}
+		}
+	}
+	return true;
+}
+
+static bool write_request(int fd, const std::string &boards)
+{
+	uint32_t length = htonl(boards.size());
+	return write(fd, &length, sizeof(length)) == sizeof(length) &&
+		write(fd, boards.data(), boards.size()) == (ssize_t)boards.size();
+}
+
+static bool read_full(int fd, char *buffer, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t count = read(fd, buffer, size);
+		if (count <= 0) return false;
+		buffer += count;
+		size -= count;
+	}
+	return true;
+}
+
+static std::string read_response(int fd)
+{
+	uint32_t length = 0;
+	if (!read_full(fd, (char *)&length, sizeof(length))) return std::string();
+	std::string response(ntohl(length), '\0');
+	if (!read_full(fd, &response[0], response.size())) return std::string();
+	return response;
+}
+
+// Daemon is listening when run() has been called, so connect is retried
+static int connect_daemon(const std::string &path)
+{
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+	for (int retry = 0; retry < 500; retry++)
+	{
+		int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0) return -1;
+		if (connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0) return fd;
+		close(fd);
+		usleep(10000);
+	}
+	return -1;
+}
+
+int main(void)
+{
+	char directory[] = "/tmp/test_daemon.XXXXXX";
+	if (mkdtemp(directory) == nullptr)
+	{
+		std::cerr << " Error creating temporary directory" << std::endl;
+		return 1;
+	}
+	std::string path = std::string(directory) + "/sudoku.sock";
+
+	CSudokuDaemon daemon(path, 2);
+	int result = -1;
+	std::thread runner([&daemon, &result]() { result = daemon.run(); });
+
+	int fd = connect_daemon(path);
+	check(fd >= 0, "connect");
+	if (fd >= 0)
+	{
+		// Second request is sent before first response is read
+		check(write_request(fd, puzzle), "write first request");
+		check(write_request(fd, std::string(unsolvable) + invalid), "write second request");
+
+		std::string response = read_response(fd);
+		check(response.size() == E_SUDOKU_DAEMON_RESULT_SIZE, "first response length");
+		check(response[0] == '0', "board solved");
+		check(is_solution_of(response.substr(1), puzzle), "valid solution");
+
+		response = read_response(fd);
+		check(response.size() == 2 * E_SUDOKU_DAEMON_RESULT_SIZE, "second response length");
+		check(response[0] == '1', "unsolvable board");
+		check(response[E_SUDOKU_DAEMON_RESULT_SIZE] == '2', "invalid board");
+		close(fd);
+	}
+
+	daemon.stop();
+	runner.join();
+	check(result == 0, "run returns 0 when stopped");
+	check(access(path.c_str(), F_OK) != 0, "socket removed");
+	rmdir(directory);
+
+	if (failures > 0)
+	{
+		std::cerr << failures << " checks failed" << std::endl;
+		return 1;
+	}
+	return 0;
+}
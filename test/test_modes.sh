@@ -0,0 +1,402 @@
+#!/bin/bash
+################################################################################
+## Checks of solver modes, all of them deterministic:
+##   batch writes valid solutions of every board, with one and several workers
+##   memory budgets, search strategies, bounded visited store and timeouts
+##   write valid boards
+##   portfolio solves every board and finds unsolvable boards
+##   lockstep lanes and scalar batch write the same boards
+##   shards solved here or one by one and merged write the same boards
+##   journal resume (complete and truncated journal) writes the same boards,
+##   journals of other board files are refused
+##   value orders write valid boards
+##   solutions of a sparse board are counted and written (-a, -A)
+##   variants (x, windoku, jigsaw and killer) are solved by every strategy
+##   validator finds the corrupted claims, with one and several threads
+##   default branching fan-out is the fixed one
+## Usage: test_modes.sh [sudoku_solver] [data dir]
+## Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+################################################################################
+
+BIN_FILE=${1:-./sudoku_solver}
+DATA_DIR=${2:-./data}
+WORK_DIR=`mktemp -d`
+FAILURES=0
+
+trap "rm -rf ${WORK_DIR}" EXIT
+
+# check name command...: command must succeed
+check()
+{
+	local name=$1
+	shift
+	if "$@"; then
+		echo "ok: "$name
+	else
+		echo "FAILED: "$name
+		FAILURES=$((FAILURES + 1))
+	fi
+}
+
+# Board of 81 characters in sudoku file format
+board_file()
+{
+	echo "$1" | sed 's/./& /g' | fold -w 18 | \
+		sed 's/^\(. . . \)\(. . . \)\(. . .\) *$/\1| \2| \3/' | \
+		sed -e '3a---------------------' -e '6a---------------------'
+}
+
+# check_boards puzzles output [layout]: boards of batch output are checked
+# against their puzzles (givens kept, units without repeated values, sums of
+# complete cages) and counted: "solved N partial N unsolvable N invalid N"
+check_boards()
+{
+	awk -v layout_file="$3" '
+		function add_unit(boxes,   count, list, i)
+		{
+			count = split(boxes, list, " ")
+			for (i = 1; i <= count; i++) unit[units, i] = list[i]
+			unit_size[units] = count
+			unit_sum[units++] = 0
+		}
+		function check_board(number, board, partial,   puzzle, u, i, seen, box, sum, full)
+		{
+			puzzle = substr(puzzles, number * 81 + 1, 81)
+			if (length(puzzle) != 81) return 0
+			if (!partial && index(board, "0")) return 0
+			for (i = 1; i <= 81; i++)
+			{
+				if (substr(puzzle, i, 1) != "0" && substr(puzzle, i, 1) != substr(board, i, 1)) return 0
+			}
+			for (u = 0; u < units; u++)
+			{
+				delete seen
+				sum = 0
+				full = 1
+				for (i = 1; i <= unit_size[u]; i++)
+				{
+					box = substr(board, unit[u, i] + 1, 1)
+					if (box == "0") { full = 0; continue }
+					if (box in seen) return 0
+					seen[box] = 1
+					sum += box
+				}
+				if (unit_sum[u] > 0 && full && sum != unit_sum[u]) return 0
+			}
+			return 1
+		}
+		BEGIN {
+			units = 0
+			regions = ""
+			for (r = 0; r < 9; r++)
+			{
+				row = column = ""
+				for (i = 0; i < 9; i++)
+				{
+					row = row " " (r * 9 + i)
+					column = column " " (i * 9 + r)
+				}
+				add_unit(row)
+				add_unit(column)
+			}
+			while (layout_file != "" && (getline line < layout_file) > 0)
+			{
+				sub(/#.*/, "", line)
+				count = split(line, field, " ")
+				if (count == 0) continue
+				if (field[1] == "diagonals")
+				{
+					diagonal = anti_diagonal = ""
+					for (i = 0; i < 9; i++)
+					{
+						diagonal = diagonal " " (i * 10)
+						anti_diagonal = anti_diagonal " " (i * 8 + 8)
+					}
+					add_unit(diagonal)
+					add_unit(anti_diagonal)
+				}
+				else if (field[1] == "windows")
+				{
+					for (r = 1; r <= 5; r += 4) for (c = 1; c <= 5; c += 4)
+					{
+						window = ""
+						for (i = 0; i < 9; i++) window = window " " ((r + int(i / 3)) * 9 + c + i % 3)
+						add_unit(window)
+					}
+				}
+				else if (field[1] == "regions") regions = field[2]
+				else if (field[1] == "cage")
+				{
+					cage = ""
+					for (i = 3; i <= count; i++) cage = cage " " field[i]
+					add_unit(cage)
+					unit_sum[units - 1] = field[2]
+				}
+			}
+			for (s = 0; s < 9; s++)
+			{
+				square = ""
+				for (i = 0; i < 81; i++)
+				{
+					if (regions != "" && substr(regions, i + 1, 1) == s + 1) square = square " " i
+					if (regions == "" && int(int(i / 9) / 3) * 3 + int(i % 9 / 3) == s) square = square " " i
+				}
+				add_unit(square)
+			}
+		}
+		FILENAME == ARGV[1] { gsub(/[^0-9]/, ""); puzzles = puzzles $0; next }
+		/^ Sudoku board [0-9]+ hasn.t got solution/ { unsolvable++; number++; next }
+		/^ Sudoku board [0-9]+ timed out or gave up/ { partial = 1; next }
+		/^SUDOKU BOARD/ { reading = 1; board = ""; next }
+		reading && /[0-9]/ {
+			gsub(/[^0-9]/, "")
+			board = board $0
+			if (length(board) < 81) next
+			reading = 0
+			if (!check_board(number, board, partial)) invalid++
+			else if (partial) partials++
+			else solved++
+			partial = 0
+			number++
+		}
+		END {
+			if (number * 81 != length(puzzles)) invalid++
+			printf "solved %d partial %d unsolvable %d invalid %d\n", solved, partials, unsolvable, invalid
+		}' "$1" "$2"
+}
+
+#-------------------------------------------------------------------------------
+# Batch of 117 boards: boards of data dir with their values renamed
+BATCH=${WORK_DIR}/batch.txt
+for names in 123456789 234567891 345678912 456789123 567891234 678912345 \
+			789123456 891234567 912345678; do
+	cat ${DATA_DIR}/*.sudoku | tr 123456789 $names >> ${BATCH}
+done
+ALL_SOLVED="solved 117 partial 0 unsolvable 0 invalid 0"
+
+${BIN_FILE} -b ${BATCH} > ${WORK_DIR}/reference.out
+check "batch solves every board" \
+	[ "`check_boards ${BATCH} ${WORK_DIR}/reference.out`" = "${ALL_SOLVED}" ]
+
+${BIN_FILE} -b ${BATCH} -w 4 > ${WORK_DIR}/workers.out
+check "batch with several workers" cmp -s ${WORK_DIR}/reference.out ${WORK_DIR}/workers.out
+
+# Board with one value changed in a solved grid, its box has not any value
+GRID=534678912672195348198342567859761423426853791713924856961537284287419635345286179
+UNSOLVABLE=534678912672195348198342567800761423426853790713924856960507284087439605345086109
+board_file ${UNSOLVABLE} > ${WORK_DIR}/unsolvable.txt
+${BIN_FILE} -b ${WORK_DIR}/unsolvable.txt > ${WORK_DIR}/unsolvable.out
+check "batch finds unsolvable board" \
+	[ "`check_boards ${WORK_DIR}/unsolvable.txt ${WORK_DIR}/unsolvable.out`" = \
+		"solved 0 partial 0 unsolvable 1 invalid 0" ]
+
+#-------------------------------------------------------------------------------
+# Memory budgets: deepest nodes are dropped, searches are still complete
+${BIN_FILE} -b ${BATCH} -m 1 -M 2 > ${WORK_DIR}/budget.out 2> /dev/null
+check "memory budgets" \
+	[ "`check_boards ${BATCH} ${WORK_DIR}/budget.out`" = "${ALL_SOLVED}" ]
+
+#-------------------------------------------------------------------------------
+# Strategies: complete strategies solve every board, beam can give up with a
+# partial board
+for strategy in rules dfs best iddfs; do
+	${BIN_FILE} -b ${BATCH} -s $strategy > ${WORK_DIR}/strategy.out 2> /dev/null
+	check "strategy $strategy" \
+		[ "`check_boards ${BATCH} ${WORK_DIR}/strategy.out`" = "${ALL_SOLVED}" ]
+done
+
+${BIN_FILE} -b ${BATCH} -s beam > ${WORK_DIR}/strategy.out 2> /dev/null
+check "strategy beam" \
+	grep -q "unsolvable 0 invalid 0$" <(check_boards ${BATCH} ${WORK_DIR}/strategy.out)
+
+#-------------------------------------------------------------------------------
+# Bounded visited store, every eviction policy
+for policy in subtree lru depth; do
+	${BIN_FILE} -b ${BATCH} -s dfs -c 8 -e $policy > ${WORK_DIR}/evict.out 2> /dev/null
+	check "visited store evicted by $policy" \
+		[ "`check_boards ${BATCH} ${WORK_DIR}/evict.out`" = "${ALL_SOLVED}" ]
+done
+
+#-------------------------------------------------------------------------------
+# Lockstep lanes
+${BIN_FILE} -b ${BATCH} -S > ${WORK_DIR}/scalar.out
+check "lockstep and scalar batch" cmp -s ${WORK_DIR}/reference.out ${WORK_DIR}/scalar.out
+
+#-------------------------------------------------------------------------------
+# Timeout: boards are solved or timed out with a valid partial board, never
+# unsolvable
+for strategy in rules dfs best; do
+	${BIN_FILE} -b ${BATCH} -s $strategy -t 1 > ${WORK_DIR}/timeout.out 2> /dev/null
+	check "timeout with strategy $strategy" \
+		grep -q "unsolvable 0 invalid 0$" <(check_boards ${BATCH} ${WORK_DIR}/timeout.out)
+done
+
+#-------------------------------------------------------------------------------
+# Portfolio: every board is solved, and a complete search which fails ends the
+# race even if other searches can't prove it (beam gives up)
+${BIN_FILE} -b ${BATCH} -w 1 -P rules,dfs,best > ${WORK_DIR}/portfolio.out 2> /dev/null
+check "portfolio" \
+	[ "`check_boards ${BATCH} ${WORK_DIR}/portfolio.out`" = "${ALL_SOLVED}" ]
+
+for strategies in rules,beam beam,dfs; do
+	${BIN_FILE} -b ${WORK_DIR}/unsolvable.txt -P $strategies > ${WORK_DIR}/portfolio.out 2> /dev/null
+	check "portfolio $strategies finds unsolvable board" \
+		grep -q "hasn't got solution" ${WORK_DIR}/portfolio.out
+done
+
+#-------------------------------------------------------------------------------
+# Shards
+${BIN_FILE} -b ${BATCH} -n 3 > ${WORK_DIR}/shards.out 2> /dev/null
+check "range shards" cmp -s ${WORK_DIR}/reference.out ${WORK_DIR}/shards.out
+
+${BIN_FILE} -b ${BATCH} -n 3 -p hash > ${WORK_DIR}/shards.out 2> /dev/null
+check "hash shards" cmp -s ${WORK_DIR}/reference.out ${WORK_DIR}/shards.out
+
+for shard in 0 1 2; do
+	${BIN_FILE} -b ${BATCH} -n 3 -k $shard -g ${WORK_DIR}/shard > /dev/null 2>&1
+done
+${BIN_FILE} -b ${BATCH} -n 3 -J -g ${WORK_DIR}/shard > ${WORK_DIR}/shards.out
+check "shards merged later" cmp -s ${WORK_DIR}/reference.out ${WORK_DIR}/shards.out
+
+#-------------------------------------------------------------------------------
+# Journal: a second run writes boards from journal, a truncated journal (crash
+# in the middle of a block) is resumed after its last whole block, and a
+# journal of other board file (same size) is refused
+JOURNAL=${WORK_DIR}/batch.journal
+${BIN_FILE} -b ${BATCH} -j ${JOURNAL} > ${WORK_DIR}/journal.out
+check "batch with journal" cmp -s ${WORK_DIR}/reference.out ${WORK_DIR}/journal.out
+
+${BIN_FILE} -b ${BATCH} -j ${JOURNAL} > ${WORK_DIR}/resume.out 2> /dev/null
+check "resume complete journal" cmp -s ${WORK_DIR}/reference.out ${WORK_DIR}/resume.out
+
+tr 12 21 < ${BATCH} > ${WORK_DIR}/other.txt
+${BIN_FILE} -b ${WORK_DIR}/other.txt -j ${JOURNAL} > /dev/null 2>&1
+check "journal of other board file is refused" [ $? -ne 0 ]
+
+truncate -s $((`stat -c %s ${JOURNAL}` / 2 + 7)) ${JOURNAL}
+${BIN_FILE} -b ${BATCH} -j ${JOURNAL} > ${WORK_DIR}/resume.out 2> /dev/null
+check "resume truncated journal" cmp -s ${WORK_DIR}/reference.out ${WORK_DIR}/resume.out
+
+# Torn block whose count is bigger than the file
+printf '\377\377\377\377\377\377\377' >> ${JOURNAL}
+${BIN_FILE} -b ${BATCH} -j ${JOURNAL} > ${WORK_DIR}/resume.out 2> /dev/null
+check "resume journal with torn block count" \
+	cmp -s ${WORK_DIR}/reference.out ${WORK_DIR}/resume.out
+
+#-------------------------------------------------------------------------------
+# Value orders
+for order in numeric lcv random learned; do
+	${BIN_FILE} -b ${BATCH} -s dfs -v $order > ${WORK_DIR}/order.out 2> /dev/null
+	check "value order $order" \
+		[ "`check_boards ${BATCH} ${WORK_DIR}/order.out`" = "${ALL_SOLVED}" ]
+done
+
+#-------------------------------------------------------------------------------
+# Solutions: columns 1, 2, 4 and 5 of a complete grid are emptied, it has 704
+# solutions (counted by brute force)
+SPARSE=004008912002005348008002567009001423006003791003004856001007284007009635005006179
+board_file ${SPARSE} > ${WORK_DIR}/sparse.sudoku
+
+${BIN_FILE} -f ${WORK_DIR}/sparse.sudoku -a 0 2> ${WORK_DIR}/count.txt
+check "count solutions" grep -q "^ 704 solutions" ${WORK_DIR}/count.txt
+
+${BIN_FILE} -f ${WORK_DIR}/sparse.sudoku -a 100 2> ${WORK_DIR}/count.txt
+check "count solutions with limit" grep -q "^ 100 solutions" ${WORK_DIR}/count.txt
+
+${BIN_FILE} -f ${WORK_DIR}/sparse.sudoku -A 0 > ${WORK_DIR}/solutions.txt 2> /dev/null
+check "write different solutions" \
+	[ `sort -u ${WORK_DIR}/solutions.txt | wc -l` -eq 704 ]
+
+#-------------------------------------------------------------------------------
+# Variants: a board with a third of the values of a solution, for every layout
+# and strategy (beam can give up). Solutions of x and windoku are solved from
+# the empty board
+EMPTY=`printf '%081d' 0`
+echo diagonals > ${WORK_DIR}/x.layout
+echo windows > ${WORK_DIR}/windoku.layout
+# Jigsaw: regions are broken diagonals, value of box (r, c) is (2r + c) % 9 + 1
+awk 'BEGIN {
+	printf "regions "
+	for (i = 0; i < 81; i++) printf "%d", (int(i / 9) + i % 9) % 9 + 1
+	printf "\n" }' > ${WORK_DIR}/jigsaw.layout
+JIGSAW=`awk 'BEGIN { for (i = 0; i < 81; i++) printf "%d", (2 * int(i / 9) + i % 9) % 9 + 1 }'`
+# Killer: cages of two boxes in every row, with the sums of a solved grid
+awk -v grid=${GRID} 'BEGIN {
+	for (i = 0; i < 81; i += 2) if (i % 9 < 8)
+		print "cage", substr(grid, i + 1, 1) + substr(grid, i + 2, 1), i, i + 1 }' \
+	> ${WORK_DIR}/killer.layout
+
+# Third of the values of a solution
+third()
+{
+	echo "$1" | awk '{ for (i = 1; i <= 81; i++) printf "%s", (i % 3 ? 0 : substr($0, i, 1)) }'
+}
+
+for layout in x windoku jigsaw killer; do
+	LAYOUT_FILE=${WORK_DIR}/${layout}.layout
+	case $layout in
+		x|windoku)
+			board_file ${EMPTY} > ${WORK_DIR}/empty.txt
+			${BIN_FILE} -b ${WORK_DIR}/empty.txt -L $layout > ${WORK_DIR}/variant.out
+			SOLUTION=`grep "^[0-9]" ${WORK_DIR}/variant.out | tr -cd 0-9`
+			check "variant $layout, empty board" [ ${#SOLUTION} -eq 81 ];;
+		jigsaw) SOLUTION=${JIGSAW};;
+		killer) SOLUTION=${GRID};;
+	esac
+	VARIANT=${WORK_DIR}/${layout}.txt
+	board_file `third ${SOLUTION}` > ${VARIANT}
+	for strategy in rules dfs best iddfs beam; do
+		${BIN_FILE} -b ${VARIANT} -s $strategy -L ${LAYOUT_FILE} > ${WORK_DIR}/variant.out 2> /dev/null
+		RESULT=`check_boards ${VARIANT} ${WORK_DIR}/variant.out ${LAYOUT_FILE}`
+		if [ $strategy = beam ]; then
+			check "variant $layout, strategy $strategy" \
+				grep -q "unsolvable 0 invalid 0$" <(echo ${RESULT})
+		else
+			check "variant $layout, strategy $strategy" \
+				[ "${RESULT}" = "solved 1 partial 0 unsolvable 0 invalid 0" ]
+		fi
+	done
+done
+
+board_file ${EMPTY} > ${WORK_DIR}/empty.sudoku
+${BIN_FILE} -f ${WORK_DIR}/empty.sudoku -a 10 -L x > /dev/null 2> ${WORK_DIR}/count.txt
+check "count solutions only with classic layout" \
+	grep -q "supports only the classic layout" ${WORK_DIR}/count.txt
+
+#-------------------------------------------------------------------------------
+# Validator: solutions written by -A are valid. Claims 7, 107, ... have one box
+# changed, and claims 3, 153, ... are valid puzzle and solution pairs, but
+# claims 50 and 600 have a puzzle with other value in one box
+VALIDATOR=${WORK_DIR}/validator.out
+${BIN_FILE} -V ${WORK_DIR}/solutions.txt > ${VALIDATOR} 2> /dev/null
+check "valid solutions" [ ! -s ${VALIDATOR} ]
+
+OTHER_PUZZLE=${SPARSE:0:80}8
+awk -v puzzle=${SPARSE} -v other=${OTHER_PUZZLE} '
+	NR % 100 == 7 { $0 = substr($0, 1, 40) (substr($0, 41, 1) % 9 + 1) substr($0, 42) }
+	NR % 150 == 3 { $0 = puzzle " " $0 }
+	NR == 50 || NR == 600 { $0 = other " " $0 }
+	{ print }' ${WORK_DIR}/solutions.txt > ${WORK_DIR}/claims.txt
+printf "7\n50\n107\n207\n307\n407\n507\n600\n607\n" > ${WORK_DIR}/invalid.txt
+
+for workers in 1 4; do
+	${BIN_FILE} -V ${WORK_DIR}/claims.txt -w $workers > ${VALIDATOR} 2> /dev/null
+	check "invalid claims, $workers threads" cmp -s ${VALIDATOR} ${WORK_DIR}/invalid.txt
+done
+
+#-------------------------------------------------------------------------------
+# Branching fan-out: default is the fixed fan-out of 2 to 8 values, the same
+# search (and statistics) without failure rate
+${BIN_FILE} -f ${DATA_DIR}/sudoku_test_9.sudoku -s dfs > ${WORK_DIR}/fanout.out 2>&1
+for branching in 2,8 2,8,0,0; do
+	${BIN_FILE} -f ${DATA_DIR}/sudoku_test_9.sudoku -s dfs -B $branching \
+		> ${WORK_DIR}/branching.out 2>&1
+	check "default fan-out is $branching" cmp -s ${WORK_DIR}/fanout.out ${WORK_DIR}/branching.out
+done
+
+if [ $FAILURES -gt 0 ]; then
+	echo $FAILURES" checks failed"
+	exit 1
+fi
+
+exit 0
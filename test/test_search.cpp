@@ -0,0 +1,118 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test_search.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file test_search.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * Searches of every strategy cancelled after a number of expansions: search
+ * tree is freed when they return (live nodes and tree bytes are 0, only the
+ * visited store is kept). Cancel is done by children order, so it's always in
+ * the same point of the search. It returns 1 if any check fails.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "sudoku_worker.hpp"
+
+using namespace sudoku;
+
+// sudoku_test_extreme.sudoku, every strategy orders values more than 30 times
+static const char *extreme =
+	"100000000000000050000020000000000000000000000000000000040030000000000000000000000";
+
+static const char *strategy_names[] = {"rules", "dfs", "best", "beam", "iddfs"};
+
+static int failures = 0;
+
+static void check(bool condition, const std::string &name)
+{
+	if (!condition)
+	{
+		std::cerr << " FAILED: " << name << std::endl;
+		failures++;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Numeric order, search is cancelled when values of a box have been ordered
+ * a number of times
+ */
+class CCancelOrder: public CChildrenOrder<CSudokuBoard>
+{
+	public:
+
+		CCancelOrder(CCancelToken *cancel, long count): m_cancel(cancel), m_count(count)
+		{
+		}
+
+		virtual void order(const CSudokuBoard &parent, int box, short int *values, int count)
+		{
+			if (--m_count == 0) m_cancel->cancel();
+		}
+
+	private:
+
+		CCancelToken *m_cancel;
+
+		long m_count;
+};
+
+int main(void)
+{
+	CSudokuBoard puzzle;
+	if (!puzzle.load_from_buffer(extreme))
+	{
+		std::cerr << " Error loading board" << std::endl;
+		return 1;
+	}
+
+	for (int strategy = 0; strategy < E_SUDOKU_STRATEGY_COUNT; strategy++)
+	{
+		for (long count : {1, 5, 30})
+		{
+			CSearchContext<CSudokuBoard> context(E_SUDOKU_BOX_COUNT - 1, nullptr);
+			CCancelToken cancel;
+			CCancelOrder order(&cancel, count);
+			CNode<CSudokuBoard> root;
+			context.set_cancel_token(&cancel);
+			context.set_children_order(&order);
+			root.reset(puzzle);
+
+			std::ostringstream name;
+			name << strategy_names[strategy] << ", cancelled after " << count << " orders";
+			bool solved = search_with_strategy(&root, &context, (E_SUDOKU_STRATEGY)strategy);
+			const SSearchStatistics &statistics = context.get_statistics();
+			check(!solved && statistics.stopped, name.str() + ": stopped");
+			check(statistics.live_nodes == 0, name.str() + ": live nodes");
+			check(statistics.tree_bytes == 0, name.str() + ": tree bytes");
+			check(statistics.live_bytes() == statistics.visited_bytes,
+				name.str() + ": live bytes are visited store");
+		}
+	}
+
+	if (failures > 0)
+	{
+		std::cerr << failures << " checks failed" << std::endl;
+		return 1;
+	}
+	return 0;
+}
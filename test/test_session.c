@@ -0,0 +1,128 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test_session.c
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file test_session.c
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * Edits of an incremental session (sudoku_session_*) with the C API: values
+ * consistent with last solution, values which need a new search, boxes
+ * emptied and set again, unsolvable and invalid edits. It returns 1 if any
+ * check fails.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sudoku.h"
+
+static const char *grid =
+	"534678912672195348198342567859761423426853791713924856961537284287419635345286179";
+
+static int failures = 0;
+
+static void check(int condition, const char *name)
+{
+	if (!condition)
+	{
+		fprintf(stderr, " FAILED: %s\n", name);
+		failures++;
+	}
+}
+
+/* Solution is complete, it keeps every value of board and every row, column
+ * and square has every value */
+static int is_solution_of(const char *solution, const char *board)
+{
+	int i, j, box;
+
+	for (i = 0; i < SUDOKU_BOARD_SIZE; i++)
+	{
+		if (solution[i] < '1' || solution[i] > '9') return 0;
+		if (board[i] != '0' && board[i] != solution[i]) return 0;
+	}
+	for (i = 0; i < 9; i++)
+	{
+		int row = 0, column = 0, square = 0;
+
+		for (j = 0; j < 9; j++)
+		{
+			box = (i / 3 * 3 + j / 3) * 9 + i % 3 * 3 + j % 3;
+			row |= 1 << (solution[i * 9 + j] - '0');
+			column |= 1 << (solution[j * 9 + i] - '0');
+			square |= 1 << (solution[box] - '0');
+		}
+		if (row != 0x3fe || column != 0x3fe || square != 0x3fe) return 0;
+	}
+	return 1;
+}
+
+int main(void)
+{
+	sudoku_session *session = sudoku_session_new();
+	char board[SUDOKU_BOARD_SIZE];
+	char solution[SUDOKU_BOARD_SIZE];
+	int result;
+
+	if (!session) return 1;
+
+	/* Full grid, then four boxes are emptied: 7 and 6 in rows 0 and 3 can
+	 * be swapped, there are two solutions */
+	memcpy(board, grid, SUDOKU_BOARD_SIZE);
+	result = sudoku_session_load(session, board, solution);
+	check(result == SUDOKU_SOLVED && memcmp(solution, grid, SUDOKU_BOARD_SIZE) == 0,
+			"load complete grid");
+
+	check(sudoku_session_set(session, 0, 3, 0, solution) == SUDOKU_SOLVED, "empty (0,3)");
+	check(sudoku_session_set(session, 0, 4, 0, solution) == SUDOKU_SOLVED, "empty (0,4)");
+	check(sudoku_session_set(session, 3, 3, 0, solution) == SUDOKU_SOLVED, "empty (3,3)");
+	check(sudoku_session_set(session, 3, 4, 0, solution) == SUDOKU_SOLVED, "empty (3,4)");
+	board[3] = board[4] = board[30] = board[31] = '0';
+	check(is_solution_of(solution, board), "solution of emptied grid");
+
+	/* Other value than last solution, a new search is needed */
+	result = sudoku_session_set(session, 0, 3, 7, solution);
+	board[3] = '7';
+	check(result == SUDOKU_SOLVED, "set (0,3)=7 after emptying boxes");
+	check(is_solution_of(solution, board) && memcmp(solution, "534768912", 9) == 0,
+			"solution with (0,3)=7");
+
+	/* Value consistent with last solution */
+	result = sudoku_session_set(session, 0, 4, 6, solution);
+	board[4] = '6';
+	check(result == SUDOKU_SOLVED && is_solution_of(solution, board), "set (0,4)=6");
+
+	/* Value which breaks rules, board isn't changed */
+	result = sudoku_session_set(session, 3, 3, 7, solution);
+	check(result == SUDOKU_INVALID, "set (3,3)=7 repeated in column");
+	check(sudoku_session_set(session, 9, 0, 1, solution) == SUDOKU_INVALID, "row out of range");
+
+	/* Value which follows rules without solution, and removed again */
+	memcpy(board, grid, SUDOKU_BOARD_SIZE);
+	board[28] = board[29] = board[44] = board[56] = board[58] = '0';
+	board[63] = board[67] = board[70] = board[75] = board[79] = '0';
+	check(sudoku_session_load(session, board, solution) == SUDOKU_SOLVED, "load 10 empty boxes");
+	check(sudoku_session_set(session, 7, 4, 3, solution) == SUDOKU_UNSOLVABLE, "set (7,4)=3");
+	result = sudoku_session_set(session, 7, 4, 0, solution);
+	check(result == SUDOKU_SOLVED && is_solution_of(solution, board), "empty (7,4) again");
+
+	sudoku_session_free(session);
+
+	if (failures == 0) printf(" Session tests passed\n");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,471 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_bench.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_bench.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * Microbenchmarks of CSudokuBoard primitives, time by call of every primitive
+ * with boards of data/ (or board files in command line):
+ *
+ *   sudoku_bench [-r 15] [-w 3] [-m 10] [-o now.csv] [-c baseline.csv]
+ *				[-t 5] [-n name] [board files]
+ *
+ * Every benchmark is calibrated to run at least -m milliseconds by sample,
+ * -w samples are discarded (warm-up) and -r samples are measured. Median,
+ * min and median absolute deviation (% of median) are written, and exported
+ * in CSV (-o). With a baseline (-c) every median is compared with it, and it
+ * returns 1 if the min of any benchmark is more than -t % slower than its
+ * baseline median.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include <getopt.h>
+
+#include "sudoku_solver.hpp"
+#include "sudoku_worker.hpp"
+
+#ifndef SUDOKU_DATA_DIR
+#define SUDOKU_DATA_DIR "data"
+#endif
+
+using namespace sudoku;
+
+// Results are added here, so calls aren't removed by the compiler
+static volatile long sink = 0;
+
+/**
+ * @brief Run iterations of a benchmark
+ * @return nanoseconds of measured code
+ */
+typedef std::function<double(long iterations)> bench_function;
+
+////////////////////////////////////////////////////////////////////////////////
+struct SBenchOptions
+{
+	unsigned int repetitions;
+	unsigned int warmup;
+	double sample_ns;		/**< Min time of a sample */
+	std::string filter;		/**< Only benchmarks with it in name */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+struct SBenchResult
+{
+	std::string name;
+	double median;			/**< ns by call */
+	double min;
+	double mad;				/**< % of median */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+static double median(std::vector<double> values)
+{
+	std::sort(values.begin(), values.end());
+	size_t n = values.size();
+	return (n % 2) ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Time of every iteration of body, the whole loop is measured
+ */
+template <class Body>
+static bench_function timed(Body body)
+{
+	return [body](long iterations) mutable
+	{
+		auto begin = std::chrono::steady_clock::now();
+		for (long i = 0; i < iterations; i++) body();
+		auto end = std::chrono::steady_clock::now();
+		return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+	};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @param name
+ * @param calls calls of primitive by iteration
+ * @param function
+ * @param options
+ * @param results
+ */
+static void run(const std::string &name, long calls, bench_function function,
+				const SBenchOptions &options, std::vector<SBenchResult> *results)
+{
+	if (name.find(options.filter) == std::string::npos) return;
+
+	// Calibration, it's warm-up too
+	long iterations = 1;
+	while (function(iterations) < options.sample_ns && iterations < (1L << 30))
+	{
+		iterations *= 2;
+	}
+
+	for (unsigned int i = 0; i < options.warmup; i++) function(iterations);
+
+	std::vector<double> samples;
+	for (unsigned int i = 0; i < options.repetitions; i++)
+	{
+		samples.push_back(function(iterations) / (iterations * calls));
+	}
+
+	SBenchResult result;
+	result.name = name;
+	result.median = median(samples);
+	result.min = *std::min_element(samples.begin(), samples.end());
+
+	std::vector<double> deviations;
+	for (double sample : samples) deviations.push_back(std::fabs(sample - result.median));
+	result.mad = median(deviations) * 100.0 / result.median;
+
+	results->push_back(result);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Benchmarks of every primitive with a board
+ * @param tag name of board in benchmark names
+ * @param text board file contents (see operator>>)
+ */
+static bool bench_board(const std::string &tag, const std::string &text,
+						const SBenchOptions &options, std::vector<SBenchResult> *results)
+{
+	CSudokuBoard board;
+	std::istringstream input(text);
+
+	if (!(input >> board))
+	{
+		std::cerr << " Invalid sudoku board: " << tag << std::endl;
+		return false;
+	}
+
+	CSudokuWorker worker;
+	CSudokuBoard solution;
+	if (!worker.solve(board, solution))
+	{
+		std::cerr << " Sudoku board hasn't got solution: " << tag << std::endl;
+		return false;
+	}
+
+	std::vector<int> empty;
+	int toggle_box = -1;
+	short int toggle[2] = {0, 0};
+	for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+	{
+		if (board.get_valor(box) != 0) continue;
+
+		empty.push_back(box);
+		for (short int valor = 1; valor <= E_SUDOKU_DIM && toggle_box < 0; valor++)
+		{
+			if (!board.is_possible(box, valor)) continue;
+			if (toggle[0] == 0)
+			{
+				toggle[0] = valor;
+			}
+			else
+			{
+				toggle[1] = valor;
+				toggle_box = box;
+			}
+		}
+		if (toggle_box < 0) toggle[0] = 0;
+	}
+
+	// setValorByXY: values of solution set in every empty box (0 to [1-9])
+	// and removed in reverse order ([1-9] to 0), each phase measured alone
+	if (!empty.empty())
+	{
+		CSudokuBoard work = board;
+		double phase_ns[2] = {0, 0};
+		auto fill_clear = [&](long iterations, int phase)
+		{
+			phase_ns[0] = phase_ns[1] = 0;
+			for (long i = 0; i < iterations; i++)
+			{
+				auto t0 = std::chrono::steady_clock::now();
+				for (int box : empty)
+				{
+					sink += work.setValorByXY(solution.get_valor(box),
+											box / E_SUDOKU_DIM, box % E_SUDOKU_DIM);
+				}
+				auto t1 = std::chrono::steady_clock::now();
+				for (auto it = empty.rbegin(); it != empty.rend(); ++it)
+				{
+					sink += work.setValorByXY(0, *it / E_SUDOKU_DIM, *it % E_SUDOKU_DIM);
+				}
+				auto t2 = std::chrono::steady_clock::now();
+				phase_ns[0] += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+				phase_ns[1] += std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count();
+			}
+			return phase_ns[phase];
+		};
+
+		run("set_empty_to_value/" + tag, empty.size(),
+			[&](long iterations) { return fill_clear(iterations, 0); }, options, results);
+		run("set_value_to_empty/" + tag, empty.size(),
+			[&](long iterations) { return fill_clear(iterations, 1); }, options, results);
+	}
+
+	// setValorByXY: value changed in a box with two possible values ([1-9] to [1-9])
+	if (toggle_box >= 0)
+	{
+		CSudokuBoard work = board;
+		short int x = toggle_box / E_SUDOKU_DIM;
+		short int y = toggle_box % E_SUDOKU_DIM;
+
+		work.setValorByXY(toggle[0], x, y);
+		run("set_value_to_value/" + tag, 2, timed([&]()
+			{
+				sink += work.setValorByXY(toggle[1], x, y);
+				sink += work.setValorByXY(toggle[0], x, y);
+			}), options, results);
+	}
+
+	run("rulesCheck/" + tag, E_SUDOKU_BOX_COUNT * E_SUDOKU_DIM, timed([&]()
+		{
+			for (int box = 0; box < E_SUDOKU_BOX_COUNT; box++)
+			{
+				for (int valor = 1; valor <= E_SUDOKU_DIM; valor++)
+				{
+					sink += board.rulesCheck(valor, box / E_SUDOKU_DIM, box % E_SUDOKU_DIM);
+				}
+			}
+		}), options, results);
+
+	CSudokuBoard complete = board;
+	run("_update_complete/" + tag, 1, timed([&]()
+		{
+			complete.bench_update_complete();
+			sink += complete.is_complete(0);
+		}), options, results);
+
+	run("operator>>/" + tag, 1, timed([&]()
+		{
+			CSudokuBoard read;
+			input.clear();
+			input.seekg(0);
+			input >> read;
+			sink += read.get_occupiedBoxCount();
+		}), options, results);
+
+	std::ostringstream output;
+	run("operator<</" + tag, 1, timed([&]()
+		{
+			output.seekp(0);
+			output << board;
+			sink += output.tellp();
+		}), options, results);
+
+	// Worst case: equal boards, or first board in second one, every box is compared
+	CSudokuBoard copy = board;
+	run("diferentes/" + tag, 1, timed([&]() { sink += diferentes(board, copy); }),
+		options, results);
+	run("diferentes2/" + tag, 1, timed([&]() { sink += diferentes2(board, solution); }),
+		options, results);
+
+	// One expansion of board, visited store doesn't change after the first one
+	CSearchContext<CSudokuBoard> context(E_SUDOKU_BOX_COUNT - 1, nullptr);
+	std::vector<CSudokuBoard> children;
+	run("generateChildrens/" + tag, 1, timed([&]()
+		{
+			children.clear();
+			board.generateChildrens(&children, &context);
+			sink += children.size();
+		}), options, results);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Read results in CSV format, lines starting with # are comments
+ * @param file_name
+ * @param results median by name
+ */
+static bool read_results(const char *file_name, std::map<std::string, double> *results)
+{
+	std::ifstream file(file_name);
+	std::string line;
+
+	if (!file.is_open()) return false;
+
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#') continue;
+
+		size_t comma = line.find(',');
+		if (comma == std::string::npos) return false;
+		(*results)[line.substr(0, comma)] = atof(line.c_str() + comma + 1);
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static bool write_results(const char *file_name, const std::vector<SBenchResult> &results)
+{
+	std::ofstream file(file_name);
+
+	file << "# name,median_ns,min_ns,mad_percent" << std::endl;
+	for (const auto &result : results)
+	{
+		file << result.name << "," << result.median << "," << result.min << ","
+				<< result.mad << std::endl;
+	}
+
+	return !file.fail();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static void usage(void)
+{
+	std::cerr << " Usage: sudoku_bench [-r repetitions] [-w warm-up] [-m sample ms]"
+			" [-o results.csv] [-c baseline.csv] [-t threshold %] [-n name]"
+			" [board files]" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+	SBenchOptions options = {15, 3, 10e6, ""};
+	char* output_file_name = nullptr;
+	char* baseline_file_name = nullptr;
+	double threshold = 5.0;
+	int c = 0;
+
+	opterr = 0;
+	while ((c = getopt (argc, argv, "r:w:m:o:c:t:n:")) != -1)
+	{
+		switch (c)
+		{
+			case 'r':
+				options.repetitions = std::max(1, atoi(optarg));
+				break;
+			case 'w':
+				options.warmup = atoi(optarg);
+				break;
+			case 'm':
+				options.sample_ns = atof(optarg) * 1e6;
+				break;
+			case 'o':
+				output_file_name = optarg;
+				break;
+			case 'c':
+				baseline_file_name = optarg;
+				break;
+			case 't':
+				threshold = atof(optarg);
+				break;
+			case 'n':
+				options.filter = optarg;
+				break;
+			default:
+				usage();
+				return 1;
+		}
+	}
+
+	std::vector<std::string> files;
+	for (int i = optind; i < argc; i++) files.push_back(argv[i]);
+	if (files.empty())
+	{
+		files.push_back(SUDOKU_DATA_DIR "/sudoku_test_1.sudoku");
+		files.push_back(SUDOKU_DATA_DIR "/sudoku_test_9.sudoku");
+		files.push_back(SUDOKU_DATA_DIR "/sudoku_test_extreme.sudoku");
+	}
+
+	std::map<std::string, double> baseline;
+	if (baseline_file_name && !read_results(baseline_file_name, &baseline))
+	{
+		std::cerr << " Error reading baseline: " << baseline_file_name << std::endl;
+		return -1;
+	}
+
+	std::vector<SBenchResult> results;
+	for (const auto &file_name : files)
+	{
+		std::ifstream file(file_name);
+		std::stringstream text;
+
+		if (!file.is_open())
+		{
+			std::cerr << " Error opening sudoku board: " << file_name << std::endl;
+			return -1;
+		}
+		text << file.rdbuf();
+
+		// Board name without directory and extension
+		std::string tag = file_name.substr(file_name.find_last_of('/') + 1);
+		tag = tag.substr(0, tag.find('.'));
+
+		if (!bench_board(tag, text.str(), options, &results)) return -1;
+	}
+
+	bool regression = false;
+	std::cout << std::left << std::setw(44) << " Benchmark" << std::right
+			<< std::setw(12) << "median ns" << std::setw(12) << "min ns"
+			<< std::setw(8) << "mad %";
+	if (baseline_file_name) std::cout << std::setw(12) << "baseline" << std::setw(10) << "change %";
+	std::cout << std::endl << std::fixed;
+
+	for (const auto &result : results)
+	{
+		std::cout << " " << std::left << std::setw(43) << result.name << std::right
+				<< std::setprecision(2) << std::setw(12) << result.median
+				<< std::setw(12) << result.min << std::setprecision(1)
+				<< std::setw(8) << result.mad;
+
+		auto previous = baseline.find(result.name);
+		if (previous != baseline.end() && previous->second > 0)
+		{
+			double change = (result.median - previous->second) * 100.0 / previous->second;
+			std::cout << std::setprecision(2) << std::setw(12) << previous->second
+					<< std::setprecision(1) << std::setw(10) << std::showpos << change
+					<< std::noshowpos;
+			// Even the fastest sample is slower, not only noise in median
+			if (result.min > previous->second * (1.0 + threshold / 100.0))
+			{
+				std::cout << " slower";
+				regression = true;
+			}
+		}
+		std::cout << std::endl;
+	}
+
+	if (output_file_name && !write_results(output_file_name, results))
+	{
+		std::cerr << " Error writing results: " << output_file_name << std::endl;
+		return -1;
+	}
+
+	return regression ? 1 : 0;
+}
@@ -0,0 +1,283 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_trace.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_trace.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * Summary of a search trace written by sudoku_solver -T (see CSearchTrace):
+ * events by type and by depth, and the failed subtrees where the search
+ * spent more expansions. Subtrees are rebuilt from the order of expansions,
+ * so they are exact for depth-first strategies (rules, dfs and iddfs).
+ *
+ *   sudoku_trace [-n top] board.trace
+ *   sudoku_trace -c board.trace > board.json     (Chrome trace format)
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+#include <getopt.h>
+
+#include "csearch_trace.hpp"
+#include "sudoku_solver.hpp"
+
+using namespace sudoku;
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Subtree of a node: its events and the events of its descendants
+ */
+struct SSubtree
+{
+	int depth;
+	int box;
+	int value;
+	uint64_t begin;
+	uint64_t end;
+	long counts[E_SEARCH_TRACE_EVENT_COUNT];
+	bool solved;		/**< Solution was found inside */
+	bool is_root;		/**< First expansion of trace */
+	std::string decisions;	/**< Path from root */
+	std::vector<SSubtree> failed_children;	/**< Maximal failed subtrees */
+
+	SSubtree(): depth(-1), box(-1), value(0), begin(0), end(0), counts{},
+		solved(false), is_root(false)
+	{
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Rebuild subtrees from expansion order. An expansion closes every
+ * open node which isn't less deep, then the remaining top is its parent.
+ * Failed subtrees are kept only if their parent found the solution (or it's
+ * the root), the others are inside a bigger failed subtree
+ */
+class CTraceTree
+{
+	public:
+
+		CTraceTree(): m_open(1), m_time(0) {}
+
+		void add(const SSearchTraceEvent &event)
+		{
+			m_time = event.time;
+			if (event.type == E_SEARCH_TRACE_EXPAND)
+			{
+				while (m_open.size() > 1 && m_open.back().depth >= event.depth) _close();
+
+				const SSubtree &parent = m_open.back();
+				SSubtree node;
+
+				node.depth = event.depth;
+				node.box = event.box;
+				node.value = event.value;
+				node.begin = event.time;
+				node.is_root = (m_open.size() == 1 && parent.failed_children.empty() &&
+								!parent.solved);
+				node.decisions = parent.decisions;
+
+				// Nodes of safe rules keep the decision of their parent
+				if (node.box >= 0 && (node.box != parent.box || node.value != parent.value))
+				{
+					std::ostringstream decision;
+					decision << " r" << node.box / E_SUDOKU_DIM + 1 << "c"
+							<< node.box % E_SUDOKU_DIM + 1 << "=" << node.value;
+					node.decisions += decision.str();
+				}
+				m_open.push_back(std::move(node));
+			}
+			else if (event.type == E_SEARCH_TRACE_SOLUTION)
+			{
+				for (auto &open : m_open) open.solved = true;
+			}
+
+			if (event.type < E_SEARCH_TRACE_EVENT_COUNT) m_open.back().counts[event.type]++;
+		}
+
+		/**
+		 * @brief Close every open node
+		 * @return maximal failed subtrees
+		 */
+		std::vector<SSubtree> finish(void)
+		{
+			while (m_open.size() > 1) _close();
+			return std::move(m_open.back().failed_children);
+		}
+
+	private:
+
+		void _close(void)
+		{
+			SSubtree node = std::move(m_open.back());
+			m_open.pop_back();
+
+			SSubtree &parent = m_open.back();
+			node.end = m_time;
+			for (int i = 0; i < E_SEARCH_TRACE_EVENT_COUNT; i++) parent.counts[i] += node.counts[i];
+
+			if (node.solved || node.is_root)
+			{
+				for (auto &child : node.failed_children)
+				{
+					parent.failed_children.push_back(std::move(child));
+				}
+			}
+			if (!node.solved)
+			{
+				node.failed_children.clear();
+				if (!node.is_root) parent.failed_children.push_back(std::move(node));
+			}
+		}
+
+		std::vector<SSubtree> m_open;
+
+		uint64_t m_time;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+static void write_summary(const std::vector<SSearchTraceEvent> &events,
+						uint64_t recorded, unsigned int top)
+{
+	long counts[E_SEARCH_TRACE_EVENT_COUNT] = {0};
+	std::vector< std::vector<long> > by_depth;
+	CTraceTree tree;
+
+	for (const auto &event : events)
+	{
+		if (event.type >= E_SEARCH_TRACE_EVENT_COUNT) continue;
+
+		counts[event.type]++;
+		if (event.depth >= by_depth.size())
+		{
+			by_depth.resize(event.depth + 1, std::vector<long>(E_SEARCH_TRACE_EVENT_COUNT));
+		}
+		by_depth[event.depth][event.type]++;
+		tree.add(event);
+	}
+
+	double span = events.empty() ? 0.0 : (events.back().time - events.front().time) / 1e6;
+	std::cout << " Trace: " << recorded << " events recorded, " << events.size()
+			<< " kept, " << span << " ms" << std::endl;
+	if (recorded > events.size())
+	{
+		std::cout << " Oldest events were overwritten, first subtrees are partial"
+				<< std::endl;
+	}
+
+	std::cout << " Events:";
+	for (int i = 0; i < E_SEARCH_TRACE_EVENT_COUNT; i++)
+	{
+		std::cout << (i ? ", " : " ") << CSearchTrace::get_event_name(i) << " "
+				<< counts[i];
+	}
+	std::cout << std::endl << std::endl;
+
+	// Nogood depth is its size, it isn't in the table
+	std::cout << " Depth  Expand  Probable  Visited hit  Dead end" << std::endl;
+	for (unsigned int depth = 0; depth < by_depth.size(); depth++)
+	{
+		const std::vector<long> &row = by_depth[depth];
+		if (row[E_SEARCH_TRACE_EXPAND] == 0 && row[E_SEARCH_TRACE_PROBABLE_CHILD] == 0)
+		{
+			continue;
+		}
+		std::cout << std::setw(6) << depth << std::setw(8) << row[E_SEARCH_TRACE_EXPAND]
+				<< std::setw(10) << row[E_SEARCH_TRACE_PROBABLE_CHILD]
+				<< std::setw(13) << row[E_SEARCH_TRACE_VISITED_HIT]
+				<< std::setw(10) << row[E_SEARCH_TRACE_DEAD_END] << std::endl;
+	}
+
+	std::vector<SSubtree> failed = tree.finish();
+	std::sort(failed.begin(), failed.end(), [](const SSubtree &a, const SSubtree &b)
+		{ return a.counts[E_SEARCH_TRACE_EXPAND] > b.counts[E_SEARCH_TRACE_EXPAND]; });
+	if (failed.size() > top) failed.resize(top);
+
+	std::cout << std::endl << " Hot failed subtrees" << std::endl
+			<< "  Expand  Dead end  Visited hit        ms  Depth  Decisions"
+			<< std::endl;
+	for (const auto &subtree : failed)
+	{
+		std::cout << std::setw(8) << subtree.counts[E_SEARCH_TRACE_EXPAND]
+				<< std::setw(10) << subtree.counts[E_SEARCH_TRACE_DEAD_END]
+				<< std::setw(13) << subtree.counts[E_SEARCH_TRACE_VISITED_HIT]
+				<< std::setw(10) << std::fixed << std::setprecision(3)
+				<< (subtree.end - subtree.begin) / 1e6 << std::setw(7) << subtree.depth
+				<< " " << subtree.decisions << std::endl;
+		std::cout.unsetf(std::ios::floatfield);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+	bool chrome = false;
+	unsigned int top = 10;
+	int c = 0;
+
+	opterr = 0;
+	while ((c = getopt (argc, argv, "cn:")) != -1)
+	{
+		switch (c)
+		{
+			case 'c':
+				chrome = true;
+				break;
+			case 'n':
+				top = atoi(optarg);
+				break;
+			default:
+				std::cerr << " Usage: sudoku_trace [-c] [-n top] file.trace" << std::endl;
+				return 1;
+		}
+	}
+
+	if (optind >= argc)
+	{
+		std::cerr << " Usage: sudoku_trace [-c] [-n top] file.trace" << std::endl;
+		return 1;
+	}
+
+	std::ifstream file(argv[optind], std::ios::binary);
+	std::vector<SSearchTraceEvent> events;
+	uint64_t recorded = 0;
+
+	if (!file.is_open() || !CSearchTrace::read(file, &events, &recorded))
+	{
+		std::cerr << " Error reading search trace: " << argv[optind] << std::endl;
+		return -1;
+	}
+
+	if (chrome)
+	{
+		CSearchTrace::write_chrome(std::cout, events);
+	}
+	else
+	{
+		write_summary(events, recorded, top);
+	}
+
+	return 0;
+}
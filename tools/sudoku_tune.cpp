@@ -0,0 +1,283 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * sudoku_tune.cpp
+ * Copyright (C) 2008, 2013 Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * sudoku_solver is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * sudoku_solver is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sudoku_tune.cpp
+ * @author Juan Maria Gomez Lopez <juanecitorr@gmail.com>
+ *
+ * Offline tuning of branching fan-out (see SSearchBranching). Every board of
+ * a corpus is solved with every branching of a grid, one worker in one
+ * thread:
+ *
+ *   sudoku_tune [-s rules] [-t 0] [-r 1] [-o sweep.csv] [-B spec]... corpus
+ *
+ * Default grid is max values 3, 4, 6, 8 and 10, max boxes 1, 2, 4 and all,
+ * and adaptive failure rate off, 0.1 and 0.3 (min values is always 2). Specs
+ * given with -B (min,max[,boxes[,failure rate]]) replace it. Throughput
+ * (boards by second, best of -r runs), max peak bytes of one board search,
+ * expanded nodes and unsolved boards are written for every branching, and the
+ * Pareto front (no other branching is faster and uses less memory) is marked
+ * with '*'. Branchings with more unsolved (timed out) boards than the best
+ * one aren't in front.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include <getopt.h>
+
+#include "sudoku_solver.hpp"
+#include "sudoku_worker.hpp"
+
+using namespace sudoku;
+
+////////////////////////////////////////////////////////////////////////////////
+struct STuneResult
+{
+	SSearchBranching branching;
+	double boards_by_second;	/**< Best of all runs */
+	long peak_bytes;			/**< Max of any board search */
+	long expanded_nodes;		/**< All boards */
+	long unsolved;				/**< Unsolvable or timed out boards */
+	bool pareto;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Solve every board of corpus with a branching
+ * @param corpus
+ * @param options worker options, with branching of result
+ * @param runs corpus is solved runs times, best time is kept
+ * @param result
+ */
+static void sweep(const std::vector<CSudokuBoard> &corpus,
+				const SSudokuWorkerOptions &options, unsigned int runs,
+				STuneResult *result)
+{
+	CSudokuWorker worker(options);
+	CSudokuBoard solution;
+	double best_seconds = 0;
+
+	for (unsigned int run = 0; run < runs; run++)
+	{
+		result->peak_bytes = 0;
+		result->expanded_nodes = 0;
+		result->unsolved = 0;
+
+		auto begin = std::chrono::steady_clock::now();
+		for (const auto &puzzle : corpus)
+		{
+			if (!worker.solve(puzzle, solution)) result->unsolved++;
+
+			const SSearchStatistics &statistics = worker.get_statistics();
+			result->expanded_nodes += statistics.expanded_nodes;
+			result->peak_bytes = std::max(result->peak_bytes, statistics.peak_bytes);
+		}
+		double seconds = std::chrono::duration<double>(
+							std::chrono::steady_clock::now() - begin).count();
+
+		if (run == 0 || seconds < best_seconds) best_seconds = seconds;
+	}
+
+	result->boards_by_second = (best_seconds > 0) ? corpus.size() / best_seconds : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Mark results which aren't dominated: other result with the same
+ * or less unsolved boards, throughput and memory at least as good and one
+ * of them better
+ */
+static void mark_pareto_front(std::vector<STuneResult> *results)
+{
+	long min_unsolved = -1;
+
+	for (const auto &result : *results)
+	{
+		if (min_unsolved < 0 || result.unsolved < min_unsolved) min_unsolved = result.unsolved;
+	}
+
+	for (auto &result : *results)
+	{
+		result.pareto = (result.unsolved == min_unsolved);
+		for (const auto &other : *results)
+		{
+			if (!result.pareto) break;
+			if (other.unsolved > min_unsolved) continue;
+
+			if (other.boards_by_second >= result.boards_by_second &&
+				other.peak_bytes <= result.peak_bytes &&
+				(other.boards_by_second > result.boards_by_second ||
+				other.peak_bytes < result.peak_bytes))
+			{
+				result.pareto = false;
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static bool write_results(const char *file_name, const std::vector<STuneResult> &results)
+{
+	std::ofstream file(file_name);
+
+	file << "# branching,boards_by_second,peak_bytes,expanded_nodes,unsolved,pareto"
+			<< std::endl;
+	for (const auto &result : results)
+	{
+		file << "\"" << get_branching_spec(result.branching) << "\","
+				<< result.boards_by_second << "," << result.peak_bytes << ","
+				<< result.expanded_nodes << "," << result.unsolved << ","
+				<< (result.pareto ? 1 : 0) << std::endl;
+	}
+
+	return !file.fail();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static void usage(void)
+{
+	std::cerr << " Usage: sudoku_tune [-s strategy] [-t timeout ms] [-r runs]"
+			" [-o results.csv] [-B branching]... corpus" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+	SSudokuWorkerOptions options;
+	std::vector<SSearchBranching> grid;
+	SSearchBranching branching;
+	char* output_file_name = nullptr;
+	unsigned int runs = 1;
+	int c = 0;
+
+	opterr = 0;
+	while ((c = getopt (argc, argv, "s:t:r:o:B:")) != -1)
+	{
+		switch (c)
+		{
+			case 's':
+				if (!get_strategy_by_name(optarg, &options.strategy))
+				{
+					std::cerr << " Unknown strategy: " << optarg << std::endl;
+					return 1;
+				}
+				break;
+			case 't':
+				options.timeout = strtoul(optarg, nullptr, 10);
+				break;
+			case 'r':
+				runs = std::max(1, atoi(optarg));
+				break;
+			case 'o':
+				output_file_name = optarg;
+				break;
+			case 'B':
+				if (!get_branching_by_spec(optarg, &branching))
+				{
+					std::cerr << " Bad branching: " << optarg << std::endl;
+					return 1;
+				}
+				grid.push_back(branching);
+				break;
+			default:
+				usage();
+				return 1;
+		}
+	}
+
+	if (optind != argc - 1)
+	{
+		usage();
+		return 1;
+	}
+
+	if (grid.empty())
+	{
+		for (double failure_rate : {0.0, 0.1, 0.3})
+		{
+			for (unsigned int max_boxes : {1, 2, 4, 0})
+			{
+				for (unsigned int max_values : {3, 4, 6, 8, 10})
+				{
+					branching.max_values = max_values;
+					branching.max_boxes = max_boxes;
+					branching.failure_rate = failure_rate;
+					grid.push_back(branching);
+				}
+			}
+		}
+	}
+
+	std::ifstream file(argv[optind]);
+	if (!file.is_open())
+	{
+		std::cerr << " Error opening corpus: " << argv[optind] << std::endl;
+		return -1;
+	}
+
+	std::vector<CSudokuBoard> corpus;
+	while (file >> std::ws, !file.eof())
+	{
+		CSudokuBoard board;
+
+		file >> board;
+		if (file.fail())
+		{
+			std::cerr << " Error getting sudoku board " << corpus.size()
+					<< " from corpus" << std::endl;
+			return -1;
+		}
+		corpus.push_back(board);
+	}
+
+	std::vector<STuneResult> results(grid.size());
+	for (size_t i = 0; i < grid.size(); i++)
+	{
+		options.branching = grid[i];
+		results[i].branching = grid[i];
+		sweep(corpus, options, runs, &results[i]);
+	}
+	mark_pareto_front(&results);
+
+	std::cout << std::left << std::setw(20) << " Branching" << std::right
+			<< std::setw(12) << "boards/s" << std::setw(14) << "peak bytes"
+			<< std::setw(14) << "expanded" << std::setw(10) << "unsolved"
+			<< std::endl << std::fixed;
+	for (const auto &result : results)
+	{
+		std::cout << " " << std::left << std::setw(19) << get_branching_spec(result.branching)
+				<< std::right << std::setprecision(1) << std::setw(12)
+				<< result.boards_by_second << std::setw(14) << result.peak_bytes
+				<< std::setw(14) << result.expanded_nodes << std::setw(10)
+				<< result.unsolved << (result.pareto ? " *" : "") << std::endl;
+	}
+
+	if (output_file_name && !write_results(output_file_name, results))
+	{
+		std::cerr << " Error writing results: " << output_file_name << std::endl;
+		return -1;
+	}
+
+	return 0;
+}